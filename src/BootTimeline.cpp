@@ -0,0 +1,87 @@
+#include "BootTimeline.h"
+
+// Названия этапов для отчета (порядок как в Phase)
+static const char* const PHASE_NAMES[BootTimeline::PHASE_COUNT] = {
+    "motor_safe", "inputs", "sensor_probe", "setup_done",
+    "first_tick", "first_cmd", "sensor_online", "host"
+};
+
+/**
+ * Конструктор класса BootTimeline
+ */
+BootTimeline::BootTimeline() : setup_entry_us(0) {
+    for (uint8_t i = 0; i < PHASE_COUNT; i++) {
+        marks_us[i] = 0;
+        reached[i] = false;
+    }
+}
+
+/**
+ * Отметить вход в setup() (вызывать первой строкой setup)
+ */
+void BootTimeline::begin() {
+    setup_entry_us = micros();
+}
+
+/**
+ * Отметить этап (повторные отметки игнорируются)
+ * @param phase - этап
+ */
+void BootTimeline::mark(Phase phase) {
+    if (phase < PHASE_COUNT && !reached[phase]) {
+        marks_us[phase] = micros();
+        reached[phase] = true;
+    }
+}
+
+/**
+ * Проверить, наступил ли этап
+ * @param phase - этап
+ * @return true если этап отмечен
+ */
+bool BootTimeline::isReached(Phase phase) const {
+    return phase < PHASE_COUNT && reached[phase];
+}
+
+/**
+ * Получить время этапа
+ * @param phase - этап
+ * @return мкс от сброса (0 если этап не наступил)
+ */
+uint32_t BootTimeline::getTime_us(Phase phase) const {
+    return isReached(phase) ? marks_us[phase] : 0;
+}
+
+/**
+ * Вывести отчет в Serial
+ */
+void BootTimeline::printReport() const {
+    Serial.print("Boot: setup entry at "); Serial.print(setup_entry_us);
+    Serial.println(" us");
+    for (uint8_t i = 0; i < PHASE_COUNT; i++) {
+        Serial.print("  "); Serial.print(PHASE_NAMES[i]); Serial.print(": ");
+        if (reached[i]) {
+            Serial.print(marks_us[i]); Serial.println(" us");
+        } else {
+            Serial.println("-");
+        }
+    }
+
+    // Безопасное управляемое состояние - первый такт управления
+    uint32_t ready_us = getTime_us(PHASE_FIRST_TICK);
+    Serial.print("Ready in "); Serial.print(ready_us / 1000.0f, 2);
+    Serial.print(" ms, budget "); Serial.print(BOOT_BUDGET_MS);
+    Serial.println((reached[PHASE_FIRST_TICK] && ready_us <= BOOT_BUDGET_MS * 1000UL) ? " ms: OK" : " ms: EXCEEDED");
+
+    // Машиночитаемая строка для сравнения между версиями
+    Serial.print("BOOT build=\"" __DATE__ " " __TIME__ "\"");
+    for (uint8_t i = 0; i < PHASE_COUNT; i++) {
+        Serial.print(" "); Serial.print(PHASE_NAMES[i]); Serial.print("=");
+        if (reached[i]) {
+            Serial.print(marks_us[i]);
+        } else {
+            Serial.print("-");
+        }
+    }
+    Serial.println();
+}
@@ -0,0 +1,72 @@
+#ifndef BOOT_TIMELINE_H
+#define BOOT_TIMELINE_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+/**
+ * Отметки времени этапов загрузки (мкс от сброса)
+ *
+ * Каждый этап отмечается один раз - при первом наступлении. Безопасное
+ * состояние (двигатель остановлен) и первый такт управления не ждут ни USB,
+ * ни датчика тока; датчик и хост отмечаются, когда появляются.
+ * Строка "BOOT ..." в отчете предназначена для сравнения между версиями.
+ */
+class BootTimeline {
+public:
+    // Этапы загрузки
+    enum Phase : uint8_t {
+        PHASE_MOTOR_SAFE = 0,    // Пины двигателя в безопасном состоянии
+        PHASE_INPUTS,            // Вход RC и энкодер настроены
+        PHASE_SENSOR_PROBE,      // Первая попытка найти датчик тока
+        PHASE_SETUP_DONE,        // setup() завершен
+        PHASE_FIRST_TICK,        // Первый такт управления
+        PHASE_FIRST_COMMAND,     // Первая команда (импульс RC или Serial)
+        PHASE_SENSOR_ONLINE,     // Датчик тока работает
+        PHASE_HOST_ATTACHED,     // Хост открыл порт USB
+        PHASE_COUNT
+    };
+
+private:
+    uint32_t setup_entry_us;           // Вход в setup()
+    uint32_t marks_us[PHASE_COUNT];    // Время этапов
+    bool reached[PHASE_COUNT];         // Этап наступил
+
+public:
+    /**
+     * Конструктор
+     */
+    BootTimeline();
+
+    /**
+     * Отметить вход в setup() (вызывать первой строкой setup)
+     */
+    void begin();
+
+    /**
+     * Отметить этап (повторные отметки игнорируются)
+     * @param phase - этап
+     */
+    void mark(Phase phase);
+
+    /**
+     * Проверить, наступил ли этап
+     * @param phase - этап
+     * @return true если этап отмечен
+     */
+    bool isReached(Phase phase) const;
+
+    /**
+     * Получить время этапа
+     * @param phase - этап
+     * @return мкс от сброса (0 если этап не наступил)
+     */
+    uint32_t getTime_us(Phase phase) const;
+
+    /**
+     * Вывести отчет в Serial
+     */
+    void printReport() const;
+};
+
+#endif // BOOT_TIMELINE_H
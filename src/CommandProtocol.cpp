@@ -0,0 +1,167 @@
+#include "CommandProtocol.h"
+#include "Config.h"
+
+/**
+ * Конструктор класса CommandProtocol
+ */
+CommandProtocol::CommandProtocol()
+    : state(WAIT_SYNC), frame{0, 0, 0, {0}}, payload_index(0), crc(0), received_crc(0),
+      last_byte_time(0), frames_ok(0), frames_bad_crc(0), frames_aborted(0) {
+}
+
+/**
+ * Обновить CRC-16/CCITT-FALSE одним байтом
+ * @param crc - текущее значение CRC
+ * @param data - очередной байт
+ * @return новое значение CRC
+ */
+uint16_t CommandProtocol::crcUpdate(uint16_t crc, uint8_t data) {
+    crc ^= static_cast<uint16_t>(data) << 8;
+    for (uint8_t i = 0; i < 8; i++) {
+        crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x1021) : static_cast<uint16_t>(crc << 1);
+    }
+    return crc;
+}
+
+/**
+ * Обработать принятый байт
+ * @param data - байт из последовательного порта
+ * @param current_time - текущее время в мс
+ * @return true если собран корректный кадр (доступен через getFrame())
+ */
+bool CommandProtocol::processByte(uint8_t data, unsigned long current_time) {
+    checkTimeout(current_time);
+    last_byte_time = current_time;
+
+    switch (state) {
+        case WAIT_SYNC:
+            if (data == SYNC) {
+                crc = 0xFFFF;
+                state = WAIT_LENGTH;
+            }
+            break;
+
+        case WAIT_LENGTH:
+            if (data > MAX_PAYLOAD) {
+                frames_aborted++;
+                state = (data == SYNC) ? WAIT_LENGTH : WAIT_SYNC;
+                break;
+            }
+            frame.length = data;
+            crc = crcUpdate(crc, data);
+            state = WAIT_SEQ;
+            break;
+
+        case WAIT_SEQ:
+            frame.seq = data;
+            crc = crcUpdate(crc, data);
+            state = WAIT_CMD;
+            break;
+
+        case WAIT_CMD:
+            frame.cmd = data;
+            crc = crcUpdate(crc, data);
+            payload_index = 0;
+            state = (frame.length > 0) ? WAIT_PAYLOAD : WAIT_CRC_LOW;
+            break;
+
+        case WAIT_PAYLOAD:
+            frame.payload[payload_index++] = data;
+            crc = crcUpdate(crc, data);
+            if (payload_index >= frame.length) {
+                state = WAIT_CRC_LOW;
+            }
+            break;
+
+        case WAIT_CRC_LOW:
+            received_crc = data;
+            state = WAIT_CRC_HIGH;
+            break;
+
+        case WAIT_CRC_HIGH:
+            received_crc |= static_cast<uint16_t>(data) << 8;
+            state = WAIT_SYNC;
+            if (received_crc == crc) {
+                frames_ok++;
+                return true;
+            }
+            frames_bad_crc++;
+            break;
+    }
+
+    return false;
+}
+
+/**
+ * Сбросить оборванный кадр: пауза после последнего байта больше допустимой
+ * @param current_time - текущее время в мс
+ */
+void CommandProtocol::checkTimeout(unsigned long current_time) {
+    if (state != WAIT_SYNC && current_time - last_byte_time > COMMAND_FRAME_TIMEOUT_MS) {
+        frames_aborted++;
+        state = WAIT_SYNC;
+    }
+}
+
+/**
+ * Проверить, идет ли прием кадра
+ * @return true если парсер не в ожидании синхробайта
+ */
+bool CommandProtocol::isReceiving() const {
+    return state != WAIT_SYNC;
+}
+
+/**
+ * Получить последний собранный кадр
+ * @return ссылка на кадр
+ */
+const CommandProtocol::Frame& CommandProtocol::getFrame() const {
+    return frame;
+}
+
+/**
+ * Отправить ответ на кадр
+ * @param seq - номер последовательности запроса
+ * @param cmd - код команды запроса
+ * @param status - статус выполнения
+ * @param data - дополнительные данные ответа (может быть nullptr)
+ * @param length - длина дополнительных данных
+ */
+void CommandProtocol::sendResponse(uint8_t seq, uint8_t cmd, Status status, const uint8_t* data, uint8_t length) {
+    if (length > MAX_PAYLOAD - 1) {
+        length = MAX_PAYLOAD - 1;
+    }
+
+    uint8_t buffer[MAX_PAYLOAD + 6];
+    uint8_t size = 0;
+    buffer[size++] = SYNC;
+    buffer[size++] = length + 1;
+    buffer[size++] = seq;
+    buffer[size++] = cmd | RESPONSE_FLAG;
+    buffer[size++] = status;
+    for (uint8_t i = 0; i < length; i++) {
+        buffer[size++] = data[i];
+    }
+
+    uint16_t response_crc = 0xFFFF;
+    for (uint8_t i = 1; i < size; i++) {
+        response_crc = crcUpdate(response_crc, buffer[i]);
+    }
+    buffer[size++] = response_crc & 0xFF;
+    buffer[size++] = response_crc >> 8;
+
+    // Кадр целиком одной записью, чтобы не разрывался текстовым выводом
+    Serial.write(buffer, size);
+}
+
+/**
+ * Получить статистику приема
+ * @param ok - корректные кадры
+ * @param bad_crc - кадры с неверной CRC
+ * @param aborted - оборванные кадры
+ */
+void CommandProtocol::getStats(uint32_t& ok, uint32_t& bad_crc, uint32_t& aborted) const {
+    ok = frames_ok;
+    bad_crc = frames_bad_crc;
+    aborted = frames_aborted;
+}
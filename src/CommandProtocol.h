@@ -0,0 +1,140 @@
+#ifndef COMMAND_PROTOCOL_H
+#define COMMAND_PROTOCOL_H
+
+#include <Arduino.h>
+
+/**
+ * Двоичный протокол команд поверх USB CDC Serial
+ *
+ * Формат кадра (и запроса, и ответа):
+ *   [0]      SYNC = 0xA5
+ *   [1]      LEN  - длина полезной нагрузки (0..MAX_PAYLOAD)
+ *   [2]      SEQ  - номер последовательности (ответ повторяет номер запроса)
+ *   [3]      CMD  - код команды (в ответе CMD | RESPONSE_FLAG)
+ *   [4..]    полезная нагрузка, многобайтовые поля little-endian
+ *   [+0..1]  CRC-16/CCITT-FALSE (0x1021, начальное 0xFFFF) по байтам LEN..нагрузка, LE
+ *
+ * Первый байт нагрузки ответа - статус (STATUS_*).
+ * Разбор побайтовый, без динамической памяти; кадр с неверной CRC
+ * отбрасывается и учитывается в статистике.
+ */
+class CommandProtocol {
+public:
+    // Константы кадра
+    static constexpr uint8_t SYNC = 0xA5;
+    static constexpr uint8_t MAX_PAYLOAD = 32;
+    static constexpr uint8_t RESPONSE_FLAG = 0x80;
+
+    // Коды команд
+    enum Command : uint8_t {
+        CMD_PING = 0x01,              // Пульс связи, ответ без данных
+        CMD_SET_SPEED = 0x02,         // int16 скорость -255..255
+        CMD_SET_GRIP_CURRENT = 0x03,  // uint16 порог защиты, мА
+        CMD_STOP = 0x04,              // Остановка двигателя
+        CMD_QUERY = 0x05,             // Запрос состояния
+        CMD_RELEASE = 0x06,           // Вернуть управление RC каналу
+        CMD_QUERY_ENERGY = 0x07,      // uint8 раздел: 0 - итоги, 1 - закрытие, 2 - открытие
+        CMD_SET_POSITION = 0x08       // uint16 положение губок 0 (открыт) .. 1000 (закрыт)
+    };
+
+    // Статусы ответа
+    enum Status : uint8_t {
+        STATUS_OK = 0,
+        STATUS_BAD_LENGTH = 1,        // Неверная длина нагрузки для команды
+        STATUS_BAD_VALUE = 2,         // Значение вне допустимого диапазона
+        STATUS_UNKNOWN_COMMAND = 3,   // Неизвестный код команды
+        STATUS_REJECTED = 4           // Команда отклонена (например, активна защита)
+    };
+
+    // Принятый кадр
+    struct Frame {
+        uint8_t seq;
+        uint8_t cmd;
+        uint8_t length;
+        uint8_t payload[MAX_PAYLOAD];
+    };
+
+private:
+    // Состояния разбора
+    enum ParseState : uint8_t {
+        WAIT_SYNC,
+        WAIT_LENGTH,
+        WAIT_SEQ,
+        WAIT_CMD,
+        WAIT_PAYLOAD,
+        WAIT_CRC_LOW,
+        WAIT_CRC_HIGH
+    };
+
+    // Поля класса
+    ParseState state;             // Текущее состояние разбора
+    Frame frame;                  // Собираемый кадр
+    uint8_t payload_index;        // Принято байт нагрузки
+    uint16_t crc;                 // CRC, вычисляемая по ходу приема
+    uint16_t received_crc;        // Принятая CRC
+    unsigned long last_byte_time; // Время последнего байта (для сброса оборванного кадра)
+    uint32_t frames_ok;           // Принято корректных кадров
+    uint32_t frames_bad_crc;      // Отброшено кадров с неверной CRC
+    uint32_t frames_aborted;      // Оборванных кадров (таймаут, длина)
+
+public:
+    /**
+     * Добавить байт к CRC-16/CCITT-FALSE (также для блока настроек во flash)
+     * @param crc - текущее значение (начальное 0xFFFF)
+     * @param data - байт
+     * @return новое значение CRC
+     */
+    static uint16_t crcUpdate(uint16_t crc, uint8_t data);
+
+    /**
+     * Конструктор
+     */
+    CommandProtocol();
+
+    /**
+     * Обработать принятый байт
+     * @param data - байт из последовательного порта
+     * @param current_time - текущее время в мс
+     * @return true если собран корректный кадр (доступен через getFrame())
+     */
+    bool processByte(uint8_t data, unsigned long current_time);
+
+    /**
+     * Сбросить оборванный кадр (вызывать перед isReceiving(), чтобы байт после
+     * паузы не попал в протокол, а ушел текстовым командам)
+     * @param current_time - текущее время в мс
+     */
+    void checkTimeout(unsigned long current_time);
+
+    /**
+     * Проверить, идет ли прием кадра (следующие байты принадлежат протоколу)
+     * @return true если парсер не в ожидании синхробайта
+     */
+    bool isReceiving() const;
+
+    /**
+     * Получить последний собранный кадр
+     * @return ссылка на кадр
+     */
+    const Frame& getFrame() const;
+
+    /**
+     * Отправить ответ на кадр
+     * @param seq - номер последовательности запроса
+     * @param cmd - код команды запроса
+     * @param status - статус выполнения
+     * @param data - дополнительные данные ответа (может быть nullptr)
+     * @param length - длина дополнительных данных
+     */
+    void sendResponse(uint8_t seq, uint8_t cmd, Status status, const uint8_t* data, uint8_t length);
+
+    /**
+     * Получить статистику приема
+     * @param ok - корректные кадры
+     * @param bad_crc - кадры с неверной CRC
+     * @param aborted - оборванные кадры
+     */
+    void getStats(uint32_t& ok, uint32_t& bad_crc, uint32_t& aborted) const;
+};
+
+#endif // COMMAND_PROTOCOL_H
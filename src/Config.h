@@ -1,6 +1,10 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
+// Мертвая зона, порог защиты, задержка после пуска, плавный разгон, таймаут связи
+// и интервал диагностики - значения по умолчанию для RuntimeConfig: сохраненные
+// командой "cfg save" настройки во flash имеют приоритет
+
 // Пины для измерения импульсов и тока
 #define PULSE_INPUT_PIN PA2
 #define I2C_SDA_PIN PB7
@@ -10,6 +14,15 @@
 #define MOTOR_IA_PIN PA0
 #define MOTOR_IB_PIN PA1
 
+// Те же пины в виде PinName для вариантов с доступом к регистрам (PulseMeterFast, MotorDriverFast)
+#define PULSE_INPUT_PINNAME PA_2
+#define MOTOR_IA_PINNAME PA_0
+#define MOTOR_IB_PINNAME PA_1
+
+// Прямой доступ к регистрам GPIO/таймера с пинами, заданными при компиляции
+// false - классы PulseMeter/MotorDriver с номерами пинов во время работы
+#define FAST_PIN_ACCESS_ENABLED true
+
 // Диапазон PWM сигнала
 #define PWM_MIN_US 900
 #define PWM_MAX_US 2400
@@ -35,8 +48,17 @@
 // Интервал измерения тока (мс)
 #define CURRENT_MEASUREMENT_INTERVAL 50
 
-// Мертвая зона для тока (мА)
-#define CURRENT_DEADZONE_MA 0.5
+// Интервал повторного поиска INA219, если он не ответил при загрузке (мс)
+#define CURRENT_SENSOR_RETRY_MS 500
+
+// Быстрый фильтр тока (для защиты): скользящее среднее, количество точек
+#define CURRENT_FAST_FILTER_TAPS 3
+
+// Медленный фильтр тока (для телеметрии): биквад Баттерворта, частота среза (Гц)
+#define CURRENT_SLOW_FILTER_CUTOFF_HZ 1.0
+
+// Гистерезис медленного (телеметрического) значения тока (мА)
+#define CURRENT_HYSTERESIS_MA 0.5
 
 // Количество образцов для калибровки холостого тока
 #define IDLE_CURRENT_SAMPLES 20
@@ -44,9 +66,73 @@
 // Интервал между сэмплами холостого тока (мс)
 #define IDLE_CURRENT_SAMPLE_INTERVAL_MS 100
 
+// Пауза после остановки двигателя до сбора сэмплов холостого тока (мс)
+#define IDLE_CURRENT_SETTLE_MS 300
+
+// Коэффициент отслеживания дрейфа смещения (доля нового сэмпла, постоянная времени ~5 с)
+#define IDLE_DRIFT_ALPHA 0.02f
+
+// Максимальное отклонение сэмпла от смещения при отслеживании дрейфа (мА)
+#define IDLE_DRIFT_MAX_DEVIATION_MA 2.0f
+
+// Отброшенных подряд сэмплов до повторной калибровки (скачок смещения)
+#define IDLE_DRIFT_RESTART_SAMPLES 100
+
+// Максимальное СКО сэмплов, при котором калибровка принимается (мА)
+#define IDLE_CALIBRATION_MAX_SIGMA_MA 1.0f
+
+// Предельное смещение нуля тока (мА)
+#define IDLE_OFFSET_LIMIT_MA 5.0f
+
 // Порог защиты от перегрузки (мА)
 #define CURRENT_PROTECTION_THRESHOLD_MA 10
 
+// Направление закрытия захвата для учета энергии (1 - вперед, -1 - назад)
+#define GRIPPER_CLOSE_DIRECTION 1
+
+// Оценка положения губок по коммутационным пульсациям тока (JawPosition)
+// false - пока не проверено на двигателе: при вращении шунт читается ~4 кГц (I2C 400 кГц,
+// быстрый АЦП INA219, без сна между тактами), мягкие упоры снижают скорость по оценке положения
+#define RIPPLE_COUNTING_ENABLED false
+#define RIPPLE_SAMPLE_INTERVAL_US 250        // Интервал чтения шунта при работе двигателя (4 кГц)
+#define RIPPLE_MAX_GAP_US 1000               // Пропуск сэмплов, восполняемый по модели
+#define RIPPLE_BASELINE_SHIFT 5              // Постоянная времени постоянной составляющей: 2^N сэмплов
+#define RIPPLE_AMPLITUDE_SHIFT 6             // Постоянная времени амплитуды: 2^N сэмплов
+#define RIPPLE_THRESHOLD_Q7 64               // Порог триггера Шмитта в 1/128 амплитуды
+#define RIPPLE_MIN_AMPLITUDE_RAW 4           // Минимальная амплитуда пульсаций (отсчеты шунта по 10 мкВ, один шаг АЦП 10 бит)
+#define RIPPLE_NOLOAD_RATE_HZ 800            // Начальная оценка пульсаций/с при полном заполнении без нагрузки
+#define RIPPLE_PLAUSIBLE_MIN_PERCENT 50      // Допустимое отношение счета к модели за такт, нижняя граница
+#define RIPPLE_PLAUSIBLE_MAX_PERCENT 200     // Допустимое отношение счета к модели за такт, верхняя граница
+#define RIPPLE_LEARN_MIN_SPEED_Q8 64         // Уточнять модель при скорости не ниже 1/4 холостого хода
+#define RIPPLE_LEARN_SHIFT 4                 // Постоянная времени уточнения модели: 2^N тактов
+#define JAW_TRAVEL_RIPPLES 6000              // Полный ход губок в пульсациях
+#define JAW_STALL_CURRENT_MA 20              // Ток упора при полном заполнении (мА)
+#define JAW_REHOME_WINDOW_RIPPLES 600        // Упор ближе к краю хода переустанавливает положение
+#define JAW_STALL_SPEED_Q8 24                // Скорость по модели, ниже которой двигатель считается в упоре (1/256)
+#define JAW_STALL_DETECT_MS 200              // Длительность упора до его обработки
+#define JAW_SOFT_ZONE_RIPPLES 900            // Зона снижения скорости перед краем хода
+#define JAW_SOFT_MIN_SPEED 80                // Скорость у самого края хода
+#define JAW_TARGET_TOLERANCE_RIPPLES 30      // Допуск достижения заданного положения
+
+// Квадратурный энкодер на TIM3 (PA6 - A, PA7 - B) и регулятор положения губок (PositionController)
+// false - энкодера нет, положение оценивается по пульсациям тока
+#define ENCODER_ENABLED false
+#define ENCODER_A_PIN PA6
+#define ENCODER_B_PIN PA7
+#define ENCODER_REVERSED false               // Инвертировать направление счета
+#define ENCODER_COUNTS_PER_TRAVEL 4000       // Полный ход губок в отсчетах (x4)
+#define ENCODER_REHOME_WINDOW_COUNTS 400     // Упор при открытии ближе к краю задает ноль заново
+#define POSITION_CONTROL_RC true             // Импульс RC задает положение губок (после хоминга)
+#define POSITION_LOOP_INTERVAL_US 1000       // Период регулятора положения (1 кГц, не связан с кадром RC)
+#define POSITION_KP 20.0f                    // Внешний контур: заданная скорость на отсчет ошибки (1/с)
+#define POSITION_MAX_VELOCITY_CPS 4000.0f    // Ограничение заданной скорости (отсчетов/с)
+#define POSITION_VELOCITY_FF 0.05f           // Прямая связь: заполнение на отсчет/с
+#define POSITION_VELOCITY_KP 0.05f           // Внутренний контур: заполнение на отсчет/с ошибки
+#define POSITION_VELOCITY_KI 1.0f            // Внутренний контур: заполнение на отсчет ошибки
+#define POSITION_VELOCITY_FILTER 0.2f        // Доля нового значения в сглаживании скорости
+#define POSITION_DEADBAND_COUNTS 4           // Зона нечувствительности у цели (отсчеты)
+#define POSITION_SETTLE_VELOCITY_CPS 50.0f   // Скорость, ниже которой цель считается достигнутой
+
 // Задержка измерения тока после старта двигателя (мс)
 #define MOTOR_START_DELAY_MS 1000  // 2 секунды для избежания пусковых токов
 
@@ -60,10 +146,86 @@
 // Интервал обновления двигателя (мс)
 #define MOTOR_UPDATE_INTERVAL_MS 50
 
-// Интервал вывода данных (мс)
-#define DATA_PRINT_INTERVAL_MS 100
+// Период основного такта управления (мс)
+#define CONTROL_TICK_INTERVAL_MS 20
+
+// Допустимое опоздание такта управления (мкс), сверх него такт считается опоздавшим
+#define LATE_TICK_TOLERANCE_US 2000
+
+// Ширина корзин гистограмм времени выполнения
+#define LOOP_JITTER_BIN_US 250     // Джиттер такта управления (мкс)
+#define LOOP_PASS_BIN_US 250       // Длительность прохода loop() (мкс)
+#define ISR_LATENCY_BIN_NS 250     // Задержка входа в прерывание импульса (нс)
+
+// Измерение задержки прерывания через захват TIM2 CH3 (только для PULSE_INPUT_PIN = PA2)
+#define ISR_LATENCY_CAPTURE_ENABLED true
+
+// Сон между событиями основного цикла (WFI вместо delay)
+#define IDLE_SLEEP_ENABLED true
+
+// Глубокий простой: без движения и команд дольше IDLE_DEEP_AFTER_MS (мс)
+// такт управления замедляется до IDLE_DEEP_TICK_MS (мс)
+#define IDLE_DEEP_ENABLED true
+#define IDLE_DEEP_AFTER_MS 30000
+#define IDLE_DEEP_TICK_MS 100
+
+// Изменение импульса (мкс), которое будит из глубокого простоя в режиме положения по RC
+#define IDLE_WAKE_PULSE_DELTA_US 20
+
+// Ширина корзины гистограммы задержки пробуждения (мкс)
+#define WAKE_LATENCY_BIN_US 250
+
+// Типовой ток STM32F103 при 72 МГц с включенной периферией (мА, datasheet):
+// Run - для оценки без сна, Sleep - в WFI
+#define MCU_RUN_CURRENT_MA 36.0f
+#define MCU_SLEEP_CURRENT_MA 14.4f
+
+// Бортовой самописец: размер буфера и блока (байт)
+#define FLIGHT_RECORDER_BUFFER_BYTES 3072
+#define FLIGHT_RECORDER_BLOCK_SIZE 128
+
+// Количество сэмплов самописца после события (остальной буфер - до события)
+#define FLIGHT_RECORDER_POST_SAMPLES 40
+
+// Автоматическая выгрузка самописца в Serial после заморозки
+#define FLIGHT_RECORDER_AUTO_DUMP true
+
+// Двоичный протокол команд: таймаут связи (мс) - без кадров дольше этого
+// цифровое управление снимается, двигатель останавливается
+#define COMMAND_HEARTBEAT_TIMEOUT_MS 300
+
+// Максимальная пауза между байтами одного кадра (мс)
+#define COMMAND_FRAME_TIMEOUT_MS 50
+
+// Допустимый диапазон порога защиты, задаваемого командой (мА)
+#define GRIP_CURRENT_MIN_MA 1
+#define GRIP_CURRENT_MAX_MA 1000
+
+// Телеметрия: период подписки по умолчанию ("tm sub <канал>" без периода, мс)
+#define TELEMETRY_DEFAULT_PERIOD_MS 100
+
+// Интервал чтения шунта для канала телеметрии "shunt" без работы счета пульсаций (1 кГц)
+#define TELEMETRY_SHUNT_INTERVAL_US 1000
 
 // Скорость последовательного порта
 #define SERIAL_BAUD_RATE 115200
 
+// Хранение настроек (RuntimeConfig) во flash: две последние страницы STM32F103C8 (64 КБ)
+// Прошивка не должна заходить в эту область - см. board_upload.maximum_size в platformio.ini
+#define CONFIG_FLASH_PAGE0_ADDRESS 0x0800F800
+#define CONFIG_FLASH_PAGE1_ADDRESS 0x0800FC00
+#define CONFIG_FLASH_PAGE_SIZE 1024
+#define CONFIG_SLOT_BYTES 32                 // Размер записи: заголовок 8 + настройки + CRC и метка 4
+
+// Бюджет загрузки: от сброса до первого такта управления (мс), USB и датчик не ждем
+#define BOOT_BUDGET_MS 50
+
+// Сборка без кучи: в src/ ссылки на malloc/new/String запрещены при сборке (tools/size_report.py),
+// выделения библиотек после setup учитываются, но выполняются (команда "mem")
+#define HEAP_FREE_BUILD true
+
+// Бюджет стека (байт): проверяется окраской стека во время работы и входит
+// в бюджет RAM при сборке (custom_budget_ram в platformio.ini)
+#define STACK_BUDGET_BYTES 2048
+
 #endif // CONFIG_H
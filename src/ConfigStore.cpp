@@ -0,0 +1,277 @@
+#include "ConfigStore.h"
+#include "CommandProtocol.h"
+
+#if defined(STM32F1xx)
+/**
+ * Стереть страницу встроенной flash
+ * @param address - адрес начала страницы
+ * @return true при успехе
+ */
+bool Stm32FlashBackend::erasePage(uint32_t address) {
+    FLASH_EraseInitTypeDef erase = {};
+    erase.TypeErase = FLASH_TYPEERASE_PAGES;
+    erase.PageAddress = address;
+    erase.NbPages = 1;
+    uint32_t page_error = 0;
+
+    HAL_FLASH_Unlock();
+    HAL_StatusTypeDef status = HAL_FLASHEx_Erase(&erase, &page_error);
+    HAL_FLASH_Lock();
+    return status == HAL_OK;
+}
+
+/**
+ * Записать полуслово во встроенную flash
+ * @param address - четный адрес
+ * @param value - значение
+ * @return true если записано и прочитано обратно
+ */
+bool Stm32FlashBackend::programHalfWord(uint32_t address, uint16_t value) {
+    HAL_FLASH_Unlock();
+    HAL_StatusTypeDef status = HAL_FLASH_Program(FLASH_TYPEPROGRAM_HALFWORD, address, value);
+    HAL_FLASH_Lock();
+    return status == HAL_OK && readHalfWord(address) == value;
+}
+
+/**
+ * Прочитать полуслово встроенной flash
+ * @param address - четный адрес
+ * @return значение
+ */
+uint16_t Stm32FlashBackend::readHalfWord(uint32_t address) const {
+    return *reinterpret_cast<const volatile uint16_t*>(address);
+}
+#endif
+
+/**
+ * Конструктор класса ConfigStore
+ * @param flash - доступ к flash
+ * @param page0_address - адрес первой страницы
+ * @param page1_address - адрес второй страницы
+ */
+ConfigStore::ConfigStore(FlashBackend& flash, uint32_t page0_address, uint32_t page1_address)
+    : flash(flash), pages{page0_address, page1_address}, active_page(0), next_slot(0), sequence(0),
+      load_result(LOAD_EMPTY), saves(0), erases(0) {
+}
+
+/**
+ * Получить адрес слота
+ * @param page - страница 0..1
+ * @param slot - слот на странице
+ * @return адрес
+ */
+uint32_t ConfigStore::slotAddress(uint8_t page, uint16_t slot) const {
+    return pages[page] + static_cast<uint32_t>(slot) * CONFIG_SLOT_BYTES;
+}
+
+/**
+ * Проверить, что слот не тронут с момента стирания
+ * @param address - адрес слота
+ * @return true если все полуслова 0xFFFF
+ */
+bool ConfigStore::isSlotErased(uint32_t address) const {
+    for (uint16_t offset = 0; offset < CONFIG_SLOT_BYTES; offset += 2) {
+        if (flash.readHalfWord(address + offset) != 0xFFFF) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Вычислить CRC записи
+ * @param version - версия структуры
+ * @param record_sequence - номер записи
+ * @param config - данные
+ * @return CRC-16/CCITT
+ */
+uint16_t ConfigStore::recordCrc(uint16_t version, uint32_t record_sequence, const RuntimeConfig& config) {
+    uint16_t crc = 0xFFFF;
+    crc = CommandProtocol::crcUpdate(crc, static_cast<uint8_t>(version));
+    crc = CommandProtocol::crcUpdate(crc, static_cast<uint8_t>(version >> 8));
+    for (uint8_t shift = 0; shift < 32; shift += 8) {
+        crc = CommandProtocol::crcUpdate(crc, static_cast<uint8_t>(record_sequence >> shift));
+    }
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(&config);
+    for (size_t i = 0; i < sizeof(RuntimeConfig); i++) {
+        crc = CommandProtocol::crcUpdate(crc, data[i]);
+    }
+    return crc;
+}
+
+/**
+ * Прочитать зафиксированную запись с верной CRC
+ * @param address - адрес слота
+ * @param version - версия записи
+ * @param record_sequence - номер записи
+ * @param config - данные (имеют смысл, только если версия совпадает)
+ * @return true если запись зафиксирована и CRC верна
+ */
+bool ConfigStore::readSlot(uint32_t address, uint16_t& version, uint32_t& record_sequence, RuntimeConfig& config) const {
+    if (flash.readHalfWord(address) != MAGIC || flash.readHalfWord(address + OFFSET_COMMIT) != COMMITTED) {
+        return false;
+    }
+    version = flash.readHalfWord(address + OFFSET_VERSION);
+    record_sequence = flash.readHalfWord(address + OFFSET_SEQUENCE) |
+                      (static_cast<uint32_t>(flash.readHalfWord(address + OFFSET_SEQUENCE + 2)) << 16);
+    uint16_t* data = reinterpret_cast<uint16_t*>(&config);
+    for (size_t i = 0; i < sizeof(RuntimeConfig) / 2; i++) {
+        data[i] = flash.readHalfWord(address + OFFSET_DATA + i * 2);
+    }
+    return flash.readHalfWord(address + OFFSET_CRC) == recordCrc(version, record_sequence, config);
+}
+
+/**
+ * Записать запись в стертый слот, метка фиксации - последней
+ * @param address - адрес слота
+ * @param record_sequence - номер записи
+ * @param config - данные
+ * @return true если все полуслова записаны
+ */
+bool ConfigStore::writeSlot(uint32_t address, uint32_t record_sequence, const RuntimeConfig& config) {
+    bool ok = flash.programHalfWord(address, MAGIC) &&
+              flash.programHalfWord(address + OFFSET_VERSION, RuntimeConfig::VERSION) &&
+              flash.programHalfWord(address + OFFSET_SEQUENCE, static_cast<uint16_t>(record_sequence)) &&
+              flash.programHalfWord(address + OFFSET_SEQUENCE + 2, static_cast<uint16_t>(record_sequence >> 16));
+    const uint16_t* data = reinterpret_cast<const uint16_t*>(&config);
+    for (size_t i = 0; ok && i < sizeof(RuntimeConfig) / 2; i++) {
+        ok = flash.programHalfWord(address + OFFSET_DATA + i * 2, data[i]);
+    }
+    return ok && flash.programHalfWord(address + OFFSET_CRC, recordCrc(RuntimeConfig::VERSION, record_sequence, config)) &&
+           flash.programHalfWord(address + OFFSET_COMMIT, COMMITTED);
+}
+
+/**
+ * Найти последнюю запись и загрузить ее (вызывать один раз при загрузке)
+ * @param config - структура для записи (при отсутствии записи - значения по умолчанию)
+ * @return результат загрузки
+ */
+ConfigStore::LoadResult ConfigStore::load(RuntimeConfig& config) {
+    uint16_t page_next_slot[2] = {0, 0};
+    uint32_t best_sequence = 0;
+    bool found_current = false;
+    bool found_other = false;
+    sequence = 0;
+    active_page = 0;
+
+    for (uint8_t page = 0; page < 2; page++) {
+        for (uint16_t slot = 0; slot < SLOTS_PER_PAGE; slot++) {
+            uint32_t address = slotAddress(page, slot);
+            if (isSlotErased(address)) {
+                continue;
+            }
+            // Занятый слот, в том числе оборванная запись: дописывать только после него
+            page_next_slot[page] = slot + 1;
+
+            uint16_t version;
+            uint32_t record_sequence;
+            RuntimeConfig record;
+            if (!readSlot(address, version, record_sequence, record)) {
+                continue;
+            }
+            if (record_sequence >= sequence) {
+                sequence = record_sequence;
+                active_page = page;
+            }
+            if (version != RuntimeConfig::VERSION) {
+                found_other = true;
+            } else if (!found_current || record_sequence > best_sequence) {
+                found_current = true;
+                best_sequence = record_sequence;
+                config = record;
+            }
+        }
+    }
+    next_slot = page_next_slot[active_page];
+
+    if (found_current && config.validate() == nullptr) {
+        load_result = LOAD_OK;
+    } else {
+        load_result = found_current ? LOAD_INVALID : (found_other ? LOAD_VERSION : LOAD_EMPTY);
+        config = RuntimeConfig::DEFAULTS;
+    }
+    return load_result;
+}
+
+/**
+ * Сохранить конфигурацию новой записью
+ * @param config - конфигурация (должна проходить validate())
+ * @return true если запись зафиксирована
+ */
+bool ConfigStore::save(const RuntimeConfig& config) {
+    if (config.validate() != nullptr) {
+        return false;
+    }
+
+    // Пропустить занятые слоты (оборванная запись после сбоя)
+    while (next_slot < SLOTS_PER_PAGE && !isSlotErased(slotAddress(active_page, next_slot))) {
+        next_slot++;
+    }
+
+    // Страница заполнена: стереть другую; последняя запись остается на этой до фиксации новой
+    if (next_slot >= SLOTS_PER_PAGE) {
+        uint8_t other_page = active_page ^ 1;
+        erases++;
+        if (!flash.erasePage(pages[other_page])) {
+            return false;
+        }
+        active_page = other_page;
+        next_slot = 0;
+    }
+
+    uint32_t address = slotAddress(active_page, next_slot);
+    next_slot++;
+    if (!writeSlot(address, sequence + 1, config)) {
+        return false;
+    }
+    sequence++;
+    saves++;
+    return true;
+}
+
+/**
+ * Стереть обе страницы (следующая загрузка - значения по умолчанию)
+ * @return true при успехе
+ */
+bool ConfigStore::erase() {
+    bool ok = true;
+    for (uint8_t page = 0; page < 2; page++) {
+        erases++;
+        ok = flash.erasePage(pages[page]) && ok;
+    }
+    active_page = 0;
+    next_slot = 0;
+    sequence = 0;
+    return ok;
+}
+
+/**
+ * Получить результат последней загрузки
+ * @return результат
+ */
+ConfigStore::LoadResult ConfigStore::getLoadResult() const {
+    return load_result;
+}
+
+/**
+ * Получить номер последней записи
+ * @return номер (0 - записей нет)
+ */
+uint32_t ConfigStore::getSequence() const {
+    return sequence;
+}
+
+/**
+ * Вывести отчет в Serial
+ */
+void ConfigStore::printReport() const {
+    static const char* const RESULTS[] = {"loaded", "empty, defaults", "other version, defaults", "invalid, defaults"};
+    Serial.print("Config store: "); Serial.print(RESULTS[load_result]);
+    Serial.print(", version "); Serial.print(RuntimeConfig::VERSION);
+    Serial.print(", record #"); Serial.print(sequence);
+    Serial.print(", page "); Serial.print(active_page);
+    Serial.print(" slot "); Serial.print(next_slot);
+    Serial.print("/"); Serial.print(SLOTS_PER_PAGE);
+    Serial.print(", saves "); Serial.print(saves);
+    Serial.print(", erases "); Serial.println(erases);
+}
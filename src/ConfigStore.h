@@ -0,0 +1,165 @@
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include <Arduino.h>
+#include "Config.h"
+#include "RuntimeConfig.h"
+
+/**
+ * Доступ к flash: стирание страницы и запись полуслов (как у STM32F1)
+ * Стертая flash читается как 0xFFFF; полуслово записывается один раз после стирания.
+ */
+class FlashBackend {
+public:
+    virtual ~FlashBackend() = default;
+
+    /**
+     * Стереть страницу
+     * @param address - адрес начала страницы
+     * @return true при успехе
+     */
+    virtual bool erasePage(uint32_t address) = 0;
+
+    /**
+     * Записать полуслово
+     * @param address - четный адрес
+     * @param value - значение
+     * @return true при успехе
+     */
+    virtual bool programHalfWord(uint32_t address, uint16_t value) = 0;
+
+    /**
+     * Прочитать полуслово
+     * @param address - четный адрес
+     * @return значение
+     */
+    virtual uint16_t readHalfWord(uint32_t address) const = 0;
+};
+
+#if defined(STM32F1xx)
+/**
+ * Встроенная flash STM32F1 через HAL (запись блокирует выполнение из flash
+ * на время операции: ~40 мкс на полуслово, ~20 мс на стирание страницы)
+ */
+class Stm32FlashBackend : public FlashBackend {
+public:
+    bool erasePage(uint32_t address) override;
+    bool programHalfWord(uint32_t address, uint16_t value) override;
+    uint16_t readHalfWord(uint32_t address) const override;
+};
+#endif
+
+/**
+ * Хранение RuntimeConfig во flash с выравниванием износа (эмуляция EEPROM)
+ *
+ * Две страницы по CONFIG_FLASH_PAGE_SIZE, каждая - ряд слотов CONFIG_SLOT_BYTES:
+ *   [+0]  MAGIC            [+2]  RuntimeConfig::VERSION
+ *   [+4]  номер записи (uint32, младшее полуслово первым)
+ *   [+8]  RuntimeConfig
+ *   [-4]  CRC-16/CCITT по версии, номеру и данным
+ *   [-2]  метка фиксации: 0x0000 пишется последней
+ * Сохранение дописывает слот за последним занятым; страница стирается только
+ * когда в другой закончилось место, и только после этого в нее пишется новая
+ * запись - предыдущая зафиксированная запись во второй странице остается
+ * целой до фиксации новой. При загрузке берется зафиксированная запись с
+ * верной CRC и наибольшим номером; оборванная запись или стирание
+ * пропускаются, так что после потери питания загружается либо старая, либо
+ * новая конфигурация.
+ */
+class ConfigStore {
+public:
+    // Результат загрузки
+    enum LoadResult : uint8_t {
+        LOAD_OK = 0,        // Загружена сохраненная конфигурация
+        LOAD_EMPTY,         // Записей нет - значения по умолчанию
+        LOAD_VERSION,       // Только записи другой версии - значения по умолчанию
+        LOAD_INVALID        // Запись не прошла validate() - значения по умолчанию
+    };
+
+    static constexpr uint16_t MAGIC = 0xC0F6;
+    static constexpr uint16_t COMMITTED = 0x0000;
+    static constexpr uint16_t SLOTS_PER_PAGE = CONFIG_FLASH_PAGE_SIZE / CONFIG_SLOT_BYTES;
+
+private:
+    static constexpr uint16_t OFFSET_VERSION = 2;
+    static constexpr uint16_t OFFSET_SEQUENCE = 4;
+    static constexpr uint16_t OFFSET_DATA = 8;
+    static constexpr uint16_t OFFSET_CRC = CONFIG_SLOT_BYTES - 4;
+    static constexpr uint16_t OFFSET_COMMIT = CONFIG_SLOT_BYTES - 2;
+
+    static_assert(sizeof(RuntimeConfig) % 2 == 0, "RuntimeConfig пишется полусловами");
+    static_assert(OFFSET_DATA + sizeof(RuntimeConfig) <= OFFSET_CRC, "RuntimeConfig не помещается в слот");
+    static_assert(CONFIG_FLASH_PAGE_SIZE % CONFIG_SLOT_BYTES == 0, "Страница должна делиться на слоты");
+
+    FlashBackend& flash;          // Доступ к flash
+    uint32_t pages[2];            // Адреса страниц
+    uint8_t active_page;          // Страница последней записи
+    uint16_t next_slot;           // Первый свободный слот активной страницы
+    uint32_t sequence;            // Номер последней записи
+    LoadResult load_result;       // Результат последней загрузки
+    uint32_t saves;               // Сохранений с загрузки
+    uint32_t erases;              // Стираний с загрузки
+
+    // Адрес слота
+    uint32_t slotAddress(uint8_t page, uint16_t slot) const;
+
+    // Слот не тронут с момента стирания
+    bool isSlotErased(uint32_t address) const;
+
+    // Прочитать зафиксированную запись с верной CRC (любой версии)
+    bool readSlot(uint32_t address, uint16_t& version, uint32_t& record_sequence, RuntimeConfig& config) const;
+
+    // Записать запись в стертый слот, метка фиксации - последней
+    bool writeSlot(uint32_t address, uint32_t record_sequence, const RuntimeConfig& config);
+
+    // CRC записи
+    static uint16_t recordCrc(uint16_t version, uint32_t record_sequence, const RuntimeConfig& config);
+
+public:
+    /**
+     * Конструктор
+     * @param flash - доступ к flash
+     * @param page0_address - адрес первой страницы
+     * @param page1_address - адрес второй страницы
+     */
+    ConfigStore(FlashBackend& flash, uint32_t page0_address, uint32_t page1_address);
+
+    /**
+     * Найти последнюю запись и загрузить ее (вызывать один раз при загрузке)
+     * @param config - структура для записи (при отсутствии записи - значения по умолчанию)
+     * @return результат загрузки
+     */
+    LoadResult load(RuntimeConfig& config);
+
+    /**
+     * Сохранить конфигурацию новой записью
+     * @param config - конфигурация (должна проходить validate())
+     * @return true если запись зафиксирована
+     */
+    bool save(const RuntimeConfig& config);
+
+    /**
+     * Стереть обе страницы (следующая загрузка - значения по умолчанию)
+     * @return true при успехе
+     */
+    bool erase();
+
+    /**
+     * Получить результат последней загрузки
+     * @return результат
+     */
+    LoadResult getLoadResult() const;
+
+    /**
+     * Получить номер последней записи
+     * @return номер (0 - записей нет)
+     */
+    uint32_t getSequence() const;
+
+    /**
+     * Вывести отчет в Serial
+     */
+    void printReport() const;
+};
+
+#endif // CONFIG_STORE_H
@@ -0,0 +1,181 @@
+#include "CurrentFilter.h"
+
+/**
+ * Конструктор класса CurrentFilter (без фильтрации)
+ */
+CurrentFilter::CurrentFilter()
+    : type(FILTER_NONE), primed(false), group_delay(0.0f), tap_sum(0), tap_count(1), tap_index(0),
+      alpha(1L << ALPHA_SHIFT), iir_state(0), b0(0), b1(0), b2(0), a1(0), a2(0),
+      x1(0), x2(0), y1(0), y2(0) {
+    for (uint8_t i = 0; i < MAX_TAPS; i++) {
+        taps[i] = 0;
+    }
+}
+
+/**
+ * Без фильтрации
+ */
+void CurrentFilter::configureNone() {
+    type = FILTER_NONE;
+    group_delay = 0.0f;
+    reset();
+}
+
+/**
+ * Скользящее среднее
+ * @param taps - количество точек (1..MAX_TAPS)
+ */
+void CurrentFilter::configureMovingAverage(uint8_t taps) {
+    type = FILTER_MOVING_AVERAGE;
+    tap_count = constrain(taps, 1, MAX_TAPS);
+    group_delay = (tap_count - 1) / 2.0f;
+    reset();
+}
+
+/**
+ * Однополюсный IIR фильтр y += a * (x - y)
+ * @param alpha - коэффициент a (0 < a <= 1)
+ */
+void CurrentFilter::configureIIR(float alpha) {
+    alpha = constrain(alpha, 0.001f, 1.0f);
+    type = FILTER_IIR;
+    this->alpha = static_cast<int32_t>(alpha * (1L << ALPHA_SHIFT) + 0.5f);
+
+    float quantized = static_cast<float>(this->alpha) / (1L << ALPHA_SHIFT);
+    group_delay = (1.0f - quantized) / quantized;
+    reset();
+}
+
+/**
+ * Биквадратный ФНЧ Баттерворта
+ * @param cutoff_hz - частота среза
+ * @param sample_rate_hz - частота дискретизации
+ */
+void CurrentFilter::configureBiquad(float cutoff_hz, float sample_rate_hz) {
+    // Частота среза ограничена снизу (точность Q24) и сверху (ниже Найквиста)
+    cutoff_hz = constrain(cutoff_hz, sample_rate_hz * 0.002f, sample_rate_hz * 0.45f);
+
+    // Расчет по формулам RBJ для ФНЧ, Q = 1/sqrt(2)
+    const float q = 0.70710678f;
+    float w0 = 2.0f * static_cast<float>(M_PI) * cutoff_hz / sample_rate_hz;
+    float cos_w0 = cosf(w0);
+    float alpha_rbj = sinf(w0) / (2.0f * q);
+    float a0 = 1.0f + alpha_rbj;
+    const float scale = static_cast<float>(1L << COEF_SHIFT);
+
+    type = FILTER_BIQUAD;
+    a1 = static_cast<int32_t>(lroundf(-2.0f * cos_w0 / a0 * scale));
+    a2 = static_cast<int32_t>(lroundf((1.0f - alpha_rbj) / a0 * scale));
+
+    // Числитель (1, 2, 1) * b0; b0 выбран так, чтобы усиление на нуле было ровно 1
+    int32_t denominator = (1L << COEF_SHIFT) + a1 + a2;
+    b0 = denominator / 4;
+    b1 = denominator - 2 * b0;
+    b2 = b0;
+
+    // Групповая задержка на нулевой частоте: sum(k*b)/sum(b) - sum(k*a)/sum(a)
+    float sum_b = static_cast<float>(b0) + b1 + b2;
+    float sum_a = scale + a1 + a2;
+    group_delay = (static_cast<float>(b1) + 2.0f * b2) / sum_b -
+                  (static_cast<float>(a1) + 2.0f * a2) / sum_a;
+    reset();
+}
+
+/**
+ * Инициализировать состояние постоянным значением
+ * @param value_q8 - значение в мкА с 8 дробными битами
+ */
+void CurrentFilter::prime(int32_t value_q8) {
+    int32_t value_uA = value_q8 >> STATE_SHIFT;
+    for (uint8_t i = 0; i < MAX_TAPS; i++) {
+        taps[i] = value_uA;
+    }
+    tap_sum = value_uA * tap_count;
+    tap_index = 0;
+    iir_state = value_q8;
+    x1 = x2 = y1 = y2 = value_q8;
+    primed = true;
+}
+
+/**
+ * Обработать сэмпл
+ * @param input_uA - входной ток в мкА
+ * @return отфильтрованный ток в мкА
+ */
+int32_t CurrentFilter::update(int32_t input_uA) {
+    // Ограничение входа, чтобы состояние Q8 помещалось в int32
+    input_uA = constrain(input_uA, -8000000L, 8000000L);
+    int32_t input_q8 = input_uA * (1L << STATE_SHIFT);
+
+    if (!primed) {
+        prime(input_q8);
+    }
+
+    switch (type) {
+        case FILTER_MOVING_AVERAGE: {
+            tap_sum += input_uA - taps[tap_index];
+            taps[tap_index] = input_uA;
+            tap_index = (tap_index + 1) % tap_count;
+            return tap_sum / tap_count;
+        }
+
+        case FILTER_IIR: {
+            // Разность двух значений Q8 до +-4.1e9 в int32 не помещается
+            int64_t step = (static_cast<int64_t>(input_q8) - iir_state) * alpha;
+            iir_state += static_cast<int32_t>(step >> ALPHA_SHIFT);
+            return iir_state >> STATE_SHIFT;
+        }
+
+        case FILTER_BIQUAD: {
+            int64_t acc = static_cast<int64_t>(b0) * input_q8 + static_cast<int64_t>(b1) * x1 +
+                          static_cast<int64_t>(b2) * x2 - static_cast<int64_t>(a1) * y1 -
+                          static_cast<int64_t>(a2) * y2;
+            int32_t output_q8 = static_cast<int32_t>(acc >> COEF_SHIFT);
+            x2 = x1;
+            x1 = input_q8;
+            y2 = y1;
+            y1 = output_q8;
+            return output_q8 >> STATE_SHIFT;
+        }
+
+        case FILTER_NONE:
+        default:
+            return input_uA;
+    }
+}
+
+/**
+ * Сбросить состояние (следующий сэмпл инициализирует фильтр)
+ */
+void CurrentFilter::reset() {
+    primed = false;
+}
+
+/**
+ * Получить тип фильтра
+ * @return тип фильтра
+ */
+CurrentFilter::Type CurrentFilter::getType() const {
+    return type;
+}
+
+/**
+ * Получить название типа фильтра
+ * @return строка с названием
+ */
+const char* CurrentFilter::getTypeName() const {
+    switch (type) {
+        case FILTER_MOVING_AVERAGE: return "ma";
+        case FILTER_IIR: return "iir";
+        case FILTER_BIQUAD: return "biquad";
+        default: return "none";
+    }
+}
+
+/**
+ * Получить групповую задержку на нулевой частоте
+ * @return задержка в сэмплах
+ */
+float CurrentFilter::getGroupDelaySamples() const {
+    return group_delay;
+}
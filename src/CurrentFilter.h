@@ -0,0 +1,120 @@
+#ifndef CURRENT_FILTER_H
+#define CURRENT_FILTER_H
+
+#include <Arduino.h>
+
+/**
+ * Фильтр нижних частот для тока в фиксированной точке
+ * Вход и выход - микроамперы (int32), состояние хранится с 8 дробными битами.
+ *
+ * Типы фильтра и групповая задержка на нулевой частоте (в сэмплах):
+ *   FILTER_NONE            - без фильтрации, 0
+ *   FILTER_MOVING_AVERAGE  - скользящее среднее по N точкам (1..8), (N - 1) / 2
+ *   FILTER_IIR             - однополюсный y += a * (x - y), (1 - a) / a
+ *   FILTER_BIQUAD          - биквадратный ФНЧ Баттерворта (Q = 0.707),
+ *                            sqrt(2) / (2 * pi * fc / fs) приблизительно
+ * Задержка в мс = задержка в сэмплах * интервал измерения.
+ * Точное значение для текущей настройки - getGroupDelaySamples().
+ */
+class CurrentFilter {
+public:
+    // Тип фильтра
+    enum Type : uint8_t {
+        FILTER_NONE = 0,
+        FILTER_MOVING_AVERAGE = 1,
+        FILTER_IIR = 2,
+        FILTER_BIQUAD = 3
+    };
+
+    static constexpr uint8_t MAX_TAPS = 8;
+
+private:
+    static constexpr uint8_t STATE_SHIFT = 8;     // Дробные биты состояния
+    static constexpr uint8_t COEF_SHIFT = 24;     // Дробные биты коэффициентов биквада
+    static constexpr uint8_t ALPHA_SHIFT = 16;    // Дробные биты коэффициента IIR
+
+    Type type;                  // Тип фильтра
+    bool primed;                // Состояние инициализировано первым сэмплом
+    float group_delay;          // Групповая задержка на нулевой частоте (сэмплы)
+
+    // Скользящее среднее
+    int32_t taps[MAX_TAPS];     // Кольцевой буфер отсчетов
+    int32_t tap_sum;            // Сумма отсчетов
+    uint8_t tap_count;          // Количество точек
+    uint8_t tap_index;          // Индекс следующей записи
+
+    // Однополюсный IIR
+    int32_t alpha;              // Коэффициент (Q16)
+    int32_t iir_state;          // Выход (Q8 мкА)
+
+    // Биквад (прямая форма I)
+    int32_t b0, b1, b2, a1, a2; // Коэффициенты (Q24)
+    int32_t x1, x2;             // Предыдущие входы (Q8 мкА)
+    int32_t y1, y2;             // Предыдущие выходы (Q8 мкА)
+
+    // Инициализировать состояние постоянным значением
+    void prime(int32_t value_q8);
+
+public:
+    /**
+     * Конструктор (без фильтрации)
+     */
+    CurrentFilter();
+
+    /**
+     * Без фильтрации
+     */
+    void configureNone();
+
+    /**
+     * Скользящее среднее
+     * @param taps - количество точек (1..MAX_TAPS)
+     */
+    void configureMovingAverage(uint8_t taps);
+
+    /**
+     * Однополюсный IIR фильтр y += a * (x - y)
+     * @param alpha - коэффициент a (0 < a <= 1)
+     */
+    void configureIIR(float alpha);
+
+    /**
+     * Биквадратный ФНЧ Баттерворта
+     * Коэффициенты рассчитываются один раз и квантуются в Q24
+     * @param cutoff_hz - частота среза
+     * @param sample_rate_hz - частота дискретизации
+     */
+    void configureBiquad(float cutoff_hz, float sample_rate_hz);
+
+    /**
+     * Обработать сэмпл
+     * @param input_uA - входной ток в мкА
+     * @return отфильтрованный ток в мкА
+     */
+    int32_t update(int32_t input_uA);
+
+    /**
+     * Сбросить состояние (следующий сэмпл инициализирует фильтр)
+     */
+    void reset();
+
+    /**
+     * Получить тип фильтра
+     * @return тип фильтра
+     */
+    Type getType() const;
+
+    /**
+     * Получить название типа фильтра
+     * @return строка с названием
+     */
+    const char* getTypeName() const;
+
+    /**
+     * Получить групповую задержку на нулевой частоте
+     * @return задержка в сэмплах
+     */
+    float getGroupDelaySamples() const;
+};
+
+#endif // CURRENT_FILTER_H
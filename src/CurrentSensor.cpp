@@ -7,24 +7,70 @@
  */
 CurrentSensor::CurrentSensor(uint8_t sda_pin_number, uint8_t scl_pin_number) 
     : sda_pin(sda_pin_number), scl_pin(scl_pin_number), sensor_initialized(false), 
-      current_mA(0.0), voltage_V(0.0), power_mW(0.0), last_valid_current(0.0), last_measurement(0) {
+      current_mA(0.0), telemetry_current_mA(0.0), raw_current_mA(0.0), corrected_current_mA(0.0),
+      voltage_V(0.0), power_mW(0.0),
+      hysteresis_mA(CURRENT_HYSTERESIS_MA), motor(nullptr), motor_idle(true), fast_adc(false), last_measurement(0), last_probe(0), probe_attempts(0) {
+    fast_filter.configureMovingAverage(CURRENT_FAST_FILTER_TAPS);
+    slow_filter.configureBiquad(CURRENT_SLOW_FILTER_CUTOFF_HZ, 1000.0f / CURRENT_MEASUREMENT_INTERVAL);
 }
 
 /**
  * Инициализация датчика тока
+ * Одна попытка найти INA219; если датчика нет, поиск продолжает retryInit()
  * @return true если инициализация прошла успешно
  */
 bool CurrentSensor::begin() {
     // Инициализация I2C шины с указанными пинами
     Wire.begin(sda_pin, scl_pin);
     
-    // Инициализация датчика INA219
-    if (ina219.begin()) {
+    // Драйвер INA219 вызывает Wire.begin() при каждом begin(), а тот освобождает буферы Wire:
+    // драйвер инициализируется один раз, повторный поиск (probe) обходится без него
+    ina219.begin();
+    
+    // Буферы Wire выделяются при первой передаче и первом приеме - выделить оба в setup(),
+    // даже если датчика нет: поиск из loop() и чтение шунта уже не обращаются к куче
+    Wire.beginTransmission(I2C_ADDRESS);
+    Wire.write(REG_CONFIG);
+    Wire.endTransmission();
+    Wire.requestFrom(I2C_ADDRESS, static_cast<uint8_t>(2));
+    
+    return probe();
+}
+
+/**
+ * Повторить поиск датчика, если он еще не найден (вызывать в основном цикле)
+ * @param current_time - текущее время в мс
+ * @return true если датчик найден именно в этом вызове
+ */
+bool CurrentSensor::retryInit(unsigned long current_time) {
+    if (sensor_initialized || current_time - last_probe < CURRENT_SENSOR_RETRY_MS) {
+        return false;
+    }
+    return probe();
+}
+
+/**
+ * Найти INA219 на шине и настроить его
+ * @return true если датчик ответил
+ */
+bool CurrentSensor::probe() {
+    last_probe = millis();
+    probe_attempts++;
+    
+    // Датчик отвечает на свой адрес
+    Wire.beginTransmission(I2C_ADDRESS);
+    if (Wire.endTransmission() == 0) {
         sensor_initialized = true;
         
         // Настройка диапазона измерения для более точных измерений малых токов
         // 32V, 1A - лучшая точность для малых токов
         ina219.setCalibration_32V_1A();
+        fast_adc = false;   // Калибровка записала CONFIG_PRECISE_ADC
+        
+        // Высокочастотное чтение шунта: I2C 400 кГц, быстрый АЦП - при вращении (updateAdcMode)
+        if (RIPPLE_COUNTING_ENABLED) {
+            Wire.setClock(400000);
+        }
         
         return true;
     } else {
@@ -33,21 +79,57 @@ bool CurrentSensor::begin() {
     }
 }
 
+/**
+ * Записать 16-битный регистр INA219
+ * @param reg - адрес регистра
+ * @param value - значение
+ * @return true если датчик подтвердил запись
+ */
+bool CurrentSensor::writeRegister(uint8_t reg, uint16_t value) {
+    Wire.beginTransmission(I2C_ADDRESS);
+    Wire.write(reg);
+    Wire.write(static_cast<uint8_t>(value >> 8));
+    Wire.write(static_cast<uint8_t>(value & 0xFF));
+    return Wire.endTransmission() == 0;
+}
+
+/**
+ * Переключить АЦП по состоянию двигателя
+ * Быстрый режим нужен только для счета пульсаций; при остановке возвращается
+ * 12-битный, по которому калибруется смещение нуля
+ */
+void CurrentSensor::updateAdcMode() {
+    bool fast = RIPPLE_COUNTING_ENABLED && motor != nullptr && motor->getSpeed() != MOTOR_SPEED_STOP;
+    if (fast != fast_adc && writeRegister(REG_CONFIG, fast ? CONFIG_FAST_ADC : CONFIG_PRECISE_ADC)) {
+        fast_adc = fast;
+    }
+}
+
+/**
+ * Получить количество попыток найти датчик
+ * @return количество попыток с начала работы
+ */
+uint16_t CurrentSensor::getProbeAttempts() const {
+    return probe_attempts;
+}
+
 /**
  * Обновить измерения тока, напряжения и мощности
  * Вызывать периодически для получения актуальных данных
+ * @return true если выполнено новое измерение
  */
-void CurrentSensor::update() {
+bool CurrentSensor::update() {
     // Проверяем, инициализирован ли датчик
     if (!sensor_initialized) {
-        return;
+        return false;
     }
     
     // Проверяем интервал измерения
     unsigned long current_time = millis();
     if (current_time - last_measurement < measurement_interval) {
-        return;
+        return false;
     }
+    updateAdcMode();
     
     // Выполняем измерения с проверкой ошибок
     float raw_current = 0.0;
@@ -65,40 +147,91 @@ void CurrentSensor::update() {
         power = ina219.getPower_mW();
     }
     
+    raw_current_mA = raw_current;
     voltage_V = voltage;
     power_mW = power;
     
-    // Простая фильтрация (скользящее среднее)
-    static float current_history[3] = {0, 0, 0};
-    static uint8_t history_index = 0;
+    // Вычитание смещения нуля до фильтрации и защиты. Состояние двигателя - на момент
+    // измерения: пуск импульсом или командой между тактами не попадает в холостые сэмплы
+    motor_idle = motor == nullptr || motor->getSpeed() == MOTOR_SPEED_STOP;
+    idle_calibrator.addSample(raw_current, motor_idle, current_time);
+    corrected_current_mA = raw_current - idle_calibrator.getOffset_mA();
     
-    current_history[history_index] = raw_current;
-    history_index = (history_index + 1) % 3;
+    // Фильтрация в фиксированной точке (мкА)
+    int32_t raw_uA = static_cast<int32_t>(lroundf(corrected_current_mA * 1000.0f));
+    current_mA = fast_filter.update(raw_uA) / 1000.0f;
+    float slow_mA = slow_filter.update(raw_uA) / 1000.0f;
     
-    // Вычисляем среднее значение
-    float filtered_current = (current_history[0] + current_history[1] + current_history[2]) / 3.0;
-    
-    // Применяем мертвую зону
-    float current_diff = filtered_current - last_valid_current;
-    if (current_diff < 0) current_diff = -current_diff; // abs() для float
-    
-    if (current_diff >= dead_zone_mA) {
-        current_mA = filtered_current;
-        last_valid_current = filtered_current;
+    // Гистерезис: выход сдвигается, только когда вход выходит за полосу
+    if (slow_mA > telemetry_current_mA + hysteresis_mA) {
+        telemetry_current_mA = slow_mA - hysteresis_mA;
+    } else if (slow_mA < telemetry_current_mA - hysteresis_mA) {
+        telemetry_current_mA = slow_mA + hysteresis_mA;
     }
     
     // Обновляем время последнего измерения
     last_measurement = current_time;
+    return true;
+}
+
+/**
+ * Прочитать регистр напряжения шунта (одна транзакция I2C, для счета пульсаций)
+ * Не обновляет фильтры и не зависит от интервала измерения
+ * @param raw - ссылка для записи отсчета (10 мкВ)
+ * @return true если чтение успешно
+ */
+bool CurrentSensor::readShuntRaw(int16_t& raw) {
+    if (!sensor_initialized) {
+        return false;
+    }
+    updateAdcMode();
+    
+    Wire.beginTransmission(I2C_ADDRESS);
+    Wire.write(REG_SHUNT_VOLTAGE);
+    if (Wire.endTransmission(false) != 0) {
+        return false;
+    }
+    if (Wire.requestFrom(I2C_ADDRESS, static_cast<uint8_t>(2)) != 2) {
+        return false;
+    }
+    uint8_t high_byte = Wire.read();
+    uint8_t low_byte = Wire.read();
+    raw = static_cast<int16_t>((high_byte << 8) | low_byte);
+    return true;
 }
 
 /**
- * Получить текущий ток в миллиамперах
+ * Получить ток после быстрого фильтра (для защиты)
  * @return ток в мА
  */
 float CurrentSensor::getCurrent_mA() const {
     return current_mA;
 }
 
+/**
+ * Получить ток после медленного фильтра и гистерезиса (для телеметрии)
+ * @return ток в мА
+ */
+float CurrentSensor::getTelemetryCurrent_mA() const {
+    return telemetry_current_mA;
+}
+
+/**
+ * Получить последнее необработанное (до вычитания смещения и фильтрации) значение тока
+ * @return ток в мА
+ */
+float CurrentSensor::getRawCurrent_mA() const {
+    return raw_current_mA;
+}
+
+/**
+ * Получить последнее значение тока после вычитания смещения, до фильтрации
+ * @return ток в мА
+ */
+float CurrentSensor::getCorrectedCurrent_mA() const {
+    return corrected_current_mA;
+}
+
 /**
  * Получить текущее напряжение в вольтах
  * @return напряжение в В
@@ -124,21 +257,86 @@ bool CurrentSensor::isInitialized() const {
 }
 
 /**
- * Получить все измерения за один вызов
+ * Получить все измерения за один вызов (ток - телеметрический)
  * @param current_mA - ссылка для записи тока в мА
  * @param voltage_V - ссылка для записи напряжения в В
  * @param power_mW - ссылка для записи мощности в мВт
  */
 void CurrentSensor::getAllMeasurements(float& current_mA, float& voltage_V, float& power_mW) const {
-    current_mA = this->current_mA;
+    current_mA = this->telemetry_current_mA;
     voltage_V = this->voltage_V;
     power_mW = this->power_mW;
 }
 
 /**
- * Получить значение мертвой зоны
- * @return мертвая зона в мА
+ * Получить полосу гистерезиса телеметрии
+ * @return гистерезис в мА
+ */
+float CurrentSensor::getHysteresis() const {
+    return hysteresis_mA;
+}
+
+/**
+ * Установить полосу гистерезиса телеметрии
+ * @param hysteresis_mA - гистерезис в мА (0 - без гистерезиса)
+ */
+void CurrentSensor::setHysteresis(float hysteresis_mA) {
+    this->hysteresis_mA = (hysteresis_mA > 0.0f) ? hysteresis_mA : 0.0f;
+}
+
+/**
+ * Получить быстрый фильтр (для настройки)
+ * @return ссылка на фильтр
+ */
+CurrentFilter& CurrentSensor::getFastFilter() {
+    return fast_filter;
+}
+
+/**
+ * Получить медленный фильтр (для настройки)
+ * @return ссылка на фильтр
+ */
+CurrentFilter& CurrentSensor::getSlowFilter() {
+    return slow_filter;
+}
+
+/**
+ * Подключить двигатель: его скорость в момент измерения определяет,
+ * годится ли сэмпл для калибровки смещения нуля
+ * @param motor_driver - драйвер двигателя
+ */
+void CurrentSensor::attachMotor(const MotorDriver* motor_driver) {
+    motor = motor_driver;
+}
+
+/**
+ * Проверить, был ли двигатель остановлен при последнем измерении
+ * @return true если двигатель остановлен
+ */
+bool CurrentSensor::isMotorIdle() const {
+    return motor_idle;
+}
+
+/**
+ * Получить оценщик смещения нуля
+ * @return ссылка на оценщик
+ */
+IdleCalibrator& CurrentSensor::getIdleCalibrator() {
+    return idle_calibrator;
+}
+
+/**
+ * Получить интервал измерения
+ * @return интервал в мс
+ */
+unsigned long CurrentSensor::getMeasurementInterval() const {
+    return measurement_interval;
+}
+
+/**
+ * Получить время следующего измерения (для сна до него)
+ * @return время в мс по millis()
  */
-float CurrentSensor::getDeadZone() const {
-    return dead_zone_mA;
+unsigned long CurrentSensor::getNextMeasurementTime() const {
+    return last_measurement + measurement_interval;
 }
@@ -5,24 +5,66 @@
 #include <Wire.h>
 #include <Adafruit_INA219.h>
 #include "Config.h"
+#include "CurrentFilter.h"
+#include "IdleCalibrator.h"
+#include "MotorDriver.h"
 
 /**
  * Класс для измерения тока с помощью датчика INA219
  * Обеспечивает простое измерение тока, напряжения и мощности
+ *
+ * Ток проходит через два независимых фильтра экземпляра:
+ * - быстрый (getCurrent_mA) - для защиты, без гистерезиса
+ * - медленный (getTelemetryCurrent_mA) - для телеметрии, с гистерезисом:
+ *   выход следует за входом с отставанием не более полосы гистерезиса,
+ *   поэтому медленное нарастание тока не замораживается
+ * Перед фильтрацией вычитается смещение нуля, которое оценивает IdleCalibrator
+ * по сэмплам при остановленном двигателе (см. attachMotor).
  */
 class CurrentSensor {
 private:
+    // Регистры INA219 для высокочастотного чтения шунта
+    static constexpr uint8_t I2C_ADDRESS = 0x40;
+    static constexpr uint8_t REG_CONFIG = 0x00;
+    static constexpr uint8_t REG_SHUNT_VOLTAGE = 0x01;
+    // Режимы АЦП: 32 В и PGA /8 (+-320 мВ) как в setCalibration_32V_1A, меняется только разрядность.
+    // Остановлен: шина и шунт 12 бит (532 мкс), шаг шунта 10 мкВ - для калибровки смещения нуля.
+    // Вращение: шина 9 бит (84 мкс), шунт 10 бит (148 мкс), шаг шунта 40 мкВ; цикл 232 мкс
+    // короче RIPPLE_SAMPLE_INTERVAL_US, каждый сэмпл пульсаций - новое преобразование
+    static constexpr uint16_t CONFIG_PRECISE_ADC = 0x399F;
+    static constexpr uint16_t CONFIG_FAST_ADC = 0x380F;
+    
+
     Adafruit_INA219 ina219;    // Экземпляр датчика INA219
     uint8_t sda_pin;          // Пин SDA для I2C
     uint8_t scl_pin;          // Пин SCL для I2C
     bool sensor_initialized;   // Флаг инициализации датчика
-    float current_mA;          // Текущее значение тока в миллиамперах
+    float current_mA;          // Ток после быстрого фильтра (для защиты), мА
+    float telemetry_current_mA; // Ток после медленного фильтра и гистерезиса, мА
+    float raw_current_mA;      // Последнее необработанное значение тока (до вычитания смещения)
+    float corrected_current_mA; // Последнее значение тока после вычитания смещения, до фильтрации
     float voltage_V;           // Текущее значение напряжения в вольтах
     float power_mW;            // Текущее значение мощности в милливаттах
-    float last_valid_current;  // Последнее валидное значение тока
+    CurrentFilter fast_filter; // Фильтр для защиты
+    CurrentFilter slow_filter; // Фильтр для телеметрии
+    float hysteresis_mA;       // Полоса гистерезиса телеметрии в мА
+    IdleCalibrator idle_calibrator; // Оценка смещения нуля
+    const MotorDriver* motor;  // Двигатель, ток которого измеряется (nullptr - считается остановленным)
+    bool motor_idle;           // Двигатель был остановлен при последнем измерении
+    bool fast_adc;             // В INA219 записан быстрый режим АЦП
     unsigned long last_measurement;  // Время последнего измерения
+    unsigned long last_probe;  // Время последней попытки найти датчик
+    uint16_t probe_attempts;   // Количество попыток найти датчик
     const unsigned long measurement_interval = CURRENT_MEASUREMENT_INTERVAL; // Интервал измерения в мс
-    const float dead_zone_mA = CURRENT_DEADZONE_MA;  // Мертвая зона в мА
+
+    // Найти INA219 на шине и настроить его
+    bool probe();
+
+    // Записать 16-битный регистр INA219
+    bool writeRegister(uint8_t reg, uint16_t value);
+
+    // Переключить АЦП по состоянию двигателя: быстрый при вращении, 12 бит при остановке
+    void updateAdcMode();
 
 public:
     /**
@@ -34,22 +76,63 @@ public:
     
     /**
      * Инициализация датчика тока
+     * Одна попытка найти INA219; если датчика нет, поиск продолжает retryInit()
      * @return true если инициализация прошла успешно
      */
     bool begin();
     
+    /**
+     * Повторить поиск датчика, если он еще не найден (вызывать в основном цикле)
+     * @param current_time - текущее время в мс
+     * @return true если датчик найден именно в этом вызове
+     */
+    bool retryInit(unsigned long current_time);
+    
+    /**
+     * Получить количество попыток найти датчик
+     * @return количество попыток с начала работы
+     */
+    uint16_t getProbeAttempts() const;
+    
     /**
      * Обновить измерения тока, напряжения и мощности
      * Вызывать периодически для получения актуальных данных
+     * @return true если выполнено новое измерение
      */
-    void update();
+    bool update();
     
     /**
-     * Получить текущий ток в миллиамперах
+     * Прочитать регистр напряжения шунта (одна транзакция I2C, для счета пульсаций)
+     * Не обновляет фильтры и не зависит от интервала измерения
+     * @param raw - ссылка для записи отсчета (10 мкВ)
+     * @return true если чтение успешно
+     */
+    bool readShuntRaw(int16_t& raw);
+    
+    /**
+     * Получить ток после быстрого фильтра (для защиты)
      * @return ток в мА
      */
     float getCurrent_mA() const;
     
+    /**
+     * Получить ток после медленного фильтра и гистерезиса (для телеметрии)
+     * @return ток в мА
+     */
+    float getTelemetryCurrent_mA() const;
+    
+    /**
+     * Получить последнее необработанное (до вычитания смещения и фильтрации) значение тока
+     * @return ток в мА
+     */
+    float getRawCurrent_mA() const;
+    
+    /**
+     * Получить последнее значение тока после вычитания смещения, до фильтрации
+     * @return ток в мА
+     */
+    float getCorrectedCurrent_mA() const;
+    
     /**
      * Получить текущее напряжение в вольтах
      * @return напряжение в В
@@ -69,7 +152,7 @@ public:
     bool isInitialized() const;
     
     /**
-     * Получить все измерения за один вызов
+     * Получить все измерения за один вызов (ток - телеметрический)
      * @param current_mA - ссылка для записи тока в мА
      * @param voltage_V - ссылка для записи напряжения в В
      * @param power_mW - ссылка для записи мощности в мВт
@@ -77,10 +160,59 @@ public:
     void getAllMeasurements(float& current_mA, float& voltage_V, float& power_mW) const;
     
     /**
-     * Получить значение мертвой зоны
-     * @return мертвая зона в мА
+     * Получить полосу гистерезиса телеметрии
+     * @return гистерезис в мА
+     */
+    float getHysteresis() const;
+    
+    /**
+     * Установить полосу гистерезиса телеметрии
+     * @param hysteresis_mA - гистерезис в мА (0 - без гистерезиса)
+     */
+    void setHysteresis(float hysteresis_mA);
+    
+    /**
+     * Получить быстрый фильтр (для настройки)
+     * @return ссылка на фильтр
+     */
+    CurrentFilter& getFastFilter();
+    
+    /**
+     * Получить медленный фильтр (для настройки)
+     * @return ссылка на фильтр
+     */
+    CurrentFilter& getSlowFilter();
+    
+    /**
+     * Подключить двигатель: его скорость в момент измерения определяет,
+     * годится ли сэмпл для калибровки смещения нуля
+     * @param motor_driver - драйвер двигателя
+     */
+    void attachMotor(const MotorDriver* motor_driver);
+    
+    /**
+     * Проверить, был ли двигатель остановлен при последнем измерении
+     * @return true если двигатель остановлен
+     */
+    bool isMotorIdle() const;
+    
+    /**
+     * Получить оценщик смещения нуля
+     * @return ссылка на оценщик
+     */
+    IdleCalibrator& getIdleCalibrator();
+    
+    /**
+     * Получить интервал измерения
+     * @return интервал в мс
+     */
+    unsigned long getMeasurementInterval() const;
+
+    /**
+     * Получить время следующего измерения (для сна до него)
+     * @return время в мс по millis()
      */
-    float getDeadZone() const;
+    unsigned long getNextMeasurementTime() const;
 };
 
 #endif // CURRENT_SENSOR_H
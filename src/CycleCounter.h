@@ -0,0 +1,30 @@
+#ifndef CYCLE_COUNTER_H
+#define CYCLE_COUNTER_H
+
+#include <Arduino.h>
+
+/**
+ * Счетчик тактов процессора на основе DWT CYCCNT (Cortex-M3)
+ * Используется для измерения стоимости коротких участков кода
+ */
+class CycleCounter {
+public:
+    /**
+     * Включить счетчик тактов (однократно при старте)
+     */
+    static void begin() {
+        CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+        DWT->CYCCNT = 0;
+        DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+    }
+
+    /**
+     * Текущее значение счетчика тактов
+     * @return количество тактов (переполняется каждые ~60 с при 72 МГц)
+     */
+    static inline uint32_t now() {
+        return DWT->CYCCNT;
+    }
+};
+
+#endif // CYCLE_COUNTER_H
@@ -0,0 +1,204 @@
+#include "EnergyMeter.h"
+
+// Перевод: 1 мА*ч = 3.6 Кл = 3.6e9 нКл, 1 мВт*ч = 3.6 Дж = 3.6e9 нДж
+static constexpr float NANO_PER_MILLI_HOUR = 3.6e9f;
+
+/**
+ * Конструктор класса EnergyMeter
+ */
+EnergyMeter::EnergyMeter() {
+    reset();
+}
+
+/**
+ * Добавить измерение (вызывать при каждом новом измерении тока)
+ * @param current_uA - ток двигателя в мкА (без смещения нуля)
+ * @param voltage_mV - напряжение шины в мВ
+ * @param time_ms - время измерения в мс
+ */
+void EnergyMeter::addSample(int32_t current_uA, int32_t voltage_mV, uint32_t time_ms) {
+    int32_t power_uW = static_cast<int32_t>(static_cast<int64_t>(current_uA) * voltage_mV / 1000);
+
+    if (samples > 0) {
+        // Трапеция по фактическому интервалу, без деления на 2
+        uint32_t interval_ms = time_ms - last_sample_time;
+        charge_sum += (static_cast<int64_t>(last_current_uA) + current_uA) * interval_ms;
+        energy_sum += (static_cast<int64_t>(last_power_uW) + power_uW) * interval_ms;
+        if (interval_ms > max_interval_ms) {
+            max_interval_ms = interval_ms;
+        }
+    }
+
+    last_current_uA = current_uA;
+    last_power_uW = power_uW;
+    last_sample_time = time_ms;
+    samples++;
+
+    if (active && current_uA > active_peak_uA) {
+        active_peak_uA = current_uA;
+    }
+}
+
+/**
+ * Обновить состояние двигателя (вызывать каждый такт управления после проверки защиты)
+ * @param applied_speed - примененная скорость двигателя
+ * @param protection_active - защита заблокировала двигатель
+ * @param time_ms - текущее время в мс
+ */
+void EnergyMeter::updateState(int16_t applied_speed, bool protection_active, uint32_t time_ms) {
+    bool moving = applied_speed != 0;
+    Direction direction = ((applied_speed > 0) == (GRIPPER_CLOSE_DIRECTION > 0)) ? DIRECTION_CLOSE : DIRECTION_OPEN;
+
+    // Остановка или смена направления завершает движение
+    if (active && (!moving || direction != active_direction)) {
+        finishActuation(time_ms, protection_active);
+    }
+    if (!active && moving) {
+        active = true;
+        active_direction = direction;
+        active_start_time = time_ms;
+        active_start_charge = charge_sum;
+        active_start_energy = energy_sum;
+        active_peak_uA = last_current_uA;
+    }
+
+    // Время в защите относится к направлению, в котором она сработала
+    if (state_initialized && protection_active) {
+        uint32_t elapsed_ms = time_ms - last_state_time;
+        total_protection_ms += elapsed_ms;
+        stats[protection_direction].protection_ms += elapsed_ms;
+    }
+    state_initialized = true;
+    last_state_time = time_ms;
+}
+
+/**
+ * Завершить текущее движение
+ * @param time_ms - время завершения
+ * @param tripped - движение остановлено защитой
+ */
+void EnergyMeter::finishActuation(uint32_t time_ms, bool tripped) {
+    ActuationStats& s = stats[active_direction];
+    s.count++;
+    s.last_duration_ms = time_ms - active_start_time;
+    s.last_peak_uA = active_peak_uA;
+    s.last_charge_nC = (charge_sum - active_start_charge) / 2;
+    s.last_energy_nJ = (energy_sum - active_start_energy) / 2;
+    s.total_duration_ms += s.last_duration_ms;
+    s.total_charge_nC += s.last_charge_nC;
+    s.total_energy_nJ += s.last_energy_nJ;
+    if (active_peak_uA > s.max_peak_uA) {
+        s.max_peak_uA = active_peak_uA;
+    }
+    if (tripped) {
+        s.trips++;
+        protection_direction = active_direction;
+    }
+    active = false;
+}
+
+/**
+ * Сбросить все накопленные значения и статистику
+ */
+void EnergyMeter::reset() {
+    charge_sum = 0;
+    energy_sum = 0;
+    last_current_uA = 0;
+    last_power_uW = 0;
+    last_sample_time = 0;
+    samples = 0;
+    max_interval_ms = 0;
+    active = false;
+    active_direction = DIRECTION_CLOSE;
+    active_start_time = 0;
+    active_start_charge = 0;
+    active_start_energy = 0;
+    active_peak_uA = 0;
+    protection_direction = DIRECTION_CLOSE;
+    total_protection_ms = 0;
+    state_initialized = false;
+    last_state_time = 0;
+    memset(stats, 0, sizeof(stats));
+}
+
+/**
+ * Получить суммарный заряд
+ * @return заряд в мА*ч
+ */
+float EnergyMeter::getCharge_mAh() const {
+    return getCharge_nC() / NANO_PER_MILLI_HOUR;
+}
+
+/**
+ * Получить суммарную энергию
+ * @return энергия в мВт*ч
+ */
+float EnergyMeter::getEnergy_mWh() const {
+    return getEnergy_nJ() / NANO_PER_MILLI_HOUR;
+}
+
+/**
+ * Получить суммарный заряд в целых единицах
+ * @return заряд в нКл
+ */
+int64_t EnergyMeter::getCharge_nC() const {
+    return charge_sum / 2;
+}
+
+/**
+ * Получить суммарную энергию в целых единицах
+ * @return энергия в нДж
+ */
+int64_t EnergyMeter::getEnergy_nJ() const {
+    return energy_sum / 2;
+}
+
+/**
+ * Получить суммарное время в защите
+ * @return время в мс
+ */
+uint32_t EnergyMeter::getProtectionTime_ms() const {
+    return total_protection_ms;
+}
+
+/**
+ * Получить максимальный интервал между измерениями
+ * @return интервал в мс
+ */
+uint32_t EnergyMeter::getMaxInterval_ms() const {
+    return max_interval_ms;
+}
+
+/**
+ * Получить статистику движений
+ * @param direction - направление
+ * @return статистика
+ */
+const EnergyMeter::ActuationStats& EnergyMeter::getStats(Direction direction) const {
+    return stats[direction];
+}
+
+/**
+ * Вывести отчет в Serial
+ */
+void EnergyMeter::printReport() const {
+    Serial.print("Energy: ");
+    Serial.print(getCharge_mAh(), 4); Serial.print(" mAh, ");
+    Serial.print(getEnergy_mWh(), 4); Serial.print(" mWh, protection ");
+    Serial.print(total_protection_ms); Serial.print(" ms, samples ");
+    Serial.print(samples); Serial.print(", max interval ");
+    Serial.print(max_interval_ms); Serial.println(" ms");
+
+    const char* names[DIRECTION_COUNT] = {"Close", "Open"};
+    for (uint8_t i = 0; i < DIRECTION_COUNT; i++) {
+        const ActuationStats& s = stats[i];
+        Serial.print(names[i]); Serial.print(": count="); Serial.print(s.count);
+        Serial.print(" trips="); Serial.print(s.trips);
+        Serial.print(" last="); Serial.print(s.last_duration_ms);
+        Serial.print("ms/"); Serial.print(s.last_peak_uA / 1000.0f, 2);
+        Serial.print("mA/"); Serial.print(s.last_energy_nJ / NANO_PER_MILLI_HOUR, 4);
+        Serial.print("mWh avg="); Serial.print(s.count ? s.total_energy_nJ / NANO_PER_MILLI_HOUR / s.count : 0.0f, 4);
+        Serial.print("mWh peak="); Serial.print(s.max_peak_uA / 1000.0f, 2);
+        Serial.print("mA protection="); Serial.print(s.protection_ms); Serial.println("ms");
+    }
+}
@@ -0,0 +1,149 @@
+#ifndef ENERGY_METER_H
+#define ENERGY_METER_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+/**
+ * Счетчик заряда и энергии двигателя захвата
+ *
+ * Интегрирует ток (мкА) и мощность (мкВт = мкА * мВ / 1000) методом трапеций
+ * по фактическим интервалам между измерениями, поэтому неравномерные сэмплы
+ * не искажают результат. Аккумуляторы int64 хранят удвоенную сумму трапеций
+ * (мкА*мс = нКл, мкВт*мс = нДж) без деления на каждом шаге: при 1 А и 32 В
+ * переполнение наступит через годы непрерывной работы.
+ *
+ * Движение - интервал, в котором примененная скорость двигателя имеет один знак.
+ * Заряд и энергия движения - разность суммарных значений на его концах.
+ * Направление закрытия задается GRIPPER_CLOSE_DIRECTION.
+ */
+class EnergyMeter {
+public:
+    // Направление движения захвата
+    enum Direction : uint8_t {
+        DIRECTION_CLOSE = 0,
+        DIRECTION_OPEN = 1,
+        DIRECTION_COUNT = 2
+    };
+
+    // Статистика движений в одном направлении
+    struct ActuationStats {
+        uint32_t count;             // Количество движений
+        uint32_t trips;             // Из них завершено срабатыванием защиты
+        uint32_t total_duration_ms; // Суммарная длительность
+        uint32_t protection_ms;     // Время в защите после срабатывания в этом направлении
+        int64_t total_charge_nC;    // Суммарный заряд
+        int64_t total_energy_nJ;    // Суммарная энергия
+        int32_t max_peak_uA;        // Максимальный пиковый ток
+        uint32_t last_duration_ms;  // Последнее движение: длительность
+        int32_t last_peak_uA;       // Последнее движение: пиковый ток
+        int64_t last_charge_nC;     // Последнее движение: заряд
+        int64_t last_energy_nJ;     // Последнее движение: энергия
+    };
+
+private:
+    // Интегрирование
+    int64_t charge_sum;             // Удвоенный заряд (мкА*мс * 2)
+    int64_t energy_sum;             // Удвоенная энергия (мкВт*мс * 2)
+    int32_t last_current_uA;        // Предыдущий сэмпл тока
+    int32_t last_power_uW;          // Предыдущий сэмпл мощности
+    uint32_t last_sample_time;      // Время предыдущего сэмпла
+    uint32_t samples;               // Количество сэмплов
+    uint32_t max_interval_ms;       // Максимальный интервал между сэмплами
+
+    // Текущее движение
+    bool active;                    // Идет движение
+    Direction active_direction;     // Направление текущего движения
+    uint32_t active_start_time;     // Время начала
+    int64_t active_start_charge;    // Заряд в начале (удвоенный)
+    int64_t active_start_energy;    // Энергия в начале (удвоенная)
+    int32_t active_peak_uA;         // Пиковый ток
+
+    // Защита
+    Direction protection_direction; // Направление, в котором сработала защита
+    uint32_t total_protection_ms;   // Суммарное время в защите
+    bool state_initialized;         // Было хотя бы одно обновление состояния
+    uint32_t last_state_time;       // Время предыдущего обновления состояния
+
+    ActuationStats stats[DIRECTION_COUNT];
+
+    // Завершить текущее движение
+    void finishActuation(uint32_t time_ms, bool tripped);
+
+public:
+    /**
+     * Конструктор
+     */
+    EnergyMeter();
+
+    /**
+     * Добавить измерение (вызывать при каждом новом измерении тока)
+     * @param current_uA - ток двигателя в мкА (без смещения нуля)
+     * @param voltage_mV - напряжение шины в мВ
+     * @param time_ms - время измерения в мс
+     */
+    void addSample(int32_t current_uA, int32_t voltage_mV, uint32_t time_ms);
+
+    /**
+     * Обновить состояние двигателя (вызывать каждый такт управления после проверки защиты)
+     * @param applied_speed - примененная скорость двигателя
+     * @param protection_active - защита заблокировала двигатель
+     * @param time_ms - текущее время в мс
+     */
+    void updateState(int16_t applied_speed, bool protection_active, uint32_t time_ms);
+
+    /**
+     * Сбросить все накопленные значения и статистику
+     */
+    void reset();
+
+    /**
+     * Получить суммарный заряд
+     * @return заряд в мА*ч
+     */
+    float getCharge_mAh() const;
+
+    /**
+     * Получить суммарную энергию
+     * @return энергия в мВт*ч
+     */
+    float getEnergy_mWh() const;
+
+    /**
+     * Получить суммарный заряд в целых единицах
+     * @return заряд в нКл
+     */
+    int64_t getCharge_nC() const;
+
+    /**
+     * Получить суммарную энергию в целых единицах
+     * @return энергия в нДж
+     */
+    int64_t getEnergy_nJ() const;
+
+    /**
+     * Получить суммарное время в защите
+     * @return время в мс
+     */
+    uint32_t getProtectionTime_ms() const;
+
+    /**
+     * Получить максимальный интервал между измерениями
+     * @return интервал в мс
+     */
+    uint32_t getMaxInterval_ms() const;
+
+    /**
+     * Получить статистику движений
+     * @param direction - направление
+     * @return статистика
+     */
+    const ActuationStats& getStats(Direction direction) const;
+
+    /**
+     * Вывести отчет в Serial
+     */
+    void printReport() const;
+};
+
+#endif // ENERGY_METER_H
@@ -0,0 +1,80 @@
+#ifndef FAST_PIN_H
+#define FAST_PIN_H
+
+#include <Arduino.h>
+
+/**
+ * Параметры пина, вычисляемые на этапе компиляции (STM32F103, BluePill)
+ * Порт, маска бита, таймер и канал ШИМ определяются по PinName без
+ * обращения к таблицам ядра Arduino во время работы.
+ */
+template <PinName Pin>
+struct FastPin {
+    static constexpr uint32_t PORT_INDEX = STM_PORT(Pin);
+    static constexpr uint32_t BIT = STM_PIN(Pin);
+    static constexpr uint32_t MASK = 1UL << BIT;
+    static constexpr uint32_t GPIO_BASE = GPIOA_BASE + PORT_INDEX * (GPIOB_BASE - GPIOA_BASE);
+
+    /**
+     * Таймер ШИМ для пина (без ремапа), 0 если пин не выводится на таймер
+     */
+    static constexpr uint32_t timerBase() {
+        return (Pin >= PA_0 && Pin <= PA_3) ? TIM2_BASE :
+               (Pin == PA_6 || Pin == PA_7 || Pin == PB_0 || Pin == PB_1) ? TIM3_BASE :
+               (Pin >= PA_8 && Pin <= PA_11) ? TIM1_BASE :
+               (Pin >= PB_6 && Pin <= PB_9) ? TIM4_BASE : 0;
+    }
+
+    /**
+     * Канал таймера ШИМ для пина (1..4), 0 если пин не выводится на таймер
+     */
+    static constexpr uint32_t timerChannel() {
+        return (Pin >= PA_0 && Pin <= PA_3) ? (Pin - PA_0) + 1 :
+               (Pin == PA_6 || Pin == PA_7) ? (Pin - PA_6) + 1 :
+               (Pin == PB_0 || Pin == PB_1) ? (Pin - PB_0) + 3 :
+               (Pin >= PA_8 && Pin <= PA_11) ? (Pin - PA_8) + 1 :
+               (Pin >= PB_6 && Pin <= PB_9) ? (Pin - PB_6) + 1 : 0;
+    }
+
+    static constexpr uint32_t TIMER_BASE = timerBase();
+    static constexpr uint32_t TIMER_CHANNEL = timerChannel();
+    // Сдвиг поля OCxM канала в CCMR1/CCMR2 (нечетный канал - биты 6:4, четный - 14:12)
+    static constexpr uint32_t MODE_SHIFT = (TIMER_CHANNEL % 2 == 1) ? 4 : 12;
+
+    /**
+     * Регистры порта GPIO
+     */
+    static inline GPIO_TypeDef* gpio() {
+        return reinterpret_cast<GPIO_TypeDef*>(GPIO_BASE);
+    }
+
+    /**
+     * Регистры таймера ШИМ
+     */
+    static inline TIM_TypeDef* timer() {
+        return reinterpret_cast<TIM_TypeDef*>(TIMER_BASE);
+    }
+
+    /**
+     * Регистр сравнения канала ШИМ (CCR1..CCR4 идут подряд)
+     */
+    static inline volatile uint32_t* compareRegister() {
+        return &timer()->CCR1 + (TIMER_CHANNEL - 1);
+    }
+
+    /**
+     * Регистр режима канала ШИМ (CCMR1 - каналы 1, 2; CCMR2 - каналы 3, 4)
+     */
+    static inline volatile uint32_t* modeRegister() {
+        return (TIMER_CHANNEL <= 2) ? &timer()->CCMR1 : &timer()->CCMR2;
+    }
+
+    /**
+     * Прочитать уровень пина одним чтением регистра IDR
+     */
+    static inline bool read() {
+        return (gpio()->IDR & MASK) != 0;
+    }
+};
+
+#endif // FAST_PIN_H
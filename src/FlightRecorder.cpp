@@ -0,0 +1,265 @@
+#include "FlightRecorder.h"
+#include "CycleCounter.h"
+
+/**
+ * Конструктор класса FlightRecorder
+ */
+FlightRecorder::FlightRecorder()
+    : head_block(0), block_sequence(0), blocks_used(0), last_sample{0, 0, 0, 0, 0, 0},
+      last_time_ms(0), last_delta_ms(0), trigger_reason(TRIGGER_NONE), trigger_block(0),
+      trigger_time_ms(0), post_remaining(0), frozen(false),
+      samples_recorded(0), encode_cycles_max(0), encode_cycles_sum(0) {
+}
+
+/**
+ * Добавить сэмпл (вызывать с частотой сбора данных)
+ * @param sample - данные сэмпла
+ * @param time_ms - время сэмпла в мс
+ */
+void FlightRecorder::record(const RecorderSample& sample, uint32_t time_ms) {
+    if (frozen) {
+        return;
+    }
+
+    uint32_t start_cycles = CycleCounter::now();
+
+    // Начать новый блок, если в текущем нет места под запись максимального размера
+    uint8_t* block = buffer[head_block];
+    if (blocks_used == 0 || block[2] + MAX_RECORD_SIZE > BLOCK_SIZE || block[3] == 0xFF) {
+        // Пост-запись не должна затирать блок, в котором сработал триггер
+        if (trigger_reason != TRIGGER_NONE &&
+            static_cast<uint16_t>(block_sequence + 1 - trigger_block) >= BLOCK_COUNT) {
+            frozen = true;
+            return;
+        }
+        startBlock(time_ms);
+        block = buffer[head_block];
+    }
+
+    uint32_t delta_ms = time_ms - last_time_ms;
+    uint8_t length = encodeRecord(block + block[2], sample, delta_ms);
+    block[2] += length;
+    block[3]++;
+
+    last_sample = sample;
+    last_time_ms = time_ms;
+    last_delta_ms = delta_ms;
+    samples_recorded++;
+
+    // Окно после триггера
+    if (trigger_reason != TRIGGER_NONE && post_remaining > 0) {
+        post_remaining--;
+        if (post_remaining == 0) {
+            frozen = true;
+        }
+    }
+
+    uint32_t cycles = CycleCounter::now() - start_cycles;
+    if (cycles > encode_cycles_max) {
+        encode_cycles_max = cycles;
+    }
+    encode_cycles_sum += cycles;
+}
+
+/**
+ * Начать новый блок: заголовок и сброс базы дельта-кодирования
+ * @param time_ms - время первого сэмпла блока
+ */
+void FlightRecorder::startBlock(uint32_t time_ms) {
+    if (blocks_used == 0) {
+        head_block = 0;
+        block_sequence = 0;
+    } else {
+        head_block = (head_block + 1) % BLOCK_COUNT;
+        block_sequence++;
+    }
+    if (blocks_used < BLOCK_COUNT) {
+        blocks_used++;
+    }
+
+    uint8_t* block = buffer[head_block];
+    block[0] = block_sequence & 0xFF;
+    block[1] = block_sequence >> 8;
+    block[2] = HEADER_SIZE;
+    block[3] = 0;
+    block[4] = time_ms & 0xFF;
+    block[5] = (time_ms >> 8) & 0xFF;
+    block[6] = (time_ms >> 16) & 0xFF;
+    block[7] = (time_ms >> 24) & 0xFF;
+
+    // Первая запись блока кодируется относительно нулевого сэмпла
+    last_sample = RecorderSample{0, 0, 0, 0, 0, 0};
+    last_time_ms = time_ms;
+    last_delta_ms = 0;
+}
+
+/**
+ * Закодировать одну запись
+ * @param out - указатель на место записи (не менее MAX_RECORD_SIZE байт)
+ * @param sample - текущий сэмпл
+ * @param delta_ms - приращение времени относительно предыдущего сэмпла
+ * @return количество записанных байт
+ */
+uint8_t FlightRecorder::encodeRecord(uint8_t* out, const RecorderSample& sample, uint32_t delta_ms) {
+    int32_t deltas[FIELD_COUNT] = {
+        static_cast<int32_t>(sample.pulse_us) - last_sample.pulse_us,
+        static_cast<int32_t>(sample.current_dmA) - last_sample.current_dmA,
+        static_cast<int32_t>(sample.voltage_mV) - last_sample.voltage_mV,
+        static_cast<int32_t>(sample.commanded_speed) - last_sample.commanded_speed,
+        static_cast<int32_t>(sample.applied_speed) - last_sample.applied_speed,
+        static_cast<int32_t>(sample.state) - last_sample.state
+    };
+
+    // Приращение времени ограничено тремя байтами varint
+    if (delta_ms > 0x1FFFFF) {
+        delta_ms = 0x1FFFFF;
+    }
+
+    uint8_t mask = 0;
+    for (uint8_t i = 0; i < FIELD_COUNT; i++) {
+        if (deltas[i] != 0) {
+            mask |= (1 << i);
+        }
+    }
+    if (delta_ms != last_delta_ms) {
+        mask |= MASK_TIME_DELTA;
+    }
+
+    uint8_t length = 0;
+    out[length++] = mask;
+    if (mask & MASK_TIME_DELTA) {
+        length += writeVarint(out + length, delta_ms);
+    }
+    for (uint8_t i = 0; i < FIELD_COUNT; i++) {
+        if (mask & (1 << i)) {
+            length += writeVarint(out + length, zigzag(deltas[i]));
+        }
+    }
+    return length;
+}
+
+/**
+ * Записать беззнаковое число в формате varint (7 бит на байт)
+ * @param out - указатель на место записи
+ * @param value - значение (не более 21 бита)
+ * @return количество записанных байт (1..3)
+ */
+uint8_t FlightRecorder::writeVarint(uint8_t* out, uint32_t value) {
+    uint8_t length = 0;
+    while (value >= 0x80 && length < 2) {
+        out[length++] = static_cast<uint8_t>(value | 0x80);
+        value >>= 7;
+    }
+    out[length++] = static_cast<uint8_t>(value);
+    return length;
+}
+
+/**
+ * Zigzag-преобразование: малые по модулю значения -> малые беззнаковые
+ * @param value - знаковое значение
+ * @return беззнаковое значение
+ */
+uint32_t FlightRecorder::zigzag(int32_t value) {
+    return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+}
+
+/**
+ * Зафиксировать событие
+ * @param reason - причина срабатывания
+ * @param time_ms - время события
+ */
+void FlightRecorder::trigger(TriggerReason reason, uint32_t time_ms) {
+    if (trigger_reason != TRIGGER_NONE || frozen) {
+        return;
+    }
+
+    trigger_reason = reason;
+    trigger_time_ms = time_ms;
+    trigger_block = block_sequence;
+    post_remaining = FLIGHT_RECORDER_POST_SAMPLES;
+    if (post_remaining == 0) {
+        frozen = true;
+    }
+}
+
+/**
+ * Сбросить заморозку и продолжить запись
+ */
+void FlightRecorder::rearm() {
+    trigger_reason = TRIGGER_NONE;
+    post_remaining = 0;
+    frozen = false;
+}
+
+/**
+ * Проверить, заморожен ли буфер
+ * @return true если окно события записано и ожидает выгрузки
+ */
+bool FlightRecorder::isFrozen() const {
+    return frozen;
+}
+
+/**
+ * Проверить, сработал ли триггер
+ * @return true если триггер сработал (идет пост-запись или буфер заморожен)
+ */
+bool FlightRecorder::isTriggered() const {
+    return trigger_reason != TRIGGER_NONE;
+}
+
+/**
+ * Выгрузить содержимое буфера в Serial (блоки от старых к новым в hex)
+ */
+void FlightRecorder::dump() const {
+    static const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+    Serial.print("REC BEGIN reason="); Serial.print(trigger_reason);
+    Serial.print(" trigger_ms="); Serial.print(trigger_time_ms);
+    Serial.print(" blocks="); Serial.print(blocks_used);
+    Serial.print(" frozen="); Serial.println(frozen ? 1 : 0);
+
+    uint16_t first = (blocks_used < BLOCK_COUNT) ? 0 : (head_block + 1) % BLOCK_COUNT;
+    for (uint16_t n = 0; n < blocks_used; n++) {
+        const uint8_t* block = buffer[(first + n) % BLOCK_COUNT];
+        Serial.print("REC ");
+        for (uint8_t i = 0; i < block[2]; i++) {
+            Serial.print(HEX_DIGITS[block[i] >> 4]);
+            Serial.print(HEX_DIGITS[block[i] & 0x0F]);
+        }
+        Serial.println();
+    }
+
+    Serial.println("REC END");
+}
+
+/**
+ * Вывести статистику самописца и стоимости кодирования
+ */
+void FlightRecorder::printStats() const {
+    uint32_t bytes_used = 0;
+    uint32_t samples_in_buffer = 0;
+    for (uint16_t i = 0; i < blocks_used; i++) {
+        bytes_used += buffer[i][2];
+        samples_in_buffer += buffer[i][3];
+    }
+
+    Serial.print("Recorder: "); Serial.print(samples_in_buffer);
+    Serial.print(" samples in "); Serial.print(blocks_used);
+    Serial.print("/"); Serial.print(BLOCK_COUNT);
+    Serial.print(" blocks, "); Serial.print(bytes_used);
+    Serial.print("/"); Serial.print(sizeof(buffer)); Serial.println(" bytes");
+
+    if (samples_in_buffer > 0) {
+        Serial.print("Bytes/sample: ");
+        Serial.println(static_cast<float>(bytes_used) / samples_in_buffer, 2);
+    }
+
+    Serial.print("Encode cycles: max="); Serial.print(encode_cycles_max);
+    Serial.print(" mean=");
+    Serial.print(samples_recorded ? static_cast<uint32_t>(encode_cycles_sum / samples_recorded) : 0);
+    Serial.print(" (limit "); Serial.print(MAX_RECORD_SIZE); Serial.println(" bytes/sample)");
+
+    Serial.print("Trigger: "); Serial.print(trigger_reason);
+    Serial.print(" post_remaining="); Serial.print(post_remaining);
+    Serial.print(" frozen="); Serial.println(frozen ? 1 : 0);
+}
@@ -0,0 +1,145 @@
+#ifndef FLIGHT_RECORDER_H
+#define FLIGHT_RECORDER_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+/**
+ * Один сэмпл бортового самописца
+ */
+struct RecorderSample {
+    uint16_t pulse_us;        // Длина импульса управления (мкс)
+    int16_t current_dmA;      // Ток (0.1 мА)
+    uint16_t voltage_mV;      // Напряжение (мВ)
+    int16_t commanded_speed;  // Заданная скорость (-255..255)
+    int16_t applied_speed;    // Примененная скорость (-255..255)
+    uint8_t state;            // Флаги состояния контроллера (RECORDER_STATE_*)
+};
+
+// Флаги состояния контроллера в сэмпле
+#define RECORDER_STATE_PROTECTION  0x01  // Защита сработала
+#define RECORDER_STATE_STARTUP     0x02  // Задержка после старта двигателя
+#define RECORDER_STATE_RAMPING     0x04  // Активен плавный переход
+#define RECORDER_STATE_SENSOR_OK   0x08  // Датчик тока инициализирован
+#define RECORDER_STATE_DIGITAL     0x10  // Управление по двоичному протоколу
+
+/**
+ * Кольцевой бортовой самописец в RAM с дельта-кодированием
+ *
+ * Буфер разбит на блоки по FLIGHT_RECORDER_BLOCK_SIZE байт. Самый старый блок
+ * перезаписывается целиком, поэтому каждый блок декодируется независимо.
+ *
+ * Формат блока:
+ *   [0..1] номер блока (uint16, LE)
+ *   [2]    занято байт в блоке, включая заголовок
+ *   [3]    количество сэмплов в блоке
+ *   [4..7] время первого сэмпла (мс, uint32, LE)
+ *   далее записи сэмплов:
+ *     байт маски: биты 0..5 - изменившиеся поля в порядке структуры
+ *                 RecorderSample, бит 7 - присутствует приращение времени
+ *     [varint]    приращение времени в мс (если бит 7), иначе как у предыдущей записи
+ *     [varint]    zigzag-дельта для каждого изменившегося поля
+ * Первая запись блока кодируется относительно нулевого сэмпла, поэтому
+ * содержит все ненулевые поля. Максимальный размер записи ограничен
+ * (MAX_RECORD_SIZE), стоимость кодирования не зависит от истории.
+ *
+ * После срабатывания триггера записывается FLIGHT_RECORDER_POST_SAMPLES
+ * сэмплов, затем буфер замораживается до выгрузки и повторного запуска.
+ */
+class FlightRecorder {
+public:
+    // Причины срабатывания триггера
+    enum TriggerReason : uint8_t {
+        TRIGGER_NONE = 0,
+        TRIGGER_PROTECTION = 1,   // Срабатывание защиты по току
+        TRIGGER_COMMAND = 2       // Команда оператора
+    };
+
+private:
+    // Константы
+    static constexpr uint16_t BLOCK_SIZE = FLIGHT_RECORDER_BLOCK_SIZE;
+    static constexpr uint16_t BLOCK_COUNT = FLIGHT_RECORDER_BUFFER_BYTES / FLIGHT_RECORDER_BLOCK_SIZE;
+    static constexpr uint8_t HEADER_SIZE = 8;
+    static constexpr uint8_t FIELD_COUNT = 6;
+    static constexpr uint8_t MAX_RECORD_SIZE = 1 + 3 + FIELD_COUNT * 3;
+    static constexpr uint8_t MASK_TIME_DELTA = 0x80;
+
+    static_assert(BLOCK_COUNT >= 4, "Буфер самописца должен содержать хотя бы 4 блока");
+    static_assert(BLOCK_SIZE <= 255, "Размер блока должен помещаться в байт заголовка");
+
+    // Поля класса
+    uint8_t buffer[BLOCK_COUNT][BLOCK_SIZE];  // Кольцевой буфер блоков
+    uint16_t head_block;          // Текущий заполняемый блок
+    uint16_t block_sequence;      // Номер текущего блока
+    uint16_t blocks_used;         // Количество блоков с данными
+    RecorderSample last_sample;   // Предыдущий сэмпл (база для дельт)
+    uint32_t last_time_ms;        // Время предыдущего сэмпла
+    uint32_t last_delta_ms;       // Предыдущее приращение времени
+
+    TriggerReason trigger_reason; // Причина срабатывания триггера
+    uint16_t trigger_block;       // Номер блока с сэмплом триггера
+    uint32_t trigger_time_ms;     // Время срабатывания
+    uint16_t post_remaining;      // Сколько сэмплов осталось записать после триггера
+    bool frozen;                  // Буфер заморожен
+
+    // Статистика стоимости кодирования
+    uint32_t samples_recorded;    // Количество записанных сэмплов
+    uint32_t encode_cycles_max;   // Максимум тактов на сэмпл
+    uint64_t encode_cycles_sum;   // Сумма тактов (для среднего)
+
+    // Приватные вспомогательные методы
+    void startBlock(uint32_t time_ms);
+    uint8_t encodeRecord(uint8_t* out, const RecorderSample& sample, uint32_t delta_ms);
+    static uint8_t writeVarint(uint8_t* out, uint32_t value);
+    static uint32_t zigzag(int32_t value);
+
+public:
+    /**
+     * Конструктор
+     */
+    FlightRecorder();
+
+    /**
+     * Добавить сэмпл (вызывать с частотой сбора данных)
+     * @param sample - данные сэмпла
+     * @param time_ms - время сэмпла в мс
+     */
+    void record(const RecorderSample& sample, uint32_t time_ms);
+
+    /**
+     * Зафиксировать событие: после записи окна пост-триггера буфер замораживается
+     * Повторный триггер до выгрузки игнорируется
+     * @param reason - причина срабатывания
+     * @param time_ms - время события
+     */
+    void trigger(TriggerReason reason, uint32_t time_ms);
+
+    /**
+     * Сбросить заморозку и продолжить запись
+     */
+    void rearm();
+
+    /**
+     * Проверить, заморожен ли буфер
+     * @return true если окно события записано и ожидает выгрузки
+     */
+    bool isFrozen() const;
+
+    /**
+     * Проверить, сработал ли триггер
+     * @return true если триггер сработал (идет пост-запись или буфер заморожен)
+     */
+    bool isTriggered() const;
+
+    /**
+     * Выгрузить содержимое буфера в Serial (блоки от старых к новым в hex)
+     */
+    void dump() const;
+
+    /**
+     * Вывести статистику самописца и стоимости кодирования
+     */
+    void printStats() const;
+};
+
+#endif // FLIGHT_RECORDER_H
@@ -0,0 +1,414 @@
+#include "GripperController.h"
+
+/**
+ * Конструктор класса GripperController
+ * @param motor - драйвер двигателя
+ * @param sensor - датчик тока
+ */
+GripperController::GripperController(MotorDriver& motor, CurrentSensor& sensor)
+    : motor(motor), sensor(sensor), motor_speed(MOTOR_SPEED_STOP), protection_active(false),
+      protection_direction(0), motor_start_time(0), motor_was_running(false),
+      startup_delay_active(false),
+      source(SOURCE_RC), last_digital_time(0), jaw(nullptr), output_speed(MOTOR_SPEED_STOP),
+      target_active(false), target_position(0), position_control(nullptr) {
+}
+
+/**
+ * Проверка защиты от перегрузки (вызывать каждый такт управления)
+ * @param current_time - текущее время в мс
+ * @return true если защита сработала на этом такте
+ */
+bool GripperController::checkCurrentProtection(unsigned long current_time) {
+    if (!sensor.isInitialized()) return false;
+
+    bool tripped = false;
+
+    // Проверяем, работает ли двигатель
+    uint8_t pin_a_value, pin_b_value;
+    motor.getDiagnostics(pin_a_value, pin_b_value);
+
+    if (pin_a_value > 0 || pin_b_value > 0) {
+        // Двигатель работает
+        if (!motor_was_running) {
+            // Двигатель только что запустился
+            motor_start_time = current_time;
+            motor_was_running = true;
+            startup_delay_active = true;
+            Serial.print("Motor started, waiting "); Serial.print(runtimeConfig.motor_start_delay_ms);
+            Serial.println("ms for startup...");
+        }
+
+        // Проверяем ток только после завершения задержки старта
+        if (startup_delay_active && current_time - motor_start_time >= runtimeConfig.motor_start_delay_ms) {
+            startup_delay_active = false;
+            Serial.println("Startup delay completed, current protection active");
+        }
+
+        // Измеряем ток только если задержка старта завершена
+        if (!startup_delay_active) {
+            float current_mA = sensor.getCurrent_mA();
+
+            // Защита при превышении абсолютного значения тока
+            if (current_mA >= runtimeConfig.protection_threshold_mA) {
+                if (!protection_active) {
+                    protection_active = true;
+                    protection_direction = motor_speed; // Запоминаем направление при срабатывании
+                    tripped = true;
+                    Serial.print("ЗАЩИТА! Ток: "); Serial.print(current_mA, 1);
+                    Serial.print("mA, направление: "); Serial.println(motor_speed > 0 ? "ВПЕРЕД" : "НАЗАД");
+                    
+                    // Упор у края хода привязывает оценку положения
+                    if (jaw != nullptr) {
+                        jaw->onStall(motor_speed);
+                    }
+                    if (position_control != nullptr) {
+                        position_control->onStall(motor_speed);
+                    }
+                }
+                motor.stop();
+                output_speed = MOTOR_SPEED_STOP;
+                // Следующий пуск (в т.ч. регулятором положения до следующего такта) - с задержкой старта
+                motor_was_running = false;
+            }
+        }
+    } else {
+        // Двигатель остановлен
+        motor_was_running = false;
+        startup_delay_active = false;
+    }
+
+    return tripped;
+}
+
+/**
+ * Обработать новый импульс управления
+ * @param pulse_width_us - длина импульса в микросекундах
+ */
+void GripperController::processPulse(uint32_t pulse_width_us) {
+    // Цифровое управление имеет приоритет над RC
+    if (source == SOURCE_DIGITAL) {
+        return;
+    }
+    
+    bool valid = pulse_width_us >= PWM_MIN_US && pulse_width_us <= PWM_MAX_US;
+
+    // Импульс задает положение губок, пока ноль энкодера известен
+    if (POSITION_CONTROL_RC && valid && position_control != nullptr && position_control->isHomed()) {
+        uint16_t permille = (pulse_width_us - PWM_MIN_US) * 1000UL / (PWM_MAX_US - PWM_MIN_US);
+        if (!position_control->isActive()) {
+            Serial.println("Control: RC position");
+        }
+        position_control->setTarget(permille);
+        return;
+    }
+    cancelPositionTarget();
+
+    int16_t new_speed = MOTOR_SPEED_STOP;
+
+    if (valid) {
+        if (pulse_width_us < runtimeConfig.pwm_deadzone_min_us) {
+            new_speed = MOTOR_SPEED_REVERSE;
+        } else if (pulse_width_us > runtimeConfig.pwm_deadzone_max_us) {
+            new_speed = MOTOR_SPEED_FORWARD;
+        }
+    }
+
+    if (applySpeedCommand(new_speed)) {
+        printSpeedChange();
+        Serial.print(" (pulse: "); Serial.print(pulse_width_us); Serial.println("us)");
+    }
+}
+
+/**
+ * Применить команду скорости с учетом защиты
+ * @param new_speed - требуемая скорость
+ * @return true если заданная скорость изменилась
+ */
+bool GripperController::applySpeedCommand(int16_t new_speed) {
+    // Сброс защиты при движении в противоположном направлении
+    if (protection_active && new_speed != MOTOR_SPEED_STOP) {
+        if ((protection_direction > 0 && new_speed < 0) ||
+            (protection_direction < 0 && new_speed > 0)) {
+            protection_active = false;
+        }
+    }
+
+    // Принудительная остановка при защите
+    if (protection_active) {
+        new_speed = MOTOR_SPEED_STOP;
+    }
+
+    // Применяем новую скорость
+    if (new_speed == motor_speed) {
+        return false;
+    }
+    motor_speed = new_speed;
+    driveMotor();
+    return true;
+}
+
+/**
+ * Передать заданную скорость драйверу с учетом мягких упоров
+ */
+void GripperController::driveMotor() {
+    int16_t speed = (jaw != nullptr) ? jaw->limitSpeed(motor_speed) : motor_speed;
+    if (speed != output_speed) {
+        // Снижение скорости мягким упором - без плавного перехода, иначе удар о край
+        bool slowing = speed != motor_speed &&
+                       ((speed > 0 && speed < output_speed) || (speed < 0 && speed > output_speed));
+        output_speed = speed;
+        if (slowing) {
+            motor.setSpeed(speed);
+        } else {
+            motor.setSpeedSmooth(speed);
+        }
+    }
+}
+
+/**
+ * Отменить заданное положение (переход к управлению скоростью)
+ */
+void GripperController::cancelPositionTarget() {
+    target_active = false;
+    if (position_control != nullptr && position_control->isActive()) {
+        position_control->disable();
+        // Двигатель останавливается; следующая команда скорости применится заново
+        motor_speed = MOTOR_SPEED_STOP;
+        driveMotor();
+    }
+}
+
+/**
+ * Вывести сообщение о смене скорости (без перевода строки)
+ */
+void GripperController::printSpeedChange() const {
+    Serial.print("Motor: ");
+    if (motor_speed == MOTOR_SPEED_STOP) {
+        Serial.print("STOP");
+    } else if (motor_speed > MOTOR_SPEED_STOP) {
+        Serial.print("FORWARD");
+    } else {
+        Serial.print("REVERSE");
+    }
+}
+
+/**
+ * Установить скорость цифровой командой (перехватывает управление у RC)
+ * @param speed - скорость от -255 до +255
+ * @param current_time - текущее время в мс
+ * @return false если команда не применена из-за защиты
+ */
+bool GripperController::setDigitalSpeed(int16_t speed, unsigned long current_time) {
+    source = SOURCE_DIGITAL;
+    cancelPositionTarget();
+    last_digital_time = current_time;
+
+    if (applySpeedCommand(constrain(speed, MOTOR_SPEED_REVERSE, MOTOR_SPEED_FORWARD))) {
+        printSpeedChange();
+        Serial.print(" "); Serial.print(motor_speed); Serial.println(" (digital)");
+    }
+    return !(protection_active && speed != MOTOR_SPEED_STOP);
+}
+
+/**
+ * Остановить двигатель цифровой командой (перехватывает управление у RC)
+ * @param current_time - текущее время в мс
+ */
+void GripperController::digitalStop(unsigned long current_time) {
+    setDigitalSpeed(MOTOR_SPEED_STOP, current_time);
+}
+
+/**
+ * Вернуть управление каналу RC
+ */
+void GripperController::releaseDigital() {
+    if (source == SOURCE_DIGITAL) {
+        source = SOURCE_RC;
+        cancelPositionTarget();
+        Serial.println("Control: RC");
+    }
+}
+
+/**
+ * Отметить принятый кадр цифрового управления (пульс связи)
+ * @param current_time - текущее время в мс
+ */
+void GripperController::digitalHeartbeat(unsigned long current_time) {
+    last_digital_time = current_time;
+}
+
+/**
+ * Проверить таймаут цифрового управления (вызывать каждый такт)
+ * @param current_time - текущее время в мс
+ * @return true если связь потеряна на этом такте
+ */
+bool GripperController::checkDigitalTimeout(unsigned long current_time) {
+    if (source != SOURCE_DIGITAL || current_time - last_digital_time < runtimeConfig.heartbeat_timeout_ms) {
+        return false;
+    }
+
+    // Потеря связи - безопасная остановка и возврат к RC
+    source = SOURCE_RC;
+    cancelPositionTarget();
+    if (applySpeedCommand(MOTOR_SPEED_STOP)) {
+        printSpeedChange();
+        Serial.println(" (link timeout)");
+    }
+    Serial.println("Control: RC (link timeout)");
+    return true;
+}
+
+/**
+ * Подключить оценку положения губок (мягкие упоры, хоминг по упору, заданное положение)
+ * @param jaw_position - оценка положения
+ */
+void GripperController::attachJawPosition(JawPosition* jaw_position) {
+    jaw = jaw_position;
+}
+
+/**
+ * Обновить положение и движение к заданному положению (вызывать каждый такт)
+ * @param current_time - текущее время в мс
+ */
+void GripperController::updateJaw(unsigned long current_time) {
+    if (jaw == nullptr) return;
+
+    jaw->update(motor.getSpeed(), sensor.getCurrent_mA(), current_time);
+
+    // Двигателем управляет регулятор по энкодеру
+    if (position_control != nullptr && position_control->isActive()) {
+        return;
+    }
+
+    // Упор на пути к заданному положению - дальше двигаться некуда
+    if (target_active && jaw->isStalled()) {
+        target_active = false;
+        applySpeedCommand(MOTOR_SPEED_STOP);
+        Serial.println("Jaw: stalled before target");
+    }
+
+    if (target_active) {
+        // Полная скорость вдали от цели, линейное снижение в зоне JAW_SOFT_ZONE_RIPPLES
+        int32_t error = target_position - jaw->getPosition();
+        int32_t distance = (error >= 0) ? error : -error;
+        int16_t speed = MOTOR_SPEED_STOP;
+        if (distance > JAW_TARGET_TOLERANCE_RIPPLES) {
+            int32_t limit = JAW_SOFT_MIN_SPEED + (MOTOR_SPEED_FORWARD - JAW_SOFT_MIN_SPEED) * distance / JAW_SOFT_ZONE_RIPPLES;
+            speed = min(limit, static_cast<int32_t>(MOTOR_SPEED_FORWARD));
+            if ((error > 0) != (GRIPPER_CLOSE_DIRECTION > 0)) {
+                speed = -speed;
+            }
+        }
+        if (applySpeedCommand(speed)) {
+            return;
+        }
+    }
+
+    // Ограничение мягких упоров меняется вместе с положением
+    if (!protection_active) {
+        driveMotor();
+    }
+}
+
+/**
+ * Подключить регулятор положения по энкодеру (вместо оценки по пульсациям для заданного положения)
+ * @param controller - регулятор положения
+ */
+void GripperController::attachPositionControl(PositionController* controller) {
+    position_control = controller;
+}
+
+/**
+ * Обновить регулятор положения (вызывать каждые POSITION_LOOP_INTERVAL_US)
+ * @param encoder_count - расширенный счетчик энкодера
+ * @param interval_us - время с предыдущего обновления в мкс
+ */
+void GripperController::updatePositionControl(int32_t encoder_count, uint32_t interval_us) {
+    if (position_control == nullptr) return;
+
+    // Счетчик отслеживается и в режиме скорости - для хоминга по упору
+    int16_t duty = position_control->update(encoder_count, interval_us);
+    if (!position_control->isActive()) return;
+
+    // Защита: двигатель стоит, пока регулятор не потребует обратного хода
+    if (protection_active) {
+        if ((protection_direction > 0 && duty < 0) || (protection_direction < 0 && duty > 0)) {
+            protection_active = false;
+        } else {
+            position_control->resetIntegral();
+            duty = MOTOR_SPEED_STOP;
+        }
+    }
+
+    // Заполнение меняется каждый период регулятора - без плавного перехода
+    motor_speed = duty;
+    if (duty != output_speed) {
+        output_speed = duty;
+        motor.setSpeed(duty);
+    }
+}
+
+/**
+ * Задать положение губок цифровой командой (принятая команда перехватывает управление у RC)
+ * @param permille - положение 0 (открыт) .. 1000 (закрыт)
+ * @param current_time - текущее время в мс
+ * @return false если положение неизвестно (нет оценки или хоминга)
+ */
+bool GripperController::setPositionTarget(uint16_t permille, unsigned long current_time) {
+    // Отклоненная команда управление не перехватывает: RC продолжает работать
+    if (position_control != nullptr) {
+        if (!position_control->setTarget(permille)) {
+            return false;
+        }
+        target_active = false;
+    } else {
+        if (jaw == nullptr || !jaw->isHomed()) {
+            return false;
+        }
+        target_position = static_cast<int32_t>(min(permille, static_cast<uint16_t>(1000))) * JAW_TRAVEL_RIPPLES / 1000;
+        target_active = true;
+    }
+    source = SOURCE_DIGITAL;
+    last_digital_time = current_time;
+    return true;
+}
+
+/**
+ * Проверить, задано ли положение губок
+ * @return true если захват движется к заданному положению или удерживает его
+ */
+bool GripperController::isPositionTargetActive() const {
+    return target_active || (position_control != nullptr && position_control->isActive());
+}
+
+/**
+ * Получить текущий источник команд
+ * @return источник команд
+ */
+GripperController::ControlSource GripperController::getSource() const {
+    return source;
+}
+
+/**
+ * Получить заданную скорость
+ * @return скорость от -255 до +255
+ */
+int16_t GripperController::getCommandedSpeed() const {
+    return motor_speed;
+}
+
+/**
+ * Проверить, сработала ли защита
+ * @return true если двигатель заблокирован защитой
+ */
+bool GripperController::isProtectionActive() const {
+    return protection_active;
+}
+
+/**
+ * Проверить, идет ли задержка после старта двигателя
+ * @return true если защита временно не проверяет ток
+ */
+bool GripperController::isStartupDelayActive() const {
+    return startup_delay_active;
+}
@@ -0,0 +1,184 @@
+#ifndef GRIPPER_CONTROLLER_H
+#define GRIPPER_CONTROLLER_H
+
+#include <Arduino.h>
+#include "Config.h"
+#include "RuntimeConfig.h"
+#include "CurrentSensor.h"
+#include "MotorDriver.h"
+#include "JawPosition.h"
+#include "PositionController.h"
+
+/**
+ * Логика управления захватом: преобразование импульса управления в скорость
+ * и защита от перегрузки по току с задержкой после старта двигателя.
+ * Не обращается к аппаратуре напрямую - только через CurrentSensor и
+ * MotorDriver, поэтому может прогоняться на записанных трассах (tools/replay).
+ *
+ * Источники команд и приоритет:
+ *   1. Защита по току - двигатель остановлен независимо от источника
+ *   2. Цифровые команды (CommandProtocol) - пока связь жива, импульсы RC игнорируются
+ *   3. Импульс RC - после CMD_RELEASE или таймаута связи (двигатель при этом останавливается)
+ *
+ * С подключенной оценкой положения (attachJawPosition) скорость снижается
+ * у краев хода (мягкие упоры), а цифровая команда может задать положение губок.
+ * С подключенным регулятором по энкодеру (attachPositionControl) положение
+ * задают цифровая команда и импульс RC (POSITION_CONTROL_RC), заполнение
+ * вычисляется в updatePositionControl() с периодом POSITION_LOOP_INTERVAL_US.
+ */
+class GripperController {
+public:
+    // Источник команд скорости
+    enum ControlSource : uint8_t {
+        SOURCE_RC = 0,        // Импульс RC (PulseMeter)
+        SOURCE_DIGITAL = 1    // Двоичный протокол по Serial
+    };
+
+private:
+    MotorDriver& motor;                  // Драйвер двигателя
+    CurrentSensor& sensor;               // Датчик тока
+    int16_t motor_speed;                 // Заданная скорость
+    bool protection_active;              // Сработала защита
+    int16_t protection_direction;        // Направление при срабатывании защиты
+    unsigned long motor_start_time;      // Время старта двигателя
+    bool motor_was_running;              // Двигатель работал на предыдущей проверке
+    bool startup_delay_active;           // Флаг активной задержки после старта
+    ControlSource source;                // Текущий источник команд
+    unsigned long last_digital_time;     // Время последнего кадра цифрового управления
+    JawPosition* jaw;                    // Оценка положения губок (nullptr - нет)
+    int16_t output_speed;                // Скорость, переданная драйверу
+    bool target_active;                  // Задано положение губок
+    int32_t target_position;             // Заданное положение (пульсации)
+    PositionController* position_control; // Регулятор положения по энкодеру (nullptr - нет)
+    
+    // Применить команду скорости с учетом защиты
+    bool applySpeedCommand(int16_t new_speed);
+    
+    // Передать заданную скорость драйверу с учетом мягких упоров
+    void driveMotor();
+    
+    // Отменить заданное положение (переход к управлению скоростью)
+    void cancelPositionTarget();
+    
+    // Вывести сообщение о смене скорости
+    void printSpeedChange() const;
+
+public:
+    /**
+     * Конструктор
+     * @param motor - драйвер двигателя
+     * @param sensor - датчик тока
+     */
+    GripperController(MotorDriver& motor, CurrentSensor& sensor);
+
+    /**
+     * Обработать новый импульс управления
+     * @param pulse_width_us - длина импульса в микросекундах
+     */
+    void processPulse(uint32_t pulse_width_us);
+
+    /**
+     * Проверка защиты от перегрузки (вызывать каждый такт управления)
+     * @param current_time - текущее время в мс
+     * @return true если защита сработала на этом такте
+     */
+    bool checkCurrentProtection(unsigned long current_time);
+
+    /**
+     * Установить скорость цифровой командой (перехватывает управление у RC)
+     * @param speed - скорость от -255 до +255
+     * @param current_time - текущее время в мс
+     * @return false если команда не применена из-за защиты
+     */
+    bool setDigitalSpeed(int16_t speed, unsigned long current_time);
+    
+    /**
+     * Остановить двигатель цифровой командой (перехватывает управление у RC)
+     * @param current_time - текущее время в мс
+     */
+    void digitalStop(unsigned long current_time);
+    
+    /**
+     * Вернуть управление каналу RC
+     */
+    void releaseDigital();
+    
+    /**
+     * Отметить принятый кадр цифрового управления (пульс связи)
+     * @param current_time - текущее время в мс
+     */
+    void digitalHeartbeat(unsigned long current_time);
+    
+    /**
+     * Проверить таймаут цифрового управления (вызывать каждый такт)
+     * При потере связи двигатель останавливается, управление возвращается RC
+     * @param current_time - текущее время в мс
+     * @return true если связь потеряна на этом такте
+     */
+    bool checkDigitalTimeout(unsigned long current_time);
+    
+    /**
+     * Подключить оценку положения губок (мягкие упоры, хоминг по упору, заданное положение)
+     * @param jaw_position - оценка положения
+     */
+    void attachJawPosition(JawPosition* jaw_position);
+    
+    /**
+     * Обновить положение и движение к заданному положению (вызывать каждый такт)
+     * @param current_time - текущее время в мс
+     */
+    void updateJaw(unsigned long current_time);
+    
+    /**
+     * Подключить регулятор положения по энкодеру (вместо оценки по пульсациям для заданного положения)
+     * @param controller - регулятор положения
+     */
+    void attachPositionControl(PositionController* controller);
+    
+    /**
+     * Обновить регулятор положения (вызывать каждые POSITION_LOOP_INTERVAL_US)
+     * @param encoder_count - расширенный счетчик энкодера
+     * @param interval_us - время с предыдущего обновления в мкс
+     */
+    void updatePositionControl(int32_t encoder_count, uint32_t interval_us);
+    
+    /**
+     * Задать положение губок цифровой командой (принятая команда перехватывает управление у RC)
+     * @param permille - положение 0 (открыт) .. 1000 (закрыт)
+     * @param current_time - текущее время в мс
+     * @return false если положение неизвестно (нет оценки или хоминга)
+     */
+    bool setPositionTarget(uint16_t permille, unsigned long current_time);
+    
+    /**
+     * Проверить, задано ли положение губок
+     * @return true если захват движется к заданному положению или удерживает его
+     */
+    bool isPositionTargetActive() const;
+    
+    /**
+     * Получить текущий источник команд
+     * @return источник команд
+     */
+    ControlSource getSource() const;
+    
+    /**
+     * Получить заданную скорость
+     * @return скорость от -255 до +255
+     */
+    int16_t getCommandedSpeed() const;
+
+    /**
+     * Проверить, сработала ли защита
+     * @return true если двигатель заблокирован защитой
+     */
+    bool isProtectionActive() const;
+
+    /**
+     * Проверить, идет ли задержка после старта двигателя
+     * @return true если защита временно не проверяет ток
+     */
+    bool isStartupDelayActive() const;
+};
+
+#endif // GRIPPER_CONTROLLER_H
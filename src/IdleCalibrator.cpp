@@ -0,0 +1,136 @@
+#include "IdleCalibrator.h"
+
+/**
+ * Конструктор класса IdleCalibrator
+ */
+IdleCalibrator::IdleCalibrator()
+    : state(STATE_CALIBRATING), offset_mA(0.0f), mean_mA(0.0f), m2(0.0f), variance(0.0f),
+      calibration_samples(0), drift_samples(0), rejected_samples(0), consecutive_rejects(0),
+      was_idle(false), idle_since(0), last_sample_time(0) {
+}
+
+/**
+ * Передать новое измерение тока
+ * @param current_mA - ток до вычитания смещения в мА
+ * @param motor_idle - двигатель остановлен
+ * @param current_time - время измерения в мс
+ */
+void IdleCalibrator::addSample(float current_mA, bool motor_idle, unsigned long current_time) {
+    // Ждем затухания тока после остановки двигателя
+    if (!motor_idle) {
+        was_idle = false;
+        return;
+    }
+    if (!was_idle) {
+        was_idle = true;
+        idle_since = current_time;
+    }
+    if (current_time - idle_since < IDLE_CURRENT_SETTLE_MS) {
+        return;
+    }
+
+    // Прореживание до интервала сэмплов холостого тока
+    if (current_time - last_sample_time < IDLE_CURRENT_SAMPLE_INTERVAL_MS) {
+        return;
+    }
+    last_sample_time = current_time;
+
+    if (state == STATE_CALIBRATING) {
+        // Алгоритм Уэлфорда: устойчив к накоплению ошибки
+        calibration_samples++;
+        float delta = current_mA - mean_mA;
+        mean_mA += delta / calibration_samples;
+        m2 += delta * (current_mA - mean_mA);
+
+        if (calibration_samples >= IDLE_CURRENT_SAMPLES) {
+            // Разброс или смещение вне пределов - холостой режим не установился, повторяем
+            float sample_variance = m2 / (calibration_samples - 1);
+            if (sample_variance > IDLE_CALIBRATION_MAX_SIGMA_MA * IDLE_CALIBRATION_MAX_SIGMA_MA ||
+                fabsf(mean_mA) > IDLE_OFFSET_LIMIT_MA) {
+                restart();
+                return;
+            }
+            offset_mA = mean_mA;
+            variance = sample_variance;
+            state = STATE_TRACKING;
+        }
+        return;
+    }
+
+    // Отслеживание дрейфа: выбросы (нагрузка на захват, помехи) не учитываются
+    float deviation = current_mA - offset_mA;
+    if (fabsf(deviation) > IDLE_DRIFT_MAX_DEVIATION_MA) {
+        rejected_samples++;
+        if (++consecutive_rejects >= IDLE_DRIFT_RESTART_SAMPLES) {
+            // Смещение ушло скачком - калибруемся заново
+            restart();
+        }
+        return;
+    }
+    consecutive_rejects = 0;
+    drift_samples++;
+
+    // Экспоненциально взвешенные среднее и дисперсия
+    float increment = IDLE_DRIFT_ALPHA * deviation;
+    offset_mA = constrain(offset_mA + increment, -IDLE_OFFSET_LIMIT_MA, IDLE_OFFSET_LIMIT_MA);
+    variance = (1.0f - IDLE_DRIFT_ALPHA) * (variance + deviation * increment);
+}
+
+/**
+ * Начать начальную калибровку заново (смещение сохраняется до ее завершения)
+ */
+void IdleCalibrator::restart() {
+    state = STATE_CALIBRATING;
+    mean_mA = 0.0f;
+    m2 = 0.0f;
+    calibration_samples = 0;
+    consecutive_rejects = 0;
+}
+
+/**
+ * Получить оценку смещения нуля
+ * @return смещение в мА (0 до завершения первой калибровки)
+ */
+float IdleCalibrator::getOffset_mA() const {
+    return offset_mA;
+}
+
+/**
+ * Получить дисперсию сэмплов холостого тока
+ * @return дисперсия в мА^2
+ */
+float IdleCalibrator::getVariance() const {
+    return variance;
+}
+
+/**
+ * Получить количество сэмплов начальной калибровки
+ * @return количество сэмплов
+ */
+uint16_t IdleCalibrator::getCalibrationSamples() const {
+    return calibration_samples;
+}
+
+/**
+ * Получить количество принятых сэмплов отслеживания дрейфа
+ * @return количество сэмплов
+ */
+uint32_t IdleCalibrator::getDriftSamples() const {
+    return drift_samples;
+}
+
+/**
+ * Получить количество отброшенных сэмплов
+ * @return количество сэмплов
+ */
+uint32_t IdleCalibrator::getRejectedSamples() const {
+    return rejected_samples;
+}
+
+/**
+ * Получить текущий этап
+ * @return этап калибровки
+ */
+IdleCalibrator::State IdleCalibrator::getState() const {
+    return state;
+}
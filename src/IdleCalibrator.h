@@ -0,0 +1,102 @@
+#ifndef IDLE_CALIBRATOR_H
+#define IDLE_CALIBRATOR_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+/**
+ * Оценка смещения нуля тока (смещение INA219 + собственное потребление платы)
+ *
+ * Работает по одному сэмплу за вызов и никогда не блокирует цикл.
+ * Сэмплы принимаются только при остановленном двигателе, не чаще
+ * IDLE_CURRENT_SAMPLE_INTERVAL_MS и не раньше IDLE_CURRENT_SETTLE_MS после остановки.
+ *
+ * Этапы:
+ *   STATE_CALIBRATING - начальная калибровка: среднее и дисперсия по Уэлфорду
+ *                       за IDLE_CURRENT_SAMPLES сэмплов. Результат принимается, если
+ *                       σ <= IDLE_CALIBRATION_MAX_SIGMA_MA и |среднее| <= IDLE_OFFSET_LIMIT_MA,
+ *                       иначе калибровка повторяется. До первой калибровки смещение 0
+ *   STATE_TRACKING    - отслеживание дрейфа: экспоненциальное среднее и дисперсия
+ *                       с коэффициентом IDLE_DRIFT_ALPHA. Сэмплы дальше
+ *                       IDLE_DRIFT_MAX_DEVIATION_MA от смещения отбрасываются;
+ *                       IDLE_DRIFT_RESTART_SAMPLES отброшенных подряд - повторная калибровка
+ */
+class IdleCalibrator {
+public:
+    // Этап калибровки
+    enum State : uint8_t {
+        STATE_CALIBRATING = 0,
+        STATE_TRACKING = 1
+    };
+
+private:
+    State state;                    // Текущий этап
+    float offset_mA;                // Текущая оценка смещения (вычитается из тока)
+    float mean_mA;                  // Среднее начальной калибровки
+    float m2;                       // Сумма квадратов отклонений (Уэлфорд)
+    float variance;                 // Дисперсия сэмплов холостого тока (мА^2)
+    uint16_t calibration_samples;   // Сэмплов в начальной калибровке
+    uint32_t drift_samples;         // Принятых сэмплов отслеживания дрейфа
+    uint32_t rejected_samples;      // Отброшенных сэмплов
+    uint16_t consecutive_rejects;   // Отброшенных сэмплов подряд
+    bool was_idle;                  // Двигатель был остановлен на предыдущем вызове
+    unsigned long idle_since;       // Время остановки двигателя
+    unsigned long last_sample_time; // Время последнего принятого сэмпла
+
+public:
+    /**
+     * Конструктор (начинает с начальной калибровки)
+     */
+    IdleCalibrator();
+
+    /**
+     * Передать новое измерение тока
+     * @param current_mA - ток до вычитания смещения в мА
+     * @param motor_idle - двигатель остановлен
+     * @param current_time - время измерения в мс
+     */
+    void addSample(float current_mA, bool motor_idle, unsigned long current_time);
+
+    /**
+     * Начать начальную калибровку заново (смещение сохраняется до ее завершения)
+     */
+    void restart();
+
+    /**
+     * Получить оценку смещения нуля
+     * @return смещение в мА (0 до завершения первой калибровки)
+     */
+    float getOffset_mA() const;
+
+    /**
+     * Получить дисперсию сэмплов холостого тока
+     * @return дисперсия в мА^2
+     */
+    float getVariance() const;
+
+    /**
+     * Получить количество сэмплов начальной калибровки
+     * @return количество сэмплов
+     */
+    uint16_t getCalibrationSamples() const;
+
+    /**
+     * Получить количество принятых сэмплов отслеживания дрейфа
+     * @return количество сэмплов
+     */
+    uint32_t getDriftSamples() const;
+
+    /**
+     * Получить количество отброшенных сэмплов
+     * @return количество сэмплов
+     */
+    uint32_t getRejectedSamples() const;
+
+    /**
+     * Получить текущий этап
+     * @return этап калибровки
+     */
+    State getState() const;
+};
+
+#endif // IDLE_CALIBRATOR_H
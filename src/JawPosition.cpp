@@ -0,0 +1,214 @@
+#include "JawPosition.h"
+
+/**
+ * Конструктор класса JawPosition
+ * До хоминга положение считается серединой хода
+ */
+JawPosition::JawPosition()
+    : position_q8((JAW_TRAVEL_RIPPLES / 2) * (1L << POSITION_SHIFT)),
+      noload_rate_q8(RIPPLE_NOLOAD_RATE_HZ * (1L << POSITION_SHIFT)), homed(false), started(false),
+      last_update_ms(0), stall_time_ms(0), stall_latched(false), ripple_updates(0), model_updates(0), rehome_count(0), last_rehome_error(0) {
+}
+
+/**
+ * Обновить положение (вызывать каждый такт управления)
+ * @param applied_speed - примененная скорость двигателя
+ * @param current_mA - ток двигателя в мА
+ * @param time_ms - текущее время в мс
+ */
+void JawPosition::update(int16_t applied_speed, float current_mA, uint32_t time_ms) {
+    uint32_t interval_ms = started ? time_ms - last_update_ms : 0;
+    started = true;
+    last_update_ms = time_ms;
+
+    uint32_t counted = ripple.takeCount();
+    uint32_t gap_us = ripple.takeGapTime();
+    if (applied_speed == 0 || interval_ms == 0) {
+        ripple.reset();
+        ripple.setMinPeriod(0);
+        stall_time_ms = 0;
+        stall_latched = false;
+        return;
+    }
+
+    // Модель: доля скорости холостого хода с учетом нагрузки (Q8, 0..256)
+    int32_t duty_q8 = (applied_speed > 0 ? applied_speed : -applied_speed) * 256 / 255;
+    int32_t load_q8 = static_cast<int32_t>(current_mA * 256.0f / JAW_STALL_CURRENT_MA);
+    int32_t speed_q8 = constrain(duty_q8 - load_q8, 0L, 256L);
+
+    // Ожидаемое число пульсаций за такт (Q8) и за пропуски сэмплов в нем
+    uint32_t interval_us = interval_ms * 1000;
+    if (gap_us > interval_us) gap_us = interval_us;
+    int32_t expected_q8 = static_cast<int32_t>(
+        static_cast<int64_t>(noload_rate_q8) * speed_q8 * interval_us / (256 * 1000000LL));
+    int32_t gap_q8 = static_cast<int32_t>(
+        static_cast<int64_t>(noload_rate_q8) * speed_q8 * gap_us / (256 * 1000000LL));
+    uint32_t sampled_us = interval_us - gap_us;
+    int32_t sampled_expected_q8 = expected_q8 - gap_q8;
+
+    // Пульсации правдоподобны, если различимы и согласуются с моделью
+    int32_t counted_q8 = static_cast<int32_t>(counted) << POSITION_SHIFT;
+    bool plausible = ripple.isObservable() && counted > 0 &&
+                     counted_q8 * 100 >= sampled_expected_q8 * RIPPLE_PLAUSIBLE_MIN_PERCENT &&
+                     counted_q8 * 100 <= sampled_expected_q8 * RIPPLE_PLAUSIBLE_MAX_PERCENT;
+
+    int32_t step_q8;
+    if (plausible) {
+        step_q8 = counted_q8 + gap_q8;
+        ripple_updates++;
+
+        // Уточнение скорости холостого хода: EMA по измеренной скорости
+        if (speed_q8 >= RIPPLE_LEARN_MIN_SPEED_Q8 && sampled_us > 0) {
+            int32_t measured_q8 = static_cast<int32_t>(
+                static_cast<int64_t>(counted_q8) * 256 * 1000000LL / (static_cast<int64_t>(speed_q8) * sampled_us));
+            noload_rate_q8 += (measured_q8 - noload_rate_q8) >> RIPPLE_LEARN_SHIFT;
+        }
+    } else {
+        step_q8 = expected_q8;
+        model_updates++;
+    }
+
+    // Минимальный период для детектора - при скорости RIPPLE_PLAUSIBLE_MAX_PERCENT от ожидаемой
+    int32_t expected_rate_q8 = static_cast<int32_t>(static_cast<int64_t>(noload_rate_q8) * speed_q8 / 256);
+    ripple.setMinPeriod(expected_rate_q8 > 0 ?
+        static_cast<uint32_t>((1000000LL << POSITION_SHIFT) * 100 / (static_cast<int64_t>(expected_rate_q8) * RIPPLE_PLAUSIBLE_MAX_PERCENT)) : 0);
+
+    bool closing = (applied_speed > 0) == (GRIPPER_CLOSE_DIRECTION > 0);
+    position_q8 += closing ? step_q8 : -step_q8;
+
+    // Упор по модели: весь ток уходит на момент, скорость около нуля
+    if (speed_q8 <= JAW_STALL_SPEED_Q8 && !plausible) {
+        stall_time_ms += interval_ms;
+        if (stall_time_ms >= JAW_STALL_DETECT_MS) {
+            onStall(applied_speed);
+        }
+    } else {
+        stall_time_ms = 0;
+        stall_latched = false;
+    }
+}
+
+/**
+ * Сообщить об упоре при движении (обрабатывается один раз до возобновления движения)
+ * @param speed - скорость, с которой двигался захват
+ */
+void JawPosition::onStall(int16_t speed) {
+    if (speed == 0 || stall_latched) return;
+    stall_latched = true;
+
+    bool closing = (speed > 0) == (GRIPPER_CLOSE_DIRECTION > 0);
+    int32_t position = getPosition();
+
+    // Упор при закрытии вдали от края - это зажатый предмет, а не край хода
+    if (closing) {
+        if (homed && position >= JAW_TRAVEL_RIPPLES - JAW_REHOME_WINDOW_RIPPLES) {
+            last_rehome_error = position - JAW_TRAVEL_RIPPLES;
+            home(true);
+        }
+    } else if (!homed || position <= JAW_REHOME_WINDOW_RIPPLES) {
+        last_rehome_error = position;
+        home(false);
+    }
+}
+
+/**
+ * Задать положение вручную
+ * @param closed - true - захват закрыт, false - открыт
+ */
+void JawPosition::home(bool closed) {
+    position_q8 = closed ? (JAW_TRAVEL_RIPPLES * (1L << POSITION_SHIFT)) : 0;
+    homed = true;
+    rehome_count++;
+}
+
+/**
+ * Ограничить скорость вблизи краев хода (мягкие упоры)
+ * @param speed - требуемая скорость
+ * @return скорость, сниженная в зоне JAW_SOFT_ZONE_RIPPLES у края, к которому идет движение
+ */
+int16_t JawPosition::limitSpeed(int16_t speed) const {
+    if (!homed || speed == 0) return speed;
+
+    bool closing = (speed > 0) == (GRIPPER_CLOSE_DIRECTION > 0);
+    int32_t distance = closing ? JAW_TRAVEL_RIPPLES - getPosition() : getPosition();
+    if (distance >= JAW_SOFT_ZONE_RIPPLES) return speed;
+
+    // Линейное снижение до минимальной скорости; ноль не допускается - край нужен для хоминга
+    if (distance < 0) distance = 0;
+    int32_t limit = JAW_SOFT_MIN_SPEED + (MOTOR_SPEED_FORWARD - JAW_SOFT_MIN_SPEED) * distance / JAW_SOFT_ZONE_RIPPLES;
+    if (speed > limit) return limit;
+    if (speed < -limit) return -limit;
+    return speed;
+}
+
+/**
+ * Получить положение
+ * @return положение в пульсациях (0 - открыт)
+ */
+int32_t JawPosition::getPosition() const {
+    return position_q8 >> POSITION_SHIFT;
+}
+
+/**
+ * Получить положение в промилле хода
+ * @return 0 (открыт) .. 1000 (закрыт)
+ */
+uint16_t JawPosition::getPositionPermille() const {
+    return constrain(getPosition() * 1000L / JAW_TRAVEL_RIPPLES, 0L, 1000L);
+}
+
+/**
+ * Проверить, стоит ли захват в упоре
+ * @return true если упор обнаружен и движение не возобновилось
+ */
+bool JawPosition::isStalled() const {
+    return stall_latched;
+}
+
+/**
+ * Проверить, задано ли начало отсчета
+ * @return true если положение привязано к краю хода
+ */
+bool JawPosition::isHomed() const {
+    return homed;
+}
+
+/**
+ * Проверить, различимы ли пульсации
+ * @return true если положение считается по пульсациям
+ */
+bool JawPosition::isRippleObservable() const {
+    return ripple.isObservable();
+}
+
+/**
+ * Получить детектор пульсаций
+ * @return ссылка на детектор
+ */
+const RippleCounter& JawPosition::getRippleCounter() const {
+    return ripple;
+}
+
+/**
+ * Вывести отчет в Serial
+ */
+void JawPosition::printReport() const {
+    uint32_t total, rejected, gaps, samples;
+    ripple.getStats(total, rejected, gaps, samples);
+
+    Serial.print("Jaw: "); Serial.print(getPosition());
+    Serial.print("/"); Serial.print(JAW_TRAVEL_RIPPLES);
+    Serial.print(" ripples ("); Serial.print(getPositionPermille() / 10.0f, 1);
+    Serial.print("%)"); Serial.println(homed ? " homed" : " NOT HOMED");
+    Serial.print("Ripple: amplitude="); Serial.print(ripple.getAmplitude());
+    Serial.print(ripple.isObservable() ? " observable" : " unobservable");
+    Serial.print(" total="); Serial.print(total);
+    Serial.print(" rejected="); Serial.print(rejected);
+    Serial.print(" gaps="); Serial.print(gaps);
+    Serial.print(" samples="); Serial.println(samples);
+    Serial.print("Updates: ripple="); Serial.print(ripple_updates);
+    Serial.print(" model="); Serial.print(model_updates);
+    Serial.print(" no-load rate="); Serial.print(noload_rate_q8 / 256.0f, 1);
+    Serial.print(" Hz rehomes="); Serial.print(rehome_count);
+    Serial.print(" last error="); Serial.println(last_rehome_error);
+}
@@ -0,0 +1,131 @@
+#ifndef JAW_POSITION_H
+#define JAW_POSITION_H
+
+#include <Arduino.h>
+#include "Config.h"
+#include "RippleCounter.h"
+
+/**
+ * Бездатчиковая оценка положения губок захвата
+ *
+ * Положение измеряется в пульсациях тока: 0 - полностью открыт,
+ * JAW_TRAVEL_RIPPLES - полностью закрыт.
+ *
+ * Каждый такт положение сдвигается на число пульсаций, найденных RippleCounter,
+ * если оно правдоподобно по модели двигателя. Иначе (пульсации не различимы,
+ * долгие пропуски сэмплов) положение интегрируется по модели:
+ *   скорость = скорость_хх * (заполнение - ток / ток_стопора), не меньше 0
+ * где скорость_хх - пульсаций в секунду при полном заполнении без нагрузки.
+ * Вычитание тока учитывает нагрузку: при упоре двигатель стоит и положение не растет.
+ * Пока пульсации наблюдаются, скорость_хх уточняется по ним.
+ * Короткие пропуски сэмплов (занятый цикл) восполняются моделью на их длительность.
+ *
+ * Упор - срабатывание защиты или скорость по модели ниже JAW_STALL_SPEED_Q8
+ * дольше JAW_STALL_DETECT_MS (на мягком упоре ток меньше порога защиты).
+ * При упоре у края хода положение переустанавливается на край.
+ * Первый упор при открытии задает начало отсчета (хоминг).
+ */
+class JawPosition {
+private:
+    static constexpr uint8_t POSITION_SHIFT = 8;  // Дробные биты положения и скорости
+
+    RippleCounter ripple;         // Детектор пульсаций
+    int32_t position_q8;          // Положение в пульсациях (Q8)
+    int32_t noload_rate_q8;       // Пульсаций в секунду при полном заполнении (Q8)
+    bool homed;                   // Начало отсчета задано
+    bool started;                 // Было хотя бы одно обновление
+    uint32_t last_update_ms;      // Время предыдущего обновления
+    uint32_t stall_time_ms;       // Длительность движения со скоростью упора
+    bool stall_latched;           // Упор уже обработан (до возобновления движения)
+
+    // Статистика
+    uint32_t ripple_updates;      // Тактов, посчитанных по пульсациям
+    uint32_t model_updates;       // Тактов, посчитанных по модели
+    uint32_t rehome_count;        // Переустановок на край хода
+    int32_t last_rehome_error;    // Ошибка положения при последней переустановке (пульсации)
+
+public:
+    /**
+     * Конструктор
+     */
+    JawPosition();
+
+    /**
+     * Обработать высокочастотный сэмпл тока шунта (постоянное время)
+     * @param shunt_raw - отсчет регистра шунта INA219
+     * @param time_us - время сэмпла в мкс
+     */
+    inline void addSample(int32_t shunt_raw, uint32_t time_us) {
+        ripple.addSample(shunt_raw, time_us);
+    }
+
+    /**
+     * Обновить положение (вызывать каждый такт управления)
+     * @param applied_speed - примененная скорость двигателя
+     * @param current_mA - ток двигателя в мА
+     * @param time_ms - текущее время в мс
+     */
+    void update(int16_t applied_speed, float current_mA, uint32_t time_ms);
+
+    /**
+     * Сообщить об упоре при движении (обрабатывается один раз до возобновления движения)
+     * @param speed - скорость, с которой двигался захват
+     */
+    void onStall(int16_t speed);
+
+    /**
+     * Задать положение вручную
+     * @param closed - true - захват закрыт, false - открыт
+     */
+    void home(bool closed);
+
+    /**
+     * Ограничить скорость вблизи краев хода (мягкие упоры)
+     * @param speed - требуемая скорость
+     * @return скорость, сниженная в зоне JAW_SOFT_ZONE_RIPPLES у края, к которому идет движение
+     */
+    int16_t limitSpeed(int16_t speed) const;
+
+    /**
+     * Получить положение
+     * @return положение в пульсациях (0 - открыт)
+     */
+    int32_t getPosition() const;
+
+    /**
+     * Получить положение в промилле хода
+     * @return 0 (открыт) .. 1000 (закрыт)
+     */
+    uint16_t getPositionPermille() const;
+
+    /**
+     * Проверить, стоит ли захват в упоре
+     * @return true если упор обнаружен и движение не возобновилось
+     */
+    bool isStalled() const;
+
+    /**
+     * Проверить, задано ли начало отсчета
+     * @return true если положение привязано к краю хода
+     */
+    bool isHomed() const;
+
+    /**
+     * Проверить, различимы ли пульсации
+     * @return true если положение считается по пульсациям
+     */
+    bool isRippleObservable() const;
+
+    /**
+     * Получить детектор пульсаций
+     * @return ссылка на детектор
+     */
+    const RippleCounter& getRippleCounter() const;
+
+    /**
+     * Вывести отчет в Serial
+     */
+    void printReport() const;
+};
+
+#endif // JAW_POSITION_H
@@ -0,0 +1,274 @@
+#include "LoopTiming.h"
+#include "Config.h"
+
+// Инициализация статического указателя на экземпляр
+LoopTiming* LoopTiming::instance = nullptr;
+
+/**
+ * Конструктор гистограммы
+ * @param bin_width - ширина одной корзины в единицах измерения
+ */
+TimingHistogram::TimingHistogram(uint32_t bin_width)
+    : bin_width(bin_width > 0 ? bin_width : 1) {
+    reset();
+}
+
+/**
+ * Добавить значение в гистограмму
+ * @param value - измеренное значение
+ */
+void TimingHistogram::add(uint32_t value) {
+    uint32_t index = value / bin_width;
+    if (index >= BIN_COUNT) {
+        index = BIN_COUNT - 1;  // Корзина переполнения
+    }
+    bins[index]++;
+
+    if (sample_count == 0 || value < min_value) {
+        min_value = value;
+    }
+    if (value > max_value) {
+        max_value = value;
+    }
+    sum += value;
+    sample_count++;
+}
+
+/**
+ * Сбросить накопленную статистику
+ */
+void TimingHistogram::reset() {
+    for (uint8_t i = 0; i < BIN_COUNT; i++) {
+        bins[i] = 0;
+    }
+    sample_count = 0;
+    min_value = 0;
+    max_value = 0;
+    sum = 0;
+}
+
+/**
+ * Получить приблизительный перцентиль (верхняя граница корзины)
+ * @param percent - перцентиль от 1 до 100
+ * @return значение перцентиля
+ */
+uint32_t TimingHistogram::getPercentile(uint8_t percent) const {
+    if (sample_count == 0) {
+        return 0;
+    }
+
+    uint32_t threshold = (static_cast<uint64_t>(sample_count) * percent + 99) / 100;
+    uint32_t accumulated = 0;
+    for (uint8_t i = 0; i < BIN_COUNT; i++) {
+        accumulated += bins[i];
+        if (accumulated >= threshold) {
+            // Для корзины переполнения верхняя граница - максимум
+            return (i == BIN_COUNT - 1) ? max_value : (i + 1) * bin_width;
+        }
+    }
+    return max_value;
+}
+
+/**
+ * Вывести гистограмму в Serial
+ * @param name - название гистограммы
+ * @param unit - единица измерения
+ */
+void TimingHistogram::print(const char* name, const char* unit) const {
+    Serial.print(name);
+    Serial.print(": n="); Serial.print(sample_count);
+    Serial.print(" min="); Serial.print(getMin());
+    Serial.print(" mean="); Serial.print(getMean());
+    Serial.print(" p99="); Serial.print(getPercentile(99));
+    Serial.print(" max="); Serial.print(max_value);
+    Serial.println(unit);
+
+    // Корзины: "<нижняя граница>:<количество>", пустые корзины пропускаются
+    Serial.print("  bins/"); Serial.print(bin_width); Serial.print(unit); Serial.print(":");
+    for (uint8_t i = 0; i < BIN_COUNT; i++) {
+        if (bins[i] == 0) continue;
+        Serial.print(' ');
+        Serial.print(i * bin_width);
+        if (i == BIN_COUNT - 1) Serial.print('+');
+        Serial.print(':');
+        Serial.print(bins[i]);
+    }
+    Serial.println();
+}
+
+/**
+ * Конструктор класса LoopTiming
+ * @param nominal_period_ms - номинальный период такта управления в мс
+ */
+LoopTiming::LoopTiming(uint32_t nominal_period_ms)
+    : nominal_period_us(nominal_period_ms * 1000UL),
+      tick_jitter_us(LOOP_JITTER_BIN_US), pass_duration_us(LOOP_PASS_BIN_US),
+      isr_latency_ns(ISR_LATENCY_BIN_NS), last_tick_us(0), pass_start_us(0),
+      tick_count(0), late_ticks(0), last_jitter_us(0), last_pass_us(0), isr_capture_enabled(false), period_changed(false) {
+}
+
+/**
+ * Инициализация: настройка захвата таймера для измерения задержки ISR
+ * PA2 - вход TIM2 CH3. Захват фиксирует момент фронта аппаратно,
+ * обработчик читает счетчик и вычисляет время от фронта до входа в ISR.
+ * TIM2 также используется analogWrite() для ШИМ на PA0/PA1 -
+ * предделитель и период читаются при каждом измерении.
+ */
+void LoopTiming::begin() {
+    instance = this;
+    reset();
+
+#if ISR_LATENCY_CAPTURE_ENABLED && defined(STM32F1xx)
+    // Если таймер еще не запущен ШИМ, запустить его в свободном счете
+    RCC->APB1ENR |= RCC_APB1ENR_TIM2EN;
+    if (!(TIM2->CR1 & TIM_CR1_CEN)) {
+        TIM2->PSC = 0;
+        TIM2->ARR = 0xFFFF;
+        TIM2->CR1 |= TIM_CR1_CEN;
+    }
+
+    // CH3 - захват по входу TI3 без фильтра
+    TIM2->CCER &= ~(TIM_CCER_CC3E | TIM_CCER_CC3P);
+    TIM2->CCMR2 = (TIM2->CCMR2 & ~(TIM_CCMR2_CC3S | TIM_CCMR2_IC3F)) | TIM_CCMR2_CC3S_0;
+    TIM2->CCER |= TIM_CCER_CC3E;
+    isr_capture_enabled = true;
+#endif
+}
+
+/**
+ * Отметить начало прохода loop()
+ */
+void LoopTiming::beginPass() {
+    pass_start_us = micros();
+}
+
+/**
+ * Отметить конец прохода loop()
+ */
+void LoopTiming::endPass() {
+    last_pass_us = micros() - pass_start_us;
+    pass_duration_us.add(last_pass_us);
+}
+
+/**
+ * Отметить начало такта управления (для статистики джиттера)
+ */
+void LoopTiming::markControlTick() {
+    uint32_t now = micros();
+
+    last_jitter_us = 0;
+    if (tick_count > 0 && !period_changed) {
+        uint32_t period = now - last_tick_us;
+        uint32_t jitter = (period > nominal_period_us) ? period - nominal_period_us
+                                                       : nominal_period_us - period;
+        tick_jitter_us.add(jitter);
+        last_jitter_us = jitter;
+
+        if (period > nominal_period_us + LATE_TICK_TOLERANCE_US) {
+            late_ticks++;
+        }
+    }
+
+    last_tick_us = now;
+    tick_count++;
+    period_changed = false;
+}
+
+/**
+ * Сменить номинальный период такта (режим глубокого простоя)
+ * Интервал, на котором сменился период, в статистику не попадает
+ * @param nominal_period_ms - номинальный период такта управления в мс
+ */
+void LoopTiming::setNominalPeriod(uint32_t nominal_period_ms) {
+    if (nominal_period_us != nominal_period_ms * 1000UL) {
+        nominal_period_us = nominal_period_ms * 1000UL;
+        period_changed = true;
+    }
+}
+
+/**
+ * Вызывать в самом начале обработчика прерывания импульса
+ */
+void LoopTiming::onPulseEdge() {
+    if (instance != nullptr) {
+        instance->capturePulseEdge();
+    }
+}
+
+/**
+ * Измерение задержки прерывания для конкретного экземпляра
+ * Вызывается из прерывания
+ */
+void LoopTiming::capturePulseEdge() {
+#if ISR_LATENCY_CAPTURE_ENABLED && defined(STM32F1xx)
+    if (!isr_capture_enabled) {
+        return;
+    }
+
+    uint32_t counter = TIM2->CNT;
+
+    // Флаг захвата выставлен - фронт зафиксирован таймером
+    if (TIM2->SR & TIM_SR_CC3IF) {
+        uint32_t captured = TIM2->CCR3;  // Чтение сбрасывает флаг
+        uint32_t period = TIM2->ARR + 1;
+        uint32_t ticks = (counter >= captured) ? counter - captured : counter + period - captured;
+        uint32_t prescaler = TIM2->PSC + 1;
+        uint32_t latency_ns = static_cast<uint32_t>(
+            static_cast<uint64_t>(ticks) * prescaler * 1000000000ULL / SystemCoreClock);
+        isr_latency_ns.add(latency_ns);
+    }
+
+    // Следующий захват - по противоположному фронту относительно текущего уровня
+    if (GPIOA->IDR & (1UL << 2)) {
+        TIM2->CCER |= TIM_CCER_CC3P;
+    } else {
+        TIM2->CCER &= ~TIM_CCER_CC3P;
+    }
+#endif
+}
+
+/**
+ * Сбросить всю статистику
+ */
+void LoopTiming::reset() {
+    noInterrupts();
+    tick_jitter_us.reset();
+    pass_duration_us.reset();
+    isr_latency_ns.reset();
+    tick_count = 0;
+    late_ticks = 0;
+    interrupts();
+}
+
+/**
+ * Получить краткую статистику для телеметрии
+ * @param max_jitter_us - максимальный джиттер такта в мкс
+ * @param late_ticks - количество опоздавших тактов
+ * @param max_isr_latency_ns - максимальная задержка ISR в нс
+ */
+void LoopTiming::getSummary(uint32_t& max_jitter_us, uint32_t& late_ticks, uint32_t& max_isr_latency_ns) const {
+    max_jitter_us = tick_jitter_us.getMax();
+    late_ticks = this->late_ticks;
+    max_isr_latency_ns = isr_latency_ns.getMax();
+}
+
+/**
+ * Вывести полную статистику с гистограммами в Serial
+ */
+void LoopTiming::printReport() const {
+    // Снимок гистограммы ISR, чтобы прерывание не меняло ее во время вывода
+    noInterrupts();
+    TimingHistogram isr_snapshot = isr_latency_ns;
+    interrupts();
+
+    Serial.print("Ticks: "); Serial.print(tick_count);
+    Serial.print(" late: "); Serial.print(late_ticks);
+    Serial.print(" (nominal "); Serial.print(nominal_period_us); Serial.println("us)");
+    tick_jitter_us.print("Tick jitter", "us");
+    pass_duration_us.print("Loop pass", "us");
+    if (isr_capture_enabled) {
+        isr_snapshot.print("ISR latency", "ns");
+    } else {
+        Serial.println("ISR latency: disabled");
+    }
+}
@@ -0,0 +1,160 @@
+#ifndef LOOP_TIMING_H
+#define LOOP_TIMING_H
+
+#include <Arduino.h>
+
+/**
+ * Гистограмма временных интервалов фиксированного размера
+ * Линейные корзины одинаковой ширины, последняя корзина - переполнение
+ */
+class TimingHistogram {
+public:
+    static constexpr uint8_t BIN_COUNT = 16;
+
+private:
+    uint32_t bin_width;           // Ширина корзины
+    uint32_t bins[BIN_COUNT];     // Счетчики корзин
+    uint32_t sample_count;        // Количество значений
+    uint32_t min_value;           // Минимальное значение
+    uint32_t max_value;           // Максимальное значение
+    uint64_t sum;                 // Сумма значений (для среднего)
+
+public:
+    /**
+     * Конструктор
+     * @param bin_width - ширина одной корзины в единицах измерения
+     */
+    explicit TimingHistogram(uint32_t bin_width);
+
+    /**
+     * Добавить значение в гистограмму
+     * @param value - измеренное значение
+     */
+    void add(uint32_t value);
+
+    /**
+     * Сбросить накопленную статистику
+     */
+    void reset();
+
+    /**
+     * Получить приблизительный перцентиль (верхняя граница корзины)
+     * @param percent - перцентиль от 1 до 100
+     * @return значение перцентиля
+     */
+    uint32_t getPercentile(uint8_t percent) const;
+
+    uint32_t getCount() const { return sample_count; }
+    uint32_t getMin() const { return sample_count ? min_value : 0; }
+    uint32_t getMax() const { return max_value; }
+    uint32_t getMean() const { return sample_count ? static_cast<uint32_t>(sum / sample_count) : 0; }
+    uint32_t getBinWidth() const { return bin_width; }
+    uint32_t getBin(uint8_t index) const { return bins[index]; }
+
+    /**
+     * Вывести гистограмму в Serial
+     * @param name - название гистограммы
+     * @param unit - единица измерения
+     */
+    void print(const char* name, const char* unit) const;
+};
+
+/**
+ * Класс для сбора статистики времени выполнения основного цикла
+ * - джиттер периода такта управления и количество опоздавших тактов
+ * - длительность одного прохода loop()
+ * - задержка входа в прерывание импульса (фронт -> обработчик),
+ *   измеряемая через захват таймера TIM2 CH3 на пине PA2
+ */
+class LoopTiming {
+private:
+    uint32_t nominal_period_us;         // Номинальный период такта управления
+    TimingHistogram tick_jitter_us;     // Отклонение периода такта от номинала
+    TimingHistogram pass_duration_us;   // Длительность прохода loop()
+    TimingHistogram isr_latency_ns;     // Задержка входа в прерывание
+    uint32_t last_tick_us;              // Время начала предыдущего такта
+    uint32_t pass_start_us;             // Время начала текущего прохода
+    uint32_t tick_count;                // Количество тактов управления
+    uint32_t late_ticks;                // Количество опоздавших тактов
+    uint32_t last_jitter_us;            // Джиттер последнего такта
+    uint32_t last_pass_us;              // Длительность последнего прохода loop()
+    bool isr_capture_enabled;           // Включено ли измерение задержки ISR
+    bool period_changed;                // Период сменился, следующий интервал не учитывается
+
+    // Статический указатель на экземпляр для вызова из прерывания
+    static LoopTiming* instance;
+
+    // Измерение задержки прерывания для конкретного экземпляра
+    void capturePulseEdge();
+
+public:
+    /**
+     * Конструктор
+     * @param nominal_period_ms - номинальный период такта управления в мс
+     */
+    explicit LoopTiming(uint32_t nominal_period_ms);
+
+    /**
+     * Инициализация: настройка захвата таймера для измерения задержки ISR
+     */
+    void begin();
+
+    /**
+     * Отметить начало прохода loop()
+     */
+    void beginPass();
+
+    /**
+     * Отметить конец прохода loop()
+     */
+    void endPass();
+
+    /**
+     * Отметить начало такта управления (для статистики джиттера)
+     */
+    void markControlTick();
+
+    /**
+     * Сменить номинальный период такта (режим глубокого простоя)
+     * Интервал, на котором сменился период, в статистику не попадает
+     * @param nominal_period_ms - номинальный период такта управления в мс
+     */
+    void setNominalPeriod(uint32_t nominal_period_ms);
+
+    /**
+     * Вызывать в самом начале обработчика прерывания импульса
+     */
+    static void onPulseEdge();
+
+    /**
+     * Сбросить всю статистику
+     */
+    void reset();
+
+    /**
+     * Получить краткую статистику для телеметрии
+     * @param max_jitter_us - максимальный джиттер такта в мкс
+     * @param late_ticks - количество опоздавших тактов
+     * @param max_isr_latency_ns - максимальная задержка ISR в нс
+     */
+    void getSummary(uint32_t& max_jitter_us, uint32_t& late_ticks, uint32_t& max_isr_latency_ns) const;
+
+    /**
+     * Получить джиттер последнего такта управления
+     * @return отклонение периода от номинала в мкс (0 для первого такта после смены периода)
+     */
+    uint32_t getLastJitter_us() const { return last_jitter_us; }
+
+    /**
+     * Получить длительность последнего прохода loop()
+     * @return длительность в мкс
+     */
+    uint32_t getLastPassDuration_us() const { return last_pass_us; }
+
+    /**
+     * Вывести полную статистику с гистограммами в Serial
+     */
+    void printReport() const;
+};
+
+#endif // LOOP_TIMING_H
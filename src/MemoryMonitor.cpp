@@ -0,0 +1,206 @@
+#include "MemoryMonitor.h"
+
+// Запас между концом кучи и окраской и между окраской и стеком вызова paintStack (слова)
+static constexpr uint32_t PAINT_GUARD_WORDS = 4;
+static constexpr uint32_t PAINT_MARGIN_WORDS = 32;
+
+static volatile bool heap_locked = false;          // Инициализация закончена, выделения - нарушение
+static volatile uint32_t heap_violations = 0;      // Выделений после lockHeap()
+static volatile uint32_t last_violation_caller = 0; // Адрес вызова последнего выделения после lockHeap()
+static uint8_t allocation_depth = 0;               // Вложенность оберток (malloc newlib вызывает _malloc_r)
+static uint32_t* paint_bottom = nullptr;           // Начало окрашенной области
+static uint32_t* paint_top = nullptr;              // Конец окрашенной области
+
+#if defined(STM32F1xx)
+// Символы скрипта компоновщика STM32duino и функции newlib
+extern "C" {
+extern char _sdata;
+extern char _ebss;
+extern char _end;
+extern char _estack;
+void* _sbrk(int increment);
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* pointer, size_t size);
+void* __real__malloc_r(struct _reent* reent, size_t size);
+void* __real__calloc_r(struct _reent* reent, size_t count, size_t size);
+void* __real__realloc_r(struct _reent* reent, void* pointer, size_t size);
+}
+
+/**
+ * Начать выделение памяти: после lockHeap() учесть его
+ * malloc/calloc/realloc newlib сами вызывают обернутые _r-варианты - учитывается
+ * только внешний вызов, иначе выделение считалось бы дважды, а адресом вызова
+ * оказался бы malloc внутри newlib.
+ * Выделение не блокируется: отказ в памяти библиотеке (Wire, USB) сломал бы ее
+ * молча, а запрет кучи в src/ проверяет сборка
+ * @param caller - адрес возврата вызывающего
+ */
+static inline void enterAllocation(void* caller) {
+    if (allocation_depth++ == 0 && heap_locked) {
+        heap_violations++;
+        last_violation_caller = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(caller));
+    }
+}
+
+/**
+ * Закончить выделение памяти
+ */
+static inline void leaveAllocation() {
+    allocation_depth--;
+}
+
+// Обертки (-Wl,--wrap=...): учитывают выделения после lockHeap(), но не блокируют их
+extern "C" {
+void* __wrap_malloc(size_t size) {
+    enterAllocation(__builtin_return_address(0));
+    void* pointer = __real_malloc(size);
+    leaveAllocation();
+    return pointer;
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+    enterAllocation(__builtin_return_address(0));
+    void* pointer = __real_calloc(count, size);
+    leaveAllocation();
+    return pointer;
+}
+
+void* __wrap_realloc(void* pointer, size_t size) {
+    enterAllocation(__builtin_return_address(0));
+    void* result = __real_realloc(pointer, size);
+    leaveAllocation();
+    return result;
+}
+
+void* __wrap__malloc_r(struct _reent* reent, size_t size) {
+    enterAllocation(__builtin_return_address(0));
+    void* pointer = __real__malloc_r(reent, size);
+    leaveAllocation();
+    return pointer;
+}
+
+void* __wrap__calloc_r(struct _reent* reent, size_t count, size_t size) {
+    enterAllocation(__builtin_return_address(0));
+    void* pointer = __real__calloc_r(reent, count, size);
+    leaveAllocation();
+    return pointer;
+}
+
+void* __wrap__realloc_r(struct _reent* reent, void* pointer, size_t size) {
+    enterAllocation(__builtin_return_address(0));
+    void* result = __real__realloc_r(reent, pointer, size);
+    leaveAllocation();
+    return result;
+}
+}
+#endif
+
+/**
+ * Отметить конец инициализации: дальнейшие выделения считаются нарушениями (вызывать в конце setup)
+ */
+void MemoryMonitor::lockHeap() {
+    heap_locked = true;
+}
+
+/**
+ * Проверить, закончена ли инициализация памяти
+ * @return true после lockHeap()
+ */
+bool MemoryMonitor::isHeapLocked() {
+    return heap_locked;
+}
+
+/**
+ * Заполнить свободную RAM между кучей и текущим стеком образцом
+ * Вызывать после lockHeap(): куча без нарушений больше не растет в окрашенную область,
+ * выделения после lockHeap() делают замер ненадежным (см. printReport)
+ */
+void MemoryMonitor::paintStack() {
+#if defined(STM32F1xx)
+    uintptr_t heap_end = reinterpret_cast<uintptr_t>(_sbrk(0));
+    uint32_t* bottom = reinterpret_cast<uint32_t*>((heap_end + 3) & ~static_cast<uintptr_t>(3)) + PAINT_GUARD_WORDS;
+    uint32_t* top = reinterpret_cast<uint32_t*>(__get_MSP()) - PAINT_MARGIN_WORDS;
+    for (uint32_t* word = bottom; word < top; word++) {
+        *word = STACK_PAINT;
+    }
+    paint_bottom = bottom;
+    paint_top = top;
+#endif
+}
+
+/**
+ * Найти самое глубокое затертое слово окрашенной области
+ * @return адрес слова (paint_top, если область не затиралась)
+ */
+static uint32_t* deepestTouched() {
+    uint32_t* word = paint_bottom;
+    while (word < paint_top && *word == MemoryMonitor::STACK_PAINT) {
+        word++;
+    }
+    return word;
+}
+
+/**
+ * Получить максимальную глубину стека с момента окраски
+ * @return байт от вершины RAM до самого глубокого затертого слова
+ */
+uint32_t MemoryMonitor::getStackPeak() {
+#if defined(STM32F1xx)
+    if (paint_bottom != nullptr) {
+        return static_cast<uint32_t>(reinterpret_cast<uintptr_t>(&_estack) - reinterpret_cast<uintptr_t>(deepestTouched()));
+    }
+#endif
+    return 0;
+}
+
+/**
+ * Получить запас стека
+ * @return байт окрашенной области, которые ни разу не затирались
+ */
+uint32_t MemoryMonitor::getStackFree() {
+    if (paint_bottom == nullptr) {
+        return 0;
+    }
+    return (deepestTouched() - paint_bottom) * sizeof(uint32_t);
+}
+
+/**
+ * Получить количество выделений памяти после lockHeap()
+ * @return количество вызовов после lockHeap()
+ */
+uint32_t MemoryMonitor::getHeapViolations() {
+    return heap_violations;
+}
+
+/**
+ * Вывести отчет в Serial
+ */
+void MemoryMonitor::printReport() {
+#if defined(STM32F1xx)
+    uintptr_t static_bytes = reinterpret_cast<uintptr_t>(&_ebss) - reinterpret_cast<uintptr_t>(&_sdata);
+    uintptr_t heap_bytes = reinterpret_cast<uintptr_t>(_sbrk(0)) - reinterpret_cast<uintptr_t>(&_end);
+    uintptr_t ram_bytes = reinterpret_cast<uintptr_t>(&_estack) - reinterpret_cast<uintptr_t>(&_sdata);
+    Serial.print("RAM: "); Serial.print(ram_bytes);
+    Serial.print(" B, static (data+bss) "); Serial.print(static_bytes);
+    Serial.print(" B, heap "); Serial.print(heap_bytes);
+    Serial.println(" B");
+#endif
+    uint32_t peak = getStackPeak();
+    Serial.print("Stack: peak "); Serial.print(peak);
+    Serial.print(" B, never touched "); Serial.print(getStackFree());
+    Serial.print(" B, budget "); Serial.print(STACK_BUDGET_BYTES);
+    if (heap_violations > 0) {
+        // Куча могла вырасти в окрашенную область - ее затирание неотличимо от стека
+        Serial.println(" B: UNRELIABLE (allocations after lock)");
+    } else {
+        Serial.println(peak <= STACK_BUDGET_BYTES ? " B: OK" : " B: EXCEEDED");
+    }
+    Serial.print("Heap: "); Serial.print(heap_locked ? "locked" : "open");
+    Serial.print(", allocations after lock "); Serial.print(heap_violations);
+    if (heap_violations > 0) {
+        Serial.print(", last caller 0x"); Serial.print(last_violation_caller, HEX);
+    }
+    Serial.println();
+}
@@ -0,0 +1,71 @@
+#ifndef MEMORY_MONITOR_H
+#define MEMORY_MONITOR_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+/**
+ * Контроль RAM: выделения динамической памяти после инициализации и
+ * максимальная глубина стека
+ *
+ * Запрет кучи (HEAP_FREE_BUILD) проверяет сборка: модули src/ не должны
+ * ссылаться на malloc/new вообще (tools/size_report.py). Библиотеки
+ * выделяют буферы (Wire, USB) в setup(); malloc/calloc/realloc и их
+ * _r-варианты обернуты на этапе компоновки (-Wl,--wrap в platformio.ini),
+ * operator new проходит через malloc. После lockHeap() обертки считают
+ * выделения и запоминают адрес вызова (искать через addr2line), но память
+ * выдают: nullptr сломал бы библиотеку молча. Вызов malloc внутри newlib
+ * (malloc -> _malloc_r) учитывается один раз, адрес - внешнего вызова.
+ *
+ * Стек: paintStack() заполняет RAM между кучей и стеком образцом STACK_PAINT;
+ * самое глубокое место, где образец затерт, - максимальная глубина стека.
+ * Куча, выросшая после lockHeap(), тоже затирает образец - при выделениях
+ * после lockHeap() отчет помечает глубину стека как ненадежную.
+ */
+class MemoryMonitor {
+public:
+    static constexpr uint32_t STACK_PAINT = 0xA5A5A5A5;
+
+    /**
+     * Отметить конец инициализации: дальнейшие выделения - нарушения (вызывать в конце setup)
+     */
+    static void lockHeap();
+
+    /**
+     * Проверить, закончена ли инициализация памяти
+     * @return true после lockHeap()
+     */
+    static bool isHeapLocked();
+
+    /**
+     * Заполнить свободную RAM между кучей и текущим стеком образцом
+     * Вызывать после lockHeap(): куча без нарушений больше не растет в окрашенную область,
+     * выделения после lockHeap() делают замер ненадежным
+     */
+    static void paintStack();
+
+    /**
+     * Получить максимальную глубину стека с момента окраски
+     * @return байт от вершины RAM до самого глубокого затертого слова
+     */
+    static uint32_t getStackPeak();
+
+    /**
+     * Получить запас стека
+     * @return байт окрашенной области, которые ни разу не затирались
+     */
+    static uint32_t getStackFree();
+
+    /**
+     * Получить количество выделений памяти после lockHeap()
+     * @return количество вызовов после lockHeap()
+     */
+    static uint32_t getHeapViolations();
+
+    /**
+     * Вывести отчет в Serial
+     */
+    static void printReport();
+};
+
+#endif // MEMORY_MONITOR_H
@@ -1,5 +1,6 @@
 #include "MotorDriver.h"
 #include "Config.h"
+#include "RuntimeConfig.h"
 
 /**
  * Конструктор для управления двумя пинами с ШИМ
@@ -21,8 +22,11 @@ void MotorDriver::begin() {
     pinMode(pin_b, OUTPUT);
     
     // Изначально остановить двигатель
-    stop();
     is_enabled = true;
+    stop();
+    // stop() пишет ШИМ только при смене скорости - первая запись (и настройка таймера
+    // ядром в analogWrite) должна пройти здесь, в setup(), а не при первом движении
+    writePWM(PWM_OFF, PWM_OFF);
 }
 
 /**
@@ -37,6 +41,9 @@ void MotorDriver::setSpeed(int16_t speed) {
     // Валидация и ограничение скорости
     speed = clampSpeed(speed);
     
+    // Прямая установка отменяет плавный переход, иначе update() вернет прежнюю цель
+    smooth_transition_active = false;
+    
     // Обновить текущую скорость только если она изменилась
     if (current_speed != speed) {
         current_speed = speed;
@@ -70,6 +77,13 @@ void MotorDriver::getDiagnostics(uint8_t& pin_a_value, uint8_t& pin_b_value) con
     pin_b_value = (current_speed < STOP_SPEED) ? static_cast<uint8_t>(-current_speed) : PWM_OFF;
 }
 
+/**
+ * Повторно записать текущее заполнение на пины (состояние двигателя не меняется)
+ */
+void MotorDriver::refreshPWM() {
+    applyPWMSignals(current_speed);
+}
+
 /**
  * Применить ШИМ сигналы к пинам двигателя
  * @param speed - скорость от -255 до +255
@@ -77,19 +91,26 @@ void MotorDriver::getDiagnostics(uint8_t& pin_a_value, uint8_t& pin_b_value) con
 void MotorDriver::applyPWMSignals(int16_t speed) {
     if (speed == STOP_SPEED) {
         // Остановка - оба пина в 0
-        analogWrite(pin_a, PWM_OFF);
-        analogWrite(pin_b, PWM_OFF);
+        writePWM(PWM_OFF, PWM_OFF);
     } else if (speed > STOP_SPEED) {
         // Прямое вращение - ШИМ на пин A, 0 на пин B
-        analogWrite(pin_a, static_cast<uint8_t>(speed));
-        analogWrite(pin_b, PWM_OFF);
+        writePWM(static_cast<uint8_t>(speed), PWM_OFF);
     } else {
         // Обратное вращение - 0 на пин A, ШИМ на пин B
-        analogWrite(pin_a, PWM_OFF);
-        analogWrite(pin_b, static_cast<uint8_t>(-speed));
+        writePWM(PWM_OFF, static_cast<uint8_t>(-speed));
     }
 }
 
+/**
+ * Записать коэффициенты заполнения ШИМ на пины через analogWrite()
+ * @param duty_a - заполнение на пине A (0..255)
+ * @param duty_b - заполнение на пине B (0..255)
+ */
+void MotorDriver::writePWM(uint8_t duty_a, uint8_t duty_b) {
+    analogWrite(pin_a, duty_a);
+    analogWrite(pin_b, duty_b);
+}
+
 /**
  * Ограничить скорость в допустимом диапазоне
  * @param speed - исходная скорость
@@ -150,7 +171,7 @@ void MotorDriver::update() {
     unsigned long current_time = millis();
     
     // Проверяем, прошло ли достаточно времени для следующего шага
-    if (current_time - last_step_time >= SMOOTH_START_STEP_MS) {
+    if (current_time - last_step_time >= runtimeConfig.smooth_start_step_ms) {
         // Вычисляем прогресс перехода (0.0 до 1.0)
         float progress = (float)current_step / step_count;
         
@@ -199,7 +220,7 @@ void MotorDriver::startSmoothTransition(int16_t target_speed) {
     
     // Вычисляем количество шагов
     int16_t speed_diff = abs(target_speed - start_speed);
-    step_count = speed_diff / SMOOTH_START_STEP_SIZE;
+    step_count = speed_diff / runtimeConfig.smooth_start_step_size;
     
     // Увеличиваем количество шагов для более плавного старта
     step_count = max(step_count * 2, 10); // Минимум 10 шагов
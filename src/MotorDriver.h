@@ -11,12 +11,22 @@
  * - Остановка: 0 на оба пина
  */
 class MotorDriver {
+protected:
+    static constexpr uint8_t PWM_OFF = 0;
+    
+    /**
+     * Записать коэффициенты заполнения ШИМ на пины
+     * Базовая реализация - analogWrite(); MotorDriverFast пишет регистры таймера
+     * @param duty_a - заполнение на пине A (0..255)
+     * @param duty_b - заполнение на пине B (0..255)
+     */
+    virtual void writePWM(uint8_t duty_a, uint8_t duty_b);
+
 private:
     // Константы
     static constexpr int16_t MAX_SPEED = 255;
     static constexpr int16_t MIN_SPEED = -255;
     static constexpr int16_t STOP_SPEED = 0;
-    static constexpr uint8_t PWM_OFF = 0;
     
     // Поля класса
     const uint8_t pin_a;         // Пин A (для прямого вращения)
@@ -46,6 +56,8 @@ public:
      */
     MotorDriver(uint8_t pin_a, uint8_t pin_b);
     
+    virtual ~MotorDriver() = default;
+    
     /**
      * Инициализация драйвера
      */
@@ -75,6 +87,12 @@ public:
      */
     void getDiagnostics(uint8_t& pin_a_value, uint8_t& pin_b_value) const;
     
+    /**
+     * Повторно записать текущее заполнение на пины (состояние двигателя не меняется)
+     * Для замера времени записи ШИМ командой "bench"
+     */
+    void refreshPWM();
+    
     /**
      * Установить скорость с плавным переходом
      * @param speed - целевая скорость от -255 до +255
@@ -0,0 +1,107 @@
+#ifndef MOTOR_DRIVER_FAST_H
+#define MOTOR_DRIVER_FAST_H
+
+#include <Arduino.h>
+#include "FastPin.h"
+#include "MotorDriver.h"
+
+/**
+ * Вариант MotorDriver с пинами, заданными на этапе компиляции
+ * Таймер и канал ШИМ известны при компиляции, обновление заполнения -
+ * одна запись в регистр CCR вместо analogWrite(). Логика плавного
+ * перехода наследуется от MotorDriver без изменений.
+ */
+template <PinName PinA, PinName PinB>
+class MotorDriverFast : public MotorDriver {
+    static_assert(FastPin<PinA>::TIMER_BASE != 0, "Пин A не выводится на канал таймера");
+    static_assert(FastPin<PinB>::TIMER_BASE != 0, "Пин B не выводится на канал таймера");
+
+private:
+    // Поле OCxM: ШИМ режим 1 (как настраивает ядро) и "всегда активен"
+    static constexpr uint32_t OC_MODE_MASK = 0x7;
+    static constexpr uint32_t OC_MODE_PWM1 = 0x6;
+    static constexpr uint32_t OC_MODE_FORCE_ACTIVE = 0x5;
+    static constexpr uint8_t FULL_DUTY = 255;
+
+    uint32_t scale_a;    // Период таймера пина A / 255, фиксированная точка 16.16
+    uint32_t scale_b;    // Период таймера пина B / 255, фиксированная точка 16.16
+    bool saturates_a;    // Период таймера пина A 65536: CCR не достигает 100%
+    bool saturates_b;    // Период таймера пина B 65536: CCR не достигает 100%
+    bool forced_a;       // Канал пина A в режиме "всегда активен"
+    bool forced_b;       // Канал пина B в режиме "всегда активен"
+
+    /**
+     * Рассчитать масштаб заполнения для периода таймера
+     * Округление вверх дает (duty * scale) >> 16 == duty * period / 255 без деления;
+     * ограничение не дает переполниться произведению при duty = 255 (только при
+     * периоде 65536: CCR = 65535, 100% дает writeChannel)
+     * @param period - период таймера (ARR + 1)
+     * @return масштаб в фиксированной точке 16.16
+     */
+    static uint32_t dutyScale(uint32_t period) {
+        uint64_t scale = ((static_cast<uint64_t>(period) << 16) + 254) / 255;
+        return static_cast<uint32_t>(min(scale, static_cast<uint64_t>(UINT32_MAX / 255)));
+    }
+
+protected:
+    /**
+     * Записать коэффициенты заполнения напрямую в регистры сравнения
+     * Масштаб такой же, как у analogWrite() с 8-битным разрешением
+     * @param duty_a - заполнение на пине A (0..255)
+     * @param duty_b - заполнение на пине B (0..255)
+     */
+    void writePWM(uint8_t duty_a, uint8_t duty_b) override {
+        writeChannel<PinA>(duty_a, scale_a, saturates_a, forced_a);
+        writeChannel<PinB>(duty_b, scale_b, saturates_b, forced_b);
+    }
+
+    /**
+     * Записать заполнение одного канала
+     * При ARR = 0xFFFF заполнению 255 нужен CCR = 65536, который не помещается
+     * в 16-битный регистр, - канал переводится в режим "всегда активен"
+     * @param duty - заполнение (0..255)
+     * @param scale - масштаб заполнения канала
+     * @param saturates - период таймера 65536
+     * @param forced - ссылка на флаг режима "всегда активен"
+     */
+    template <PinName Pin>
+    static inline void writeChannel(uint8_t duty, uint32_t scale, bool saturates, bool& forced) {
+        bool force = saturates && duty == FULL_DUTY;
+        if (force != forced) {
+            volatile uint32_t* mode = FastPin<Pin>::modeRegister();
+            *mode = (*mode & ~(OC_MODE_MASK << FastPin<Pin>::MODE_SHIFT)) |
+                    ((force ? OC_MODE_FORCE_ACTIVE : OC_MODE_PWM1) << FastPin<Pin>::MODE_SHIFT);
+            forced = force;
+        }
+        *FastPin<Pin>::compareRegister() = (duty * scale) >> 16;
+    }
+
+public:
+    /**
+     * Конструктор
+     */
+    MotorDriverFast()
+        : MotorDriver(pinNametoDigitalPin(PinA), pinNametoDigitalPin(PinB)),
+          scale_a(0), scale_b(0), saturates_a(false), saturates_b(false),
+          forced_a(false), forced_b(false) {
+    }
+
+    /**
+     * Инициализация драйвера
+     * analogWrite() вызывается один раз, чтобы ядро настроило таймер и
+     * альтернативную функцию пинов; далее запись идет в регистры напрямую
+     */
+    void begin() {
+        MotorDriver::begin();
+        analogWrite(pinNametoDigitalPin(PinA), PWM_OFF);
+        analogWrite(pinNametoDigitalPin(PinB), PWM_OFF);
+        uint32_t period_a = FastPin<PinA>::timer()->ARR + 1;
+        uint32_t period_b = FastPin<PinB>::timer()->ARR + 1;
+        scale_a = dutyScale(period_a);
+        scale_b = dutyScale(period_b);
+        saturates_a = period_a > 0xFFFF;
+        saturates_b = period_b > 0xFFFF;
+    }
+};
+
+#endif // MOTOR_DRIVER_FAST_H
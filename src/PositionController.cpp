@@ -0,0 +1,195 @@
+#include "PositionController.h"
+
+/**
+ * Конструктор класса PositionController
+ */
+PositionController::PositionController()
+    : zero_count(0), last_count(0), started(false), homed(false), active(false), settled(false),
+      target(0), velocity_cps(0.0f), velocity_setpoint_cps(0.0f), integral(0.0f), output(0) {
+}
+
+/**
+ * Обновить регулятор (вызывать каждые POSITION_LOOP_INTERVAL_US)
+ * @param encoder_count - расширенный счетчик энкодера
+ * @param interval_us - время с предыдущего обновления в мкс
+ * @return заполнение -255..255 (0 если регулятор не активен)
+ */
+int16_t PositionController::update(int32_t encoder_count, uint32_t interval_us) {
+    int32_t delta = started ? encoder_count - last_count : 0;
+    started = true;
+    last_count = encoder_count;
+    if (interval_us == 0) {
+        return output;
+    }
+
+    // Скорость по приращению счетчика, сглаженная однополюсным фильтром
+    float dt = interval_us * 1e-6f;
+    float raw_velocity = delta * GRIPPER_CLOSE_DIRECTION / dt;
+    velocity_cps += (raw_velocity - velocity_cps) * POSITION_VELOCITY_FILTER;
+
+    if (!active) {
+        output = MOTOR_SPEED_STOP;
+        return output;
+    }
+
+    // Внешний контур: положение -> заданная скорость
+    int32_t error = target - getPosition();
+    int32_t distance = (error >= 0) ? error : -error;
+    if (distance <= POSITION_DEADBAND_COUNTS && fabsf(velocity_cps) <= POSITION_SETTLE_VELOCITY_CPS) {
+        settled = true;
+    } else if (distance > 2 * POSITION_DEADBAND_COUNTS) {
+        settled = false;
+    }
+    if (settled) {
+        integral = 0.0f;
+        velocity_setpoint_cps = 0.0f;
+        output = MOTOR_SPEED_STOP;
+        return output;
+    }
+    velocity_setpoint_cps = constrain(POSITION_KP * error, -POSITION_MAX_VELOCITY_CPS, POSITION_MAX_VELOCITY_CPS);
+
+    // Внутренний контур: скорость -> заполнение
+    float velocity_error = velocity_setpoint_cps - velocity_cps;
+    float feedforward = velocity_setpoint_cps * POSITION_VELOCITY_FF;
+    float duty = feedforward + POSITION_VELOCITY_KP * velocity_error + integral;
+
+    // Anti-windup: интеграл растет, только если это не углубляет насыщение
+    bool saturated_high = duty >= MOTOR_SPEED_FORWARD && velocity_error > 0.0f;
+    bool saturated_low = duty <= MOTOR_SPEED_REVERSE && velocity_error < 0.0f;
+    if (!saturated_high && !saturated_low) {
+        integral += POSITION_VELOCITY_KI * velocity_error * dt;
+    }
+
+    duty = constrain(duty, static_cast<float>(MOTOR_SPEED_REVERSE), static_cast<float>(MOTOR_SPEED_FORWARD));
+    output = static_cast<int16_t>(lroundf(duty)) * GRIPPER_CLOSE_DIRECTION;
+    return output;
+}
+
+/**
+ * Задать положение и включить регулятор
+ * @param permille - положение 0 (открыт) .. 1000 (закрыт)
+ * @return false если ноль не задан
+ */
+bool PositionController::setTarget(uint16_t permille) {
+    if (!homed) {
+        return false;
+    }
+    int32_t new_target = static_cast<int32_t>(min(permille, static_cast<uint16_t>(1000))) * ENCODER_COUNTS_PER_TRAVEL / 1000;
+    if (!active || new_target != target) {
+        settled = false;
+    }
+    target = new_target;
+    active = true;
+    return true;
+}
+
+/**
+ * Выключить регулятор (двигатель управляется скоростью)
+ */
+void PositionController::disable() {
+    active = false;
+    settled = false;
+    integral = 0.0f;
+    velocity_setpoint_cps = 0.0f;
+    output = MOTOR_SPEED_STOP;
+}
+
+/**
+ * Сбросить интеграл (двигатель остановлен защитой)
+ */
+void PositionController::resetIntegral() {
+    integral = 0.0f;
+}
+
+/**
+ * Сообщить об упоре при движении
+ * @param speed - скорость, с которой двигался захват
+ */
+void PositionController::onStall(int16_t speed) {
+    bool opening = (speed > 0) != (GRIPPER_CLOSE_DIRECTION > 0);
+    if (speed != 0 && opening && (!homed || getPosition() <= ENCODER_REHOME_WINDOW_COUNTS)) {
+        home(false);
+    }
+}
+
+/**
+ * Задать ноль в текущем положении
+ * @param closed - true - захват закрыт, false - открыт
+ */
+void PositionController::home(bool closed) {
+    int32_t position = closed ? ENCODER_COUNTS_PER_TRAVEL : 0;
+    zero_count = last_count - position * GRIPPER_CLOSE_DIRECTION;
+    homed = true;
+}
+
+/**
+ * Получить положение
+ * @return отсчеты энкодера от края "открыт"
+ */
+int32_t PositionController::getPosition() const {
+    return (last_count - zero_count) * GRIPPER_CLOSE_DIRECTION;
+}
+
+/**
+ * Получить положение в промилле хода
+ * @return 0 (открыт) .. 1000 (закрыт)
+ */
+uint16_t PositionController::getPositionPermille() const {
+    return constrain(static_cast<int64_t>(getPosition()) * 1000 / ENCODER_COUNTS_PER_TRAVEL, 0LL, 1000LL);
+}
+
+/**
+ * Получить заданное положение
+ * @return отсчеты энкодера от края "открыт"
+ */
+int32_t PositionController::getTarget() const {
+    return target;
+}
+
+/**
+ * Получить оценку скорости
+ * @return отсчетов/с, + к закрытию
+ */
+float PositionController::getVelocity() const {
+    return velocity_cps;
+}
+
+/**
+ * Проверить, управляет ли регулятор двигателем
+ * @return true если задано положение
+ */
+bool PositionController::isActive() const {
+    return active;
+}
+
+/**
+ * Проверить, достигнута ли цель
+ * @return true если положение в зоне нечувствительности и захват стоит
+ */
+bool PositionController::isSettled() const {
+    return settled;
+}
+
+/**
+ * Проверить, задан ли ноль
+ * @return true если положение привязано к краю хода
+ */
+bool PositionController::isHomed() const {
+    return homed;
+}
+
+/**
+ * Вывести отчет в Serial
+ */
+void PositionController::printReport() const {
+    Serial.print("Encoder: "); Serial.print(getPosition());
+    Serial.print("/"); Serial.print(ENCODER_COUNTS_PER_TRAVEL);
+    Serial.print(" counts ("); Serial.print(getPositionPermille() / 10.0f, 1);
+    Serial.print("%)"); Serial.println(homed ? " homed" : " NOT HOMED");
+    Serial.print("Control: "); Serial.print(active ? (settled ? "settled" : "moving") : "off");
+    Serial.print(" target="); Serial.print(target);
+    Serial.print(" velocity="); Serial.print(velocity_cps, 0);
+    Serial.print("/"); Serial.print(velocity_setpoint_cps, 0);
+    Serial.print(" cps duty="); Serial.print(output);
+    Serial.print(" integral="); Serial.println(integral, 1);
+}
@@ -0,0 +1,127 @@
+#ifndef POSITION_CONTROLLER_H
+#define POSITION_CONTROLLER_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+/**
+ * Регулятор положения губок по энкодеру: каскад P (положение) -> PI (скорость)
+ *
+ * Внешний контур: заданная скорость = POSITION_KP * ошибка положения,
+ * ограниченная POSITION_MAX_VELOCITY_CPS. Внутренний контур: заполнение =
+ * прямая связь по скорости + POSITION_VELOCITY_KP * ошибка скорости + интеграл.
+ * Интеграл не растет, пока заполнение в насыщении (anti-windup).
+ * В пределах POSITION_DEADBAND_COUNTS от цели при малой скорости двигатель
+ * останавливается, интеграл сбрасывается.
+ *
+ * Положение - отсчеты энкодера от края "открыт". Ноль задается первым упором
+ * при открытии (хоминг) и переустанавливается упором у этого края.
+ * Не обращается к аппаратуре: счетчик энкодера передается в update(),
+ * поэтому регулятор проверяется на модели (tools/position_sim).
+ */
+class PositionController {
+private:
+    int32_t zero_count;           // Счетчик энкодера в положении "открыт"
+    int32_t last_count;           // Счетчик при предыдущем обновлении
+    bool started;                 // Было хотя бы одно обновление
+    bool homed;                   // Ноль задан
+    bool active;                  // Регулятор управляет двигателем
+    bool settled;                 // Цель достигнута
+    int32_t target;               // Заданное положение (отсчеты)
+    float velocity_cps;           // Оценка скорости (отсчетов/с)
+    float velocity_setpoint_cps;  // Заданная скорость (отсчетов/с)
+    float integral;               // Интеграл внутреннего контура (единицы заполнения)
+    int16_t output;               // Последнее заполнение
+
+public:
+    /**
+     * Конструктор
+     */
+    PositionController();
+
+    /**
+     * Обновить регулятор (вызывать каждые POSITION_LOOP_INTERVAL_US)
+     * @param encoder_count - расширенный счетчик энкодера
+     * @param interval_us - время с предыдущего обновления в мкс
+     * @return заполнение -255..255 (0 если регулятор не активен)
+     */
+    int16_t update(int32_t encoder_count, uint32_t interval_us);
+
+    /**
+     * Задать положение и включить регулятор
+     * @param permille - положение 0 (открыт) .. 1000 (закрыт)
+     * @return false если ноль не задан
+     */
+    bool setTarget(uint16_t permille);
+
+    /**
+     * Выключить регулятор (двигатель управляется скоростью)
+     */
+    void disable();
+
+    /**
+     * Сбросить интеграл (двигатель остановлен защитой)
+     */
+    void resetIntegral();
+
+    /**
+     * Сообщить об упоре при движении
+     * @param speed - скорость, с которой двигался захват
+     */
+    void onStall(int16_t speed);
+
+    /**
+     * Задать ноль в текущем положении
+     * @param closed - true - захват закрыт, false - открыт
+     */
+    void home(bool closed);
+
+    /**
+     * Получить положение
+     * @return отсчеты энкодера от края "открыт"
+     */
+    int32_t getPosition() const;
+
+    /**
+     * Получить положение в промилле хода
+     * @return 0 (открыт) .. 1000 (закрыт)
+     */
+    uint16_t getPositionPermille() const;
+
+    /**
+     * Получить заданное положение
+     * @return отсчеты энкодера от края "открыт"
+     */
+    int32_t getTarget() const;
+
+    /**
+     * Получить оценку скорости
+     * @return отсчетов/с, + к закрытию
+     */
+    float getVelocity() const;
+
+    /**
+     * Проверить, управляет ли регулятор двигателем
+     * @return true если задано положение
+     */
+    bool isActive() const;
+
+    /**
+     * Проверить, достигнута ли цель
+     * @return true если положение в зоне нечувствительности и захват стоит
+     */
+    bool isSettled() const;
+
+    /**
+     * Проверить, задан ли ноль
+     * @return true если положение привязано к краю хода
+     */
+    bool isHomed() const;
+
+    /**
+     * Вывести отчет в Serial
+     */
+    void printReport() const;
+};
+
+#endif // POSITION_CONTROLLER_H
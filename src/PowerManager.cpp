@@ -0,0 +1,145 @@
+#include "PowerManager.h"
+
+/**
+ * Конструктор класса PowerManager
+ */
+PowerManager::PowerManager()
+    : mode(MODE_ACTIVE), last_activity_ms(0), stats_start_ms(0), sleep_time_us(0), deep_idle_time_ms(0),
+      deep_idle_start_ms(0), wake_count(0), deep_idle_entries(0), wake_time_us(0), wake_pending(false),
+      wake_latency_us(WAKE_LATENCY_BIN_US) {
+}
+
+/**
+ * Отметить движение или команду (выход из глубокого простоя)
+ * @param now_ms - текущее время в мс
+ */
+void PowerManager::noteActivity(uint32_t now_ms) {
+    last_activity_ms = now_ms;
+    if (mode == MODE_DEEP_IDLE) {
+        deep_idle_time_ms += now_ms - deep_idle_start_ms;
+        mode = MODE_ACTIVE;
+    }
+}
+
+/**
+ * Обновить режим (вызывать каждый такт управления)
+ * @param now_ms - текущее время в мс
+ * @return true если режим сменился
+ */
+bool PowerManager::update(uint32_t now_ms) {
+    if (!IDLE_DEEP_ENABLED || mode == MODE_DEEP_IDLE || now_ms - last_activity_ms < IDLE_DEEP_AFTER_MS) {
+        return false;
+    }
+    mode = MODE_DEEP_IDLE;
+    deep_idle_start_ms = now_ms;
+    deep_idle_entries++;
+    return true;
+}
+
+/**
+ * Заснуть до срока или до появления работы
+ * @param deadline_ms - срок пробуждения по millis()
+ * @param work_pending - проверка наличия работы после каждого пробуждения
+ * @return true если проснулись из-за работы, false - по сроку
+ */
+bool PowerManager::sleepUntil(uint32_t deadline_ms, bool (*work_pending)()) {
+    uint32_t start_us = micros();
+    bool woken = false;
+    // millis() растет в SysTick, который и будит ядро - срок проверяется каждую мс
+    while (static_cast<int32_t>(deadline_ms - millis()) > 0) {
+        if (work_pending()) {
+            woken = true;
+            break;
+        }
+#if defined(STM32F1xx)
+        __WFI();
+#endif
+    }
+    uint32_t now_us = micros();
+    sleep_time_us += now_us - start_us;
+    if (woken) {
+        wake_count++;
+        wake_time_us = now_us;
+        wake_pending = true;
+    }
+    return woken;
+}
+
+/**
+ * Отметить обработку события, разбудившего цикл (для задержки пробуждения)
+ */
+void PowerManager::markAction() {
+    if (wake_pending) {
+        wake_latency_us.add(micros() - wake_time_us);
+        wake_pending = false;
+    }
+}
+
+/**
+ * Получить текущий режим
+ * @return режим
+ */
+PowerManager::Mode PowerManager::getMode() const {
+    return mode;
+}
+
+/**
+ * Получить период такта управления для текущего режима
+ * @return период в мс
+ */
+uint32_t PowerManager::getTickInterval_ms() const {
+    return (mode == MODE_DEEP_IDLE) ? IDLE_DEEP_TICK_MS : CONTROL_TICK_INTERVAL_MS;
+}
+
+/**
+ * Получить долю времени во сне
+ * @return доля от 0 до 1
+ */
+float PowerManager::getSleepRatio() const {
+    uint32_t elapsed_ms = millis() - stats_start_ms;
+    return elapsed_ms ? min(static_cast<float>(sleep_time_us) / (elapsed_ms * 1000.0f), 1.0f) : 0.0f;
+}
+
+/**
+ * Оценить средний ток МК по доле сна
+ * @return ток в мА (по типовым значениям MCU_RUN_CURRENT_MA и MCU_SLEEP_CURRENT_MA)
+ */
+float PowerManager::getEstimatedCurrent_mA() const {
+    float ratio = getSleepRatio();
+    return MCU_RUN_CURRENT_MA * (1.0f - ratio) + MCU_SLEEP_CURRENT_MA * ratio;
+}
+
+/**
+ * Сбросить статистику
+ */
+void PowerManager::reset() {
+    stats_start_ms = millis();
+    sleep_time_us = 0;
+    deep_idle_time_ms = 0;
+    deep_idle_start_ms = millis();
+    wake_count = 0;
+    deep_idle_entries = 0;
+    wake_pending = false;
+    wake_latency_us.reset();
+}
+
+/**
+ * Вывести отчет в Serial
+ */
+void PowerManager::printReport() const {
+    uint32_t deep_ms = deep_idle_time_ms + ((mode == MODE_DEEP_IDLE) ? millis() - deep_idle_start_ms : 0);
+
+    Serial.print("Power: "); Serial.print(mode == MODE_DEEP_IDLE ? "DEEP IDLE" : "ACTIVE");
+    Serial.print(", tick "); Serial.print(getTickInterval_ms());
+    Serial.print(" ms, sleep "); Serial.print(getSleepRatio() * 100.0f, 1);
+    Serial.print("%, deep idle "); Serial.print(deep_ms / 1000.0f, 1);
+    Serial.print(" s ("); Serial.print(deep_idle_entries);
+    Serial.print(" entries), wakes "); Serial.println(wake_count);
+    Serial.print("MCU current estimate: "); Serial.print(MCU_RUN_CURRENT_MA, 1);
+    Serial.print(" mA without sleep -> "); Serial.print(getEstimatedCurrent_mA(), 1);
+    Serial.println(" mA");
+    wake_latency_us.print("Wake latency", "us");
+    Serial.print("Wake latency max "); Serial.print(wake_latency_us.getMax());
+    Serial.print(" us, control period "); Serial.print(CONTROL_TICK_INTERVAL_MS * 1000UL);
+    Serial.println(wake_latency_us.getMax() <= CONTROL_TICK_INTERVAL_MS * 1000UL ? " us: OK" : " us: EXCEEDED");
+}
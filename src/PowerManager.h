@@ -0,0 +1,113 @@
+#ifndef POWER_MANAGER_H
+#define POWER_MANAGER_H
+
+#include <Arduino.h>
+#include "Config.h"
+#include "LoopTiming.h"
+
+/**
+ * Сон между событиями основного цикла и режим глубокого простоя
+ *
+ * Вместо delay() цикл засыпает в WFI до ближайшего запланированного события
+ * (такт управления, измерение тока). Ядро просыпается от любого прерывания:
+ * SysTick (1 мс), фронт импульса RC, прием по USB. После пробуждения
+ * проверяется, есть ли работа; если нет и срок не наступил - снова WFI.
+ * Прерывание между проверкой и WFI задерживает реакцию не более чем до
+ * следующего SysTick (1 мс).
+ *
+ * Без движения и команд дольше IDLE_DEEP_AFTER_MS включается глубокий простой:
+ * такт управления IDLE_DEEP_TICK_MS, ток измеряется только на тактах.
+ * Импульс, требующий движения, или команда выводят из него сразу.
+ *
+ * Статистика: доля времени во сне, число пробуждений, гистограмма задержки
+ * от пробуждения до обработки события и оценка тока МК по доле сна.
+ */
+class PowerManager {
+public:
+    // Режим работы
+    enum Mode : uint8_t {
+        MODE_ACTIVE = 0,      // Обычный такт управления
+        MODE_DEEP_IDLE = 1    // Редкий такт, нет движения и команд
+    };
+
+private:
+    Mode mode;                        // Текущий режим
+    uint32_t last_activity_ms;        // Время последнего движения или команды
+    uint32_t stats_start_ms;          // Начало накопления статистики
+    uint64_t sleep_time_us;           // Суммарное время во сне
+    uint32_t deep_idle_time_ms;       // Суммарное время в глубоком простое
+    uint32_t deep_idle_start_ms;      // Начало текущего глубокого простоя
+    uint32_t wake_count;              // Количество пробуждений по событию
+    uint32_t deep_idle_entries;       // Количество входов в глубокий простой
+    uint32_t wake_time_us;            // Время последнего пробуждения
+    bool wake_pending;                // Пробуждение еще не обработано
+    TimingHistogram wake_latency_us;  // Задержка от пробуждения до обработки
+
+public:
+    /**
+     * Конструктор
+     */
+    PowerManager();
+
+    /**
+     * Отметить движение или команду (выход из глубокого простоя)
+     * @param now_ms - текущее время в мс
+     */
+    void noteActivity(uint32_t now_ms);
+
+    /**
+     * Обновить режим (вызывать каждый такт управления)
+     * @param now_ms - текущее время в мс
+     * @return true если режим сменился
+     */
+    bool update(uint32_t now_ms);
+
+    /**
+     * Заснуть до срока или до появления работы
+     * @param deadline_ms - срок пробуждения по millis()
+     * @param work_pending - проверка наличия работы после каждого пробуждения
+     * @return true если проснулись из-за работы, false - по сроку
+     */
+    bool sleepUntil(uint32_t deadline_ms, bool (*work_pending)());
+
+    /**
+     * Отметить обработку события, разбудившего цикл (для задержки пробуждения)
+     */
+    void markAction();
+
+    /**
+     * Получить текущий режим
+     * @return режим
+     */
+    Mode getMode() const;
+
+    /**
+     * Получить период такта управления для текущего режима
+     * @return период в мс
+     */
+    uint32_t getTickInterval_ms() const;
+
+    /**
+     * Получить долю времени во сне
+     * @return доля от 0 до 1
+     */
+    float getSleepRatio() const;
+
+    /**
+     * Оценить средний ток МК по доле сна
+     * @return ток в мА (по типовым значениям MCU_RUN_CURRENT_MA и MCU_SLEEP_CURRENT_MA)
+     */
+    float getEstimatedCurrent_mA() const;
+
+    /**
+     * Сбросить статистику
+     */
+    void reset();
+
+    /**
+     * Вывести отчет в Serial
+     */
+    void printReport() const;
+};
+
+#endif // POWER_MANAGER_H
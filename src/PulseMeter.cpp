@@ -1,5 +1,6 @@
 #include "PulseMeter.h"
 #include "Config.h"
+#include "LoopTiming.h"
 
 // Инициализация статического указателя на экземпляр
 PulseMeter* PulseMeter::instance = nullptr;
@@ -63,6 +64,9 @@ void PulseMeter::handleInterrupt() {
  * Измеряет время между передним и задним фронтами
  */
 void PulseMeter::handlePulseInterrupt() {
+    // Измерение задержки входа в прерывание - как можно раньше
+    LoopTiming::onPulseEdge();
+    
     static uint32_t last_rising_time = 0;  // Время последнего переднего фронта
     static uint32_t last_interrupt_time = 0;  // Время последнего прерывания
     uint32_t current_time = micros();      // Текущее время в микросекундах
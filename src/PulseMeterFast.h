@@ -0,0 +1,116 @@
+#ifndef PULSE_METER_FAST_H
+#define PULSE_METER_FAST_H
+
+#include <Arduino.h>
+#include "Config.h"
+#include "FastPin.h"
+#include "LoopTiming.h"
+
+/**
+ * Вариант PulseMeter с пином, заданным на этапе компиляции
+ * Обработчик прерывания читает уровень пина одним чтением регистра IDR
+ * вместо digitalRead(). Интерфейс совпадает с PulseMeter.
+ * Один экземпляр на пин - состояние хранится в статических полях.
+ */
+template <PinName Pin>
+class PulseMeterFast {
+private:
+    // Константы
+    static constexpr uint32_t DEBOUNCE_US = 10;  // Защита от дребезга
+
+    // Поля класса (общие для экземпляров с одним пином)
+    static volatile uint32_t pulse_width_us;     // Длина импульса в микросекундах
+    static volatile bool waiting_for_rising;     // Флаг ожидания переднего фронта
+    static volatile bool new_pulse_available;    // Флаг наличия нового измерения
+
+    /**
+     * Обработчик прерываний для измерения импульсов
+     */
+    static void handleInterrupt() {
+        // Измерение задержки входа в прерывание - как можно раньше
+        LoopTiming::onPulseEdge();
+
+        static uint32_t last_rising_time = 0;     // Время последнего переднего фронта
+        static uint32_t last_interrupt_time = 0;  // Время последнего прерывания
+        uint32_t current_time = micros();
+
+        // Защита от дребезга контактов
+        if (current_time - last_interrupt_time < DEBOUNCE_US) {
+            return;
+        }
+        last_interrupt_time = current_time;
+
+        // Уровень читается один раз: второе чтение IDR могло увидеть уже другой фронт
+        bool level = FastPin<Pin>::read();
+        if (level && waiting_for_rising) {
+            // Передний фронт
+            last_rising_time = current_time;
+            waiting_for_rising = false;
+        } else if (!level && !waiting_for_rising) {
+            // Задний фронт; вычитание без знака корректно при переполнении micros()
+            uint32_t width = current_time - last_rising_time;
+            if (width >= PULSE_MIN_US && width <= PULSE_MAX_US) {
+                pulse_width_us = width;
+                new_pulse_available = true;
+            }
+            waiting_for_rising = true;
+        }
+    }
+
+public:
+    /**
+     * Инициализация измерения импульсов
+     * Поиск номера пина и прерывания выполняется один раз здесь
+     */
+    void begin() {
+        uint32_t pin = pinNametoDigitalPin(Pin);
+        pinMode(pin, INPUT_PULLDOWN);
+
+        waiting_for_rising = true;
+        pulse_width_us = 0;
+        new_pulse_available = false;
+
+        attachInterrupt(digitalPinToInterrupt(pin), handleInterrupt, CHANGE);
+    }
+
+    /**
+     * Получить последнюю измеренную длину импульса в микросекундах
+     */
+    uint32_t getPulseWidth() const {
+        return pulse_width_us;
+    }
+
+    /**
+     * Проверить наличие нового измерения импульса
+     */
+    bool isNewPulseAvailable() const {
+        return new_pulse_available;
+    }
+
+    /**
+     * Получить длину импульса и сбросить флаг за один вызов
+     */
+    uint32_t getPulseWidthAndClear() {
+        uint32_t width = pulse_width_us;
+        new_pulse_available = false;
+        return width;
+    }
+
+    /**
+     * Получить диагностическую информацию
+     * @param pin_state - текущее состояние пина
+     * @param waiting_for_rising - флаг ожидания переднего фронта
+     * @param new_pulse_available - флаг наличия нового измерения
+     */
+    void getDiagnostics(bool& pin_state, bool& waiting_for_rising, bool& new_pulse_available) const {
+        pin_state = FastPin<Pin>::read();
+        waiting_for_rising = PulseMeterFast::waiting_for_rising;
+        new_pulse_available = PulseMeterFast::new_pulse_available;
+    }
+};
+
+template <PinName Pin> volatile uint32_t PulseMeterFast<Pin>::pulse_width_us = 0;
+template <PinName Pin> volatile bool PulseMeterFast<Pin>::waiting_for_rising = true;
+template <PinName Pin> volatile bool PulseMeterFast<Pin>::new_pulse_available = false;
+
+#endif // PULSE_METER_FAST_H
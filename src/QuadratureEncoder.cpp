@@ -0,0 +1,43 @@
+#include "QuadratureEncoder.h"
+
+/**
+ * Конструктор класса QuadratureEncoder
+ */
+QuadratureEncoder::QuadratureEncoder() : last_raw(0), count(0) {
+}
+
+/**
+ * Настроить TIM3 в режим энкодера и обнулить счетчик
+ */
+void QuadratureEncoder::begin() {
+    pinMode(ENCODER_A_PIN, INPUT_PULLUP);
+    pinMode(ENCODER_B_PIN, INPUT_PULLUP);
+
+    RCC->APB1ENR |= RCC_APB1ENR_TIM3EN;
+    TIM3->CR1 = 0;
+
+    // Оба канала - входы TI1/TI2 с цифровым фильтром (8 тактов подряд), счет по обоим фронтам
+    TIM3->CCMR1 = TIM_CCMR1_CC1S_0 | TIM_CCMR1_CC2S_0 |
+                  TIM_CCMR1_IC1F_0 | TIM_CCMR1_IC1F_1 |
+                  TIM_CCMR1_IC2F_0 | TIM_CCMR1_IC2F_1;
+    TIM3->CCER = ENCODER_REVERSED ? TIM_CCER_CC1P : 0;
+    TIM3->SMCR = TIM_SMCR_SMS_0 | TIM_SMCR_SMS_1;
+    TIM3->PSC = 0;
+    TIM3->ARR = 0xFFFF;
+    TIM3->CNT = 0;
+    TIM3->CR1 = TIM_CR1_CEN;
+
+    last_raw = 0;
+    count = 0;
+}
+
+/**
+ * Прочитать расширенный счетчик (вызывать чаще, чем проходит 32768 отсчетов)
+ * @return отсчеты с момента begin(), знак - по направлению вращения
+ */
+int32_t QuadratureEncoder::read() {
+    uint16_t raw = static_cast<uint16_t>(TIM3->CNT);
+    count = extend(count, last_raw, raw);
+    last_raw = raw;
+    return count;
+}
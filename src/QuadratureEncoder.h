@@ -0,0 +1,49 @@
+#ifndef QUADRATURE_ENCODER_H
+#define QUADRATURE_ENCODER_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+/**
+ * Квадратурный энкодер на TIM3 в режиме энкодера (PA6 - канал A, PA7 - канал B)
+ *
+ * Таймер считает оба фронта обоих каналов (x4) аппаратно, процессор на фронты
+ * не тратится. 16-битный счетчик расширяется до 32 бит по разности со
+ * значением при предыдущем чтении: читать нужно чаще, чем проходит
+ * 32768 отсчетов (при такте регулятора 1 мс - до 32 млн отсчетов/с).
+ */
+class QuadratureEncoder {
+private:
+    uint16_t last_raw;            // Счетчик таймера при предыдущем чтении
+    int32_t count;                // Расширенный счетчик
+
+public:
+    /**
+     * Конструктор
+     */
+    QuadratureEncoder();
+
+    /**
+     * Настроить TIM3 в режим энкодера и обнулить счетчик
+     */
+    void begin();
+
+    /**
+     * Прочитать расширенный счетчик (вызывать чаще, чем проходит 32768 отсчетов)
+     * @return отсчеты с момента begin(), знак - по направлению вращения
+     */
+    int32_t read();
+
+    /**
+     * Расширить 16-битный счетчик до 32 бит
+     * @param previous - расширенный счетчик при предыдущем чтении
+     * @param previous_raw - 16-битный счетчик при предыдущем чтении
+     * @param raw - 16-битный счетчик сейчас
+     * @return расширенный счетчик
+     */
+    static inline int32_t extend(int32_t previous, uint16_t previous_raw, uint16_t raw) {
+        return previous + static_cast<int16_t>(static_cast<uint16_t>(raw - previous_raw));
+    }
+};
+
+#endif // QUADRATURE_ENCODER_H
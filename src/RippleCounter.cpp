@@ -0,0 +1,140 @@
+#include "RippleCounter.h"
+
+/**
+ * Конструктор класса RippleCounter
+ */
+RippleCounter::RippleCounter()
+    : baseline_q8(0), amplitude_q8(0), primed(false), high(false), last_sample_us(0),
+      last_ripple_us(0), min_period_us(0), pending_count(0), pending_gap_us(0), total_count(0), rejected_count(0),
+      gap_count(0), sample_count(0) {
+}
+
+/**
+ * Обработать сэмпл тока (постоянное время)
+ * @param sample - отсчет регистра шунта
+ * @param time_us - время сэмпла в мкс
+ * @return true если обнаружена пульсация
+ */
+bool RippleCounter::addSample(int32_t sample, uint32_t time_us) {
+    int32_t sample_q8 = sample * (1L << STATE_SHIFT);
+    sample_count++;
+
+    // Первый сэмпл: начальная постоянная составляющая
+    if (!primed) {
+        baseline_q8 = sample_q8;
+        amplitude_q8 = 0;
+        high = false;
+        primed = true;
+        last_sample_us = time_us;
+        return false;
+    }
+    uint32_t elapsed_us = time_us - last_sample_us;
+    last_sample_us = time_us;
+
+    // Разделение на постоянную и переменную составляющие
+    baseline_q8 += (sample_q8 - baseline_q8) >> RIPPLE_BASELINE_SHIFT;
+    int32_t ac_q8 = sample_q8 - baseline_q8;
+    int32_t magnitude_q8 = (ac_q8 >= 0) ? ac_q8 : -ac_q8;
+    amplitude_q8 += (magnitude_q8 - amplitude_q8) >> RIPPLE_AMPLITUDE_SHIFT;
+
+    // Пропуск: амплитуда и постоянная составляющая за это время почти не меняются,
+    // но фазу пульсаций восстановить нельзя - триггер синхронизируется без счета
+    if (elapsed_us > RIPPLE_MAX_GAP_US) {
+        gap_count++;
+        pending_gap_us += elapsed_us;
+        high = ac_q8 > 0;
+        return false;
+    }
+
+    if (amplitude_q8 < (RIPPLE_MIN_AMPLITUDE_RAW << STATE_SHIFT)) {
+        return false;
+    }
+
+    // Триггер Шмитта с порогом, пропорциональным амплитуде
+    int32_t threshold_q8 = (amplitude_q8 * RIPPLE_THRESHOLD_Q7) >> 7;
+    if (!high && ac_q8 > threshold_q8) {
+        high = true;
+        if (time_us - last_ripple_us < min_period_us) {
+            rejected_count++;
+            return false;
+        }
+        last_ripple_us = time_us;
+        pending_count++;
+        total_count++;
+        return true;
+    }
+    if (high && ac_q8 < -threshold_q8) {
+        high = false;
+    }
+    return false;
+}
+
+/**
+ * Забрать количество пульсаций с предыдущего вызова
+ * @return количество пульсаций
+ */
+uint32_t RippleCounter::takeCount() {
+    uint32_t count = pending_count;
+    pending_count = 0;
+    return count;
+}
+
+/**
+ * Забрать длительность пропусков сэмплов с предыдущего вызова
+ * @return длительность в мкс
+ */
+uint32_t RippleCounter::takeGapTime() {
+    uint32_t gap_us = pending_gap_us;
+    pending_gap_us = 0;
+    return gap_us;
+}
+
+/**
+ * Задать минимальный правдоподобный период пульсаций
+ * @param period_us - период в мкс (0 - без ограничения)
+ */
+void RippleCounter::setMinPeriod(uint32_t period_us) {
+    min_period_us = period_us;
+}
+
+/**
+ * Проверить, наблюдаются ли пульсации (амплитуда выше порога)
+ * @return true если пульсации различимы на фоне шума
+ */
+bool RippleCounter::isObservable() const {
+    return primed && amplitude_q8 >= (RIPPLE_MIN_AMPLITUDE_RAW << STATE_SHIFT);
+}
+
+/**
+ * Получить амплитуду переменной составляющей
+ * @return средний модуль в отсчетах шунта
+ */
+int32_t RippleCounter::getAmplitude() const {
+    return amplitude_q8 >> STATE_SHIFT;
+}
+
+/**
+ * Сбросить состояние детектора (статистика сохраняется)
+ * Вызывать при остановке двигателя: первый сэмпл после пуска не считается пропуском
+ */
+void RippleCounter::reset() {
+    primed = false;
+    high = false;
+    amplitude_q8 = 0;
+    pending_count = 0;
+    pending_gap_us = 0;
+}
+
+/**
+ * Получить статистику детектора
+ * @param total - всего пульсаций
+ * @param rejected - отброшено по минимальному периоду
+ * @param gaps - сбросов из-за пропуска сэмплов
+ * @param samples - обработано сэмплов
+ */
+void RippleCounter::getStats(uint32_t& total, uint32_t& rejected, uint32_t& gaps, uint32_t& samples) const {
+    total = total_count;
+    rejected = rejected_count;
+    gaps = gap_count;
+    samples = sample_count;
+}
@@ -0,0 +1,104 @@
+#ifndef RIPPLE_COUNTER_H
+#define RIPPLE_COUNTER_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+/**
+ * Детектор коммутационных пульсаций тока коллекторного двигателя
+ *
+ * Каждый сэмпл обрабатывается за постоянное время (без циклов и делений):
+ *   1. Постоянная составляющая отслеживается EMA (сдвиг RIPPLE_BASELINE_SHIFT),
+ *      остаток - переменная составляющая (пульсации)
+ *   2. Амплитуда - EMA модуля переменной составляющей (сдвиг RIPPLE_AMPLITUDE_SHIFT)
+ *   3. Триггер Шмитта с порогом +-амплитуда * RIPPLE_THRESHOLD_Q7 / 128:
+ *      переход снизу вверх - одна пульсация
+ *   4. Пульсация ближе минимального периода к предыдущей отбрасывается (помеха)
+ * Пульсации считаются только когда амплитуда не меньше RIPPLE_MIN_AMPLITUDE_RAW,
+ * иначе детектор сообщает, что пульсации не наблюдаются.
+ * После пропуска сэмплов дольше RIPPLE_MAX_GAP_US триггер синхронизируется
+ * без счета, длительность пропуска накапливается для восполнения по модели.
+ *
+ * Единица сэмпла - отсчет регистра шунта INA219 (10 мкВ).
+ */
+class RippleCounter {
+private:
+    static constexpr uint8_t STATE_SHIFT = 8;   // Дробные биты состояния
+
+    int32_t baseline_q8;          // Постоянная составляющая (Q8)
+    int32_t amplitude_q8;         // Средний модуль переменной составляющей (Q8)
+    bool primed;                  // Состояние инициализировано
+    bool high;                    // Триггер Шмитта в верхнем состоянии
+    uint32_t last_sample_us;      // Время предыдущего сэмпла
+    uint32_t last_ripple_us;      // Время предыдущей пульсации
+    uint32_t min_period_us;       // Минимальный правдоподобный период пульсаций
+    uint32_t pending_count;       // Пульсаций с последнего takeCount()
+    uint32_t pending_gap_us;      // Длительность пропусков с последнего takeGapTime()
+
+    // Статистика
+    uint32_t total_count;         // Всего пульсаций
+    uint32_t rejected_count;      // Отброшено по минимальному периоду
+    uint32_t gap_count;           // Сбросов из-за пропуска сэмплов
+    uint32_t sample_count;        // Обработано сэмплов
+
+public:
+    /**
+     * Конструктор
+     */
+    RippleCounter();
+
+    /**
+     * Обработать сэмпл тока (постоянное время)
+     * @param sample - отсчет регистра шунта
+     * @param time_us - время сэмпла в мкс
+     * @return true если обнаружена пульсация
+     */
+    bool addSample(int32_t sample, uint32_t time_us);
+
+    /**
+     * Забрать количество пульсаций с предыдущего вызова
+     * @return количество пульсаций
+     */
+    uint32_t takeCount();
+
+    /**
+     * Забрать длительность пропусков сэмплов с предыдущего вызова
+     * @return длительность в мкс
+     */
+    uint32_t takeGapTime();
+
+    /**
+     * Задать минимальный правдоподобный период пульсаций
+     * @param period_us - период в мкс (0 - без ограничения)
+     */
+    void setMinPeriod(uint32_t period_us);
+
+    /**
+     * Проверить, наблюдаются ли пульсации (амплитуда выше порога)
+     * @return true если пульсации различимы на фоне шума
+     */
+    bool isObservable() const;
+
+    /**
+     * Получить амплитуду переменной составляющей
+     * @return средний модуль в отсчетах шунта
+     */
+    int32_t getAmplitude() const;
+
+    /**
+     * Сбросить состояние детектора (статистика сохраняется)
+     * Вызывать при остановке двигателя: первый сэмпл после пуска не считается пропуском
+     */
+    void reset();
+
+    /**
+     * Получить статистику детектора
+     * @param total - всего пульсаций
+     * @param rejected - отброшено по минимальному периоду
+     * @param gaps - сбросов из-за пропуска сэмплов
+     * @param samples - обработано сэмплов
+     */
+    void getStats(uint32_t& total, uint32_t& rejected, uint32_t& gaps, uint32_t& samples) const;
+};
+
+#endif // RIPPLE_COUNTER_H
@@ -0,0 +1,72 @@
+#include "RuntimeConfig.h"
+
+// constexpr: runtimeConfig инициализируется статически, до конструкторов глобальных объектов
+constexpr RuntimeConfig RuntimeConfig::DEFAULTS = {
+    PWM_DEADZONE_MIN_US,
+    PWM_DEADZONE_MAX_US,
+    CURRENT_PROTECTION_THRESHOLD_MA,
+    MOTOR_START_DELAY_MS,
+    SMOOTH_START_STEP_MS,
+    SMOOTH_START_STEP_SIZE,
+    COMMAND_HEARTBEAT_TIMEOUT_MS,
+    TELEMETRY_DEFAULT_PERIOD_MS
+};
+
+RuntimeConfig runtimeConfig = RuntimeConfig::DEFAULTS;
+
+const RuntimeConfig::Field RuntimeConfig::FIELDS[RuntimeConfig::FIELD_COUNT] = {
+    {"deadzone_min", &RuntimeConfig::pwm_deadzone_min_us, PWM_MIN_US, PWM_NEUTRAL_US, "us"},
+    {"deadzone_max", &RuntimeConfig::pwm_deadzone_max_us, PWM_NEUTRAL_US, PWM_MAX_US, "us"},
+    {"threshold", &RuntimeConfig::protection_threshold_mA, GRIP_CURRENT_MIN_MA, GRIP_CURRENT_MAX_MA, "mA"},
+    {"start_delay", &RuntimeConfig::motor_start_delay_ms, 0, 10000, "ms"},
+    {"ramp_step_ms", &RuntimeConfig::smooth_start_step_ms, 1, 1000, "ms"},
+    {"ramp_step", &RuntimeConfig::smooth_start_step_size, 1, MOTOR_SPEED_FORWARD, ""},
+    {"heartbeat", &RuntimeConfig::heartbeat_timeout_ms, 50, 10000, "ms"},
+    {"tm_period", &RuntimeConfig::telemetry_period_ms, 1, 60000, "ms"},
+};
+
+/**
+ * Проверить значения полей и их согласованность
+ * @return nullptr если конфигурация допустима, иначе описание ошибки
+ */
+const char* RuntimeConfig::validate() const {
+    for (uint8_t i = 0; i < FIELD_COUNT; i++) {
+        uint16_t value = this->*FIELDS[i].member;
+        if (value < FIELDS[i].min || value > FIELDS[i].max) {
+            return FIELDS[i].name;
+        }
+    }
+    if (pwm_deadzone_min_us >= pwm_deadzone_max_us) {
+        return "deadzone_min >= deadzone_max";
+    }
+    return nullptr;
+}
+
+/**
+ * Найти поле по имени
+ * @param name - имя поля
+ * @return описание поля или nullptr
+ */
+const RuntimeConfig::Field* RuntimeConfig::findField(const char* name) {
+    for (uint8_t i = 0; i < FIELD_COUNT; i++) {
+        if (strcmp(FIELDS[i].name, name) == 0) {
+            return &FIELDS[i];
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * Вывести все поля в Serial (отличающиеся от умолчаний помечаются '*')
+ */
+void RuntimeConfig::print() const {
+    for (uint8_t i = 0; i < FIELD_COUNT; i++) {
+        const Field& field = FIELDS[i];
+        uint16_t value = this->*field.member;
+        Serial.print(value != DEFAULTS.*field.member ? "* " : "  ");
+        Serial.print(field.name); Serial.print(" = "); Serial.print(value);
+        Serial.print(" "); Serial.print(field.unit);
+        Serial.print(" ["); Serial.print(field.min); Serial.print(".."); Serial.print(field.max);
+        Serial.print("], default "); Serial.println(DEFAULTS.*field.member);
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef RUNTIME_CONFIG_H
+#define RUNTIME_CONFIG_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+/**
+ * Настройки, изменяемые без перепрошивки (команда "cfg", хранение во flash)
+ *
+ * Значения по умолчанию - константы Config.h. При загрузке ConfigStore
+ * копирует сохраненный блок в глобальную runtimeConfig один раз; управляющий
+ * код читает поля напрямую (одна загрузка по фиксированному адресу, без
+ * указателей и вызовов), как раньше читал константы.
+ *
+ * При изменении набора или смысла полей увеличить VERSION: блоки другой
+ * версии не загружаются, используются значения по умолчанию.
+ */
+struct RuntimeConfig {
+    static constexpr uint16_t VERSION = 2;    // 2: print_interval заменен на tm_period
+
+    uint16_t pwm_deadzone_min_us;     // Мертвая зона RC, нижняя граница (мкс)
+    uint16_t pwm_deadzone_max_us;     // Мертвая зона RC, верхняя граница (мкс)
+    uint16_t protection_threshold_mA; // Порог защиты по току (мА)
+    uint16_t motor_start_delay_ms;    // Задержка защиты после пуска (мс)
+    uint16_t smooth_start_step_ms;    // Интервал шагов плавного разгона (мс)
+    uint16_t smooth_start_step_size;  // Шаг скорости плавного разгона
+    uint16_t heartbeat_timeout_ms;    // Таймаут связи двоичного протокола (мс)
+    uint16_t telemetry_period_ms;     // Период подписки телеметрии по умолчанию (мс)
+
+    // Описание поля для команды "cfg"
+    struct Field {
+        const char* name;                 // Имя в команде
+        uint16_t RuntimeConfig::* member; // Поле структуры
+        uint16_t min;                     // Допустимый минимум
+        uint16_t max;                     // Допустимый максимум
+        const char* unit;                 // Единица измерения
+    };
+
+    static constexpr uint8_t FIELD_COUNT = 8;
+    static const Field FIELDS[FIELD_COUNT];
+    static const RuntimeConfig DEFAULTS;
+
+    /**
+     * Проверить значения полей и их согласованность
+     * @return nullptr если конфигурация допустима, иначе описание ошибки
+     */
+    const char* validate() const;
+
+    /**
+     * Найти поле по имени
+     * @param name - имя поля
+     * @return описание поля или nullptr
+     */
+    static const Field* findField(const char* name);
+
+    /**
+     * Вывести все поля в Serial (отличающиеся от умолчаний помечаются '*')
+     */
+    void print() const;
+};
+
+// Рабочая конфигурация (до загрузки из flash - значения по умолчанию)
+extern RuntimeConfig runtimeConfig;
+
+#endif // RUNTIME_CONFIG_H
@@ -0,0 +1,99 @@
+#include "SerialCommands.h"
+
+/**
+ * Конструктор класса SerialCommands
+ */
+SerialCommands::SerialCommands()
+    : command_count(0), line_length(0), line_overflow(false) {
+    line[0] = '\0';
+}
+
+/**
+ * Зарегистрировать команду
+ * @param name - имя команды
+ * @param handler - обработчик
+ * @param help - краткое описание для команды "help"
+ * @return true если команда добавлена
+ */
+bool SerialCommands::addCommand(const char* name, Handler handler, const char* help) {
+    if (command_count >= MAX_COMMANDS || name == nullptr || handler == nullptr) {
+        return false;
+    }
+
+    commands[command_count].name = name;
+    commands[command_count].handler = handler;
+    commands[command_count].help = help;
+    command_count++;
+    return true;
+}
+
+/**
+ * Обработать один принятый байт
+ * @param c - принятый символ
+ */
+void SerialCommands::processChar(char c) {
+    if (c == '\n' || c == '\r') {
+        if (line_overflow) {
+            Serial.println("Команда слишком длинная");
+        } else if (line_length > 0) {
+            line[line_length] = '\0';
+            executeLine();
+        }
+        line_length = 0;
+        line_overflow = false;
+        return;
+    }
+
+    if (line_length < MAX_LINE_LENGTH) {
+        line[line_length++] = c;
+    } else {
+        line_overflow = true;
+    }
+}
+
+/**
+ * Разобрать и выполнить накопленную строку
+ */
+void SerialCommands::executeLine() {
+    char* argv[MAX_ARGS];
+    uint8_t argc = 0;
+
+    // Разбиение строки на аргументы по пробелам (на месте, без копирования)
+    char* p = line;
+    while (*p != '\0' && argc < MAX_ARGS) {
+        while (*p == ' ' || *p == '\t') *p++ = '\0';
+        if (*p == '\0') break;
+        argv[argc++] = p;
+        while (*p != '\0' && *p != ' ' && *p != '\t') p++;
+    }
+
+    if (argc == 0) {
+        return;
+    }
+
+    if (strcmp(argv[0], "help") == 0) {
+        printHelp();
+        return;
+    }
+
+    for (uint8_t i = 0; i < command_count; i++) {
+        if (strcmp(argv[0], commands[i].name) == 0) {
+            commands[i].handler(argc, argv);
+            return;
+        }
+    }
+
+    Serial.print("Неизвестная команда: ");
+    Serial.println(argv[0]);
+}
+
+/**
+ * Вывести список команд
+ */
+void SerialCommands::printHelp() const {
+    for (uint8_t i = 0; i < command_count; i++) {
+        Serial.print(commands[i].name);
+        Serial.print(" - ");
+        Serial.println(commands[i].help != nullptr ? commands[i].help : "");
+    }
+}
@@ -0,0 +1,65 @@
+#ifndef SERIAL_COMMANDS_H
+#define SERIAL_COMMANDS_H
+
+#include <Arduino.h>
+
+/**
+ * Класс для обработки текстовых команд из последовательного порта
+ * Команда - строка вида "<имя> [аргумент...]", завершенная '\n' или '\r'
+ * Буфер строки и таблица команд фиксированного размера, без динамической памяти
+ */
+class SerialCommands {
+public:
+    // Обработчик команды: количество аргументов и массив аргументов (argv[0] - имя)
+    typedef void (*Handler)(uint8_t argc, char* argv[]);
+
+private:
+    // Константы
+    static constexpr uint8_t MAX_COMMANDS = 24;
+    static constexpr uint8_t MAX_LINE_LENGTH = 64;
+    static constexpr uint8_t MAX_ARGS = 8;
+
+    struct Command {
+        const char* name;    // Имя команды
+        Handler handler;     // Обработчик
+        const char* help;    // Краткое описание
+    };
+
+    // Поля класса
+    Command commands[MAX_COMMANDS];    // Таблица команд
+    uint8_t command_count;             // Количество зарегистрированных команд
+    char line[MAX_LINE_LENGTH + 1];    // Буфер текущей строки
+    uint8_t line_length;               // Длина текущей строки
+    bool line_overflow;                // Строка не поместилась в буфер
+
+    // Разобрать и выполнить накопленную строку
+    void executeLine();
+
+public:
+    /**
+     * Конструктор
+     */
+    SerialCommands();
+
+    /**
+     * Зарегистрировать команду
+     * @param name - имя команды
+     * @param handler - обработчик
+     * @param help - краткое описание для команды "help"
+     * @return true если команда добавлена
+     */
+    bool addCommand(const char* name, Handler handler, const char* help);
+
+    /**
+     * Обработать один принятый байт
+     * @param c - принятый символ
+     */
+    void processChar(char c);
+
+    /**
+     * Вывести список команд
+     */
+    void printHelp() const;
+};
+
+#endif // SERIAL_COMMANDS_H
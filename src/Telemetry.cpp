@@ -0,0 +1,238 @@
+#include "Telemetry.h"
+
+const Telemetry::ChannelInfo Telemetry::CHANNELS[Telemetry::CHANNEL_COUNT] = {
+    {"pulse", "us", 0, "control tick"},
+    {"current", "mA", 2, "INA219 measurement"},
+    {"voltage", "V", 3, "INA219 measurement"},
+    {"power", "mW", 1, "INA219 measurement"},
+    {"shunt", "mA", 1, "shunt read, 1 kHz (4 kHz while counting ripple)"},
+    {"speed", "", 0, "control tick"},
+    {"commanded", "", 0, "control tick"},
+    {"state", "", 0, "control tick"},
+    {"position", "permille", 0, "control tick, when homed"},
+    {"jitter", "us", 0, "control tick"},
+    {"loop", "us", 0, "loop pass"},
+};
+
+// Степени 10 для вывода в фиксированной точке
+static const uint32_t POW10[] = {1, 10, 100, 1000, 10000};
+
+/**
+ * Вывести целое значение с заданным числом знаков после запятой
+ * @param value - значение
+ * @param decimals - знаков после запятой (0..4)
+ */
+static void printFixed(int32_t value, uint8_t decimals) {
+    uint32_t magnitude = (value < 0) ? 0UL - static_cast<uint32_t>(value) : static_cast<uint32_t>(value);
+    if (value < 0) {
+        Serial.print('-');
+    }
+    if (decimals == 0) {
+        Serial.print(magnitude);
+        return;
+    }
+    uint32_t scale = POW10[decimals];
+    uint32_t fraction = magnitude % scale;
+    Serial.print(magnitude / scale);
+    Serial.print('.');
+    for (uint32_t digit = scale / 10; digit > 1 && fraction < digit; digit /= 10) {
+        Serial.print('0');
+    }
+    Serial.print(fraction);
+}
+
+/**
+ * Проверить, закончилось ли окно подписки к моменту time_ms
+ * @param window_start_ms - начало окна
+ * @param period_ms - период окна
+ * @param time_ms - момент времени (раньше начала окна - окно не закончилось)
+ * @return true если закончилось
+ */
+static bool windowExpired(uint32_t window_start_ms, uint16_t period_ms, uint32_t time_ms) {
+    return static_cast<int32_t>(time_ms - window_start_ms) >= static_cast<int32_t>(period_ms);
+}
+
+/**
+ * Конструктор класса Telemetry (подписок нет)
+ */
+Telemetry::Telemetry() : subscriptions(), active_mask(0), lines_sent(0) {
+}
+
+/**
+ * Учесть значение подписанного канала
+ * @param channel - канал
+ * @param value - значение
+ * @param time_ms - время значения
+ */
+void Telemetry::addSample(Channel channel, int32_t value, uint32_t time_ms) {
+    Subscription& sub = subscriptions[channel];
+    bool print_value = sub.period_ms == 0;
+
+    if (!print_value) {
+        if (windowExpired(sub.window_start_ms, sub.period_ms, time_ms)) {
+            closeWindow(channel, time_ms);
+        }
+        if (sub.count == 0 || value < sub.min_value) sub.min_value = value;
+        if (sub.count == 0 || value > sub.max_value) sub.max_value = value;
+        print_value = sub.mode == MODE_FIRST && sub.count == 0;
+        sub.sum += value;
+        sub.count++;
+    }
+
+    if (print_value) {
+        Serial.print("TM "); Serial.print(CHANNELS[channel].name);
+        Serial.print(' '); Serial.print(time_ms);
+        Serial.print(' '); printFixed(value, CHANNELS[channel].decimals);
+        Serial.println();
+        lines_sent++;
+    }
+}
+
+/**
+ * Вывести итог окна и перейти к окну, содержащему time_ms
+ * @param channel - канал
+ * @param time_ms - момент после конца текущего окна
+ */
+void Telemetry::closeWindow(Channel channel, uint32_t time_ms) {
+    Subscription& sub = subscriptions[channel];
+
+    if (sub.mode == MODE_AGGREGATE && sub.count > 0) {
+        // Среднее с округлением к ближайшему
+        int64_t half = sub.count / 2;
+        int32_t mean = static_cast<int32_t>((sub.sum >= 0 ? sub.sum + half : sub.sum - half) /
+                                            static_cast<int64_t>(sub.count));
+        uint8_t decimals = CHANNELS[channel].decimals;
+        Serial.print("TM "); Serial.print(CHANNELS[channel].name);
+        Serial.print(' '); Serial.print(sub.window_start_ms);
+        Serial.print(' '); Serial.print(sub.count);
+        Serial.print(' '); printFixed(sub.min_value, decimals);
+        Serial.print(' '); printFixed(mean, decimals);
+        Serial.print(' '); printFixed(sub.max_value, decimals);
+        Serial.println();
+        lines_sent++;
+    }
+
+    // Следующее окно - по сетке от начала подписки, пропущенные пустые окна не выводятся
+    uint32_t elapsed = time_ms - sub.window_start_ms;
+    sub.window_start_ms += elapsed - elapsed % sub.period_ms;
+    sub.sum = 0;
+    sub.count = 0;
+}
+
+/**
+ * Подписаться на канал (повторная подписка заменяет прежнюю)
+ * @param channel - канал
+ * @param period_ms - период окна (0 - каждое значение)
+ * @param mode - прореживание или агрегирование
+ * @param now_ms - текущее время (начало первого окна)
+ * @return false если агрегирование без периода
+ */
+bool Telemetry::subscribe(Channel channel, uint16_t period_ms, Mode mode, uint32_t now_ms) {
+    if (mode == MODE_AGGREGATE && period_ms == 0) {
+        return false;
+    }
+    Subscription& sub = subscriptions[channel];
+    sub.window_start_ms = now_ms;
+    sub.sum = 0;
+    sub.count = 0;
+    sub.period_ms = period_ms;
+    sub.mode = mode;
+    active_mask |= 1UL << channel;
+    return true;
+}
+
+/**
+ * Отменить подписку на канал
+ * @param channel - канал
+ */
+void Telemetry::unsubscribe(Channel channel) {
+    active_mask &= ~(1UL << channel);
+}
+
+/**
+ * Отменить все подписки
+ */
+void Telemetry::unsubscribeAll() {
+    active_mask = 0;
+}
+
+/**
+ * Вывести окна, время которых истекло
+ * @param now_ms - текущее время
+ */
+void Telemetry::flushExpired(uint32_t now_ms) {
+    for (uint8_t channel = 0; channel < CHANNEL_COUNT; channel++) {
+        const Subscription& sub = subscriptions[channel];
+        if (isActive(static_cast<Channel>(channel)) && sub.period_ms != 0 &&
+            windowExpired(sub.window_start_ms, sub.period_ms, now_ms)) {
+            closeWindow(static_cast<Channel>(channel), now_ms);
+        }
+    }
+}
+
+/**
+ * Получить ближайший конец окна среди подписок
+ * Прореживание в конце окна ничего не выводит - учитываются только агрегирующие подписки
+ * @param now_ms - текущее время
+ * @param deadline_ms - ссылка для записи времени (не меняется, если окон нет)
+ * @return true если есть агрегирующая подписка
+ */
+bool Telemetry::getNextWindowEnd(uint32_t now_ms, uint32_t& deadline_ms) const {
+    bool found = false;
+    int32_t nearest = 0;
+    for (uint8_t channel = 0; channel < CHANNEL_COUNT; channel++) {
+        const Subscription& sub = subscriptions[channel];
+        if (!isActive(static_cast<Channel>(channel)) || sub.mode != MODE_AGGREGATE) {
+            continue;
+        }
+        int32_t until_end = static_cast<int32_t>(sub.window_start_ms + sub.period_ms - now_ms);
+        if (!found || until_end < nearest) {
+            nearest = until_end;
+            found = true;
+        }
+    }
+    if (found) {
+        deadline_ms = now_ms + static_cast<uint32_t>(max(nearest, static_cast<int32_t>(0)));
+    }
+    return found;
+}
+
+/**
+ * Найти канал по имени
+ * @param name - имя канала
+ * @param channel - ссылка для записи канала
+ * @return true если найден
+ */
+bool Telemetry::findChannel(const char* name, Channel& channel) {
+    for (uint8_t i = 0; i < CHANNEL_COUNT; i++) {
+        if (strcmp(name, CHANNELS[i].name) == 0) {
+            channel = static_cast<Channel>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Вывести список каналов и подписок в Serial
+ */
+void Telemetry::printList() const {
+    for (uint8_t channel = 0; channel < CHANNEL_COUNT; channel++) {
+        const ChannelInfo& info = CHANNELS[channel];
+        const Subscription& sub = subscriptions[channel];
+        Serial.print(info.name);
+        if (info.unit[0] != '\0') {
+            Serial.print(" ["); Serial.print(info.unit); Serial.print(']');
+        }
+        Serial.print(" ("); Serial.print(info.source); Serial.print("): ");
+        if (!isActive(static_cast<Channel>(channel))) {
+            Serial.println("off");
+        } else if (sub.period_ms == 0) {
+            Serial.println("every value");
+        } else {
+            Serial.print("every "); Serial.print(sub.period_ms);
+            Serial.println(sub.mode == MODE_AGGREGATE ? " ms, min/mean/max" : " ms, first");
+        }
+    }
+    Serial.print("Lines sent: "); Serial.println(lines_sent);
+}
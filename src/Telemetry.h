@@ -0,0 +1,180 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <Arduino.h>
+#include "Config.h"
+
+/**
+ * Реестр каналов телеметрии с подпиской по запросу хоста (команда "tm")
+ *
+ * Каждый сигнал - именованный канал с целым значением в фиксированной точке
+ * (CHANNELS[].decimals знаков после запятой). Источник публикует значение
+ * с собственной частотой (такт управления, измерение INA219, чтение шунта);
+ * публикация в канал без подписки - одна проверка бита. Вычисление значения,
+ * которое само чего-то стоит (float -> int), вызывающий выполняет только
+ * при isActive().
+ *
+ * Подписка задает период окна и режим:
+ *   MODE_FIRST     - первое значение в каждом окне (прореживание)
+ *                    "TM <канал> <время мс> <значение>"
+ *   MODE_AGGREGATE - минимум, среднее и максимум значений окна
+ *                    "TM <канал> <начало окна мс> <количество> <мин> <среднее> <макс>"
+ * Окна идут по сетке от момента подписки, поэтому частота вывода не уплывает
+ * от задержек цикла; окно без значений не выводится. Период 0 - каждое значение.
+ */
+class Telemetry {
+public:
+    // Каналы (порядок - номер бита в маске подписок)
+    enum Channel : uint8_t {
+        CH_PULSE = 0,      // Длительность импульса RC
+        CH_CURRENT,        // Ток (медленный фильтр)
+        CH_VOLTAGE,        // Напряжение питания
+        CH_POWER,          // Мощность
+        CH_SHUNT,          // Ток по регистру шунта, без фильтров и коррекции нуля
+        CH_SPEED,          // Примененная скорость двигателя
+        CH_COMMANDED,      // Заданная скорость
+        CH_STATE,          // Флаги состояния (RECORDER_STATE_*)
+        CH_POSITION,       // Положение губок (промилле хода), если известно
+        CH_JITTER,         // Джиттер такта управления
+        CH_LOOP,           // Длительность прохода loop()
+        CHANNEL_COUNT
+    };
+
+    enum Mode : uint8_t {
+        MODE_FIRST = 0,
+        MODE_AGGREGATE
+    };
+
+    // Описание канала для списка и вывода
+    struct ChannelInfo {
+        const char* name;       // Имя в команде и выводе
+        const char* unit;       // Единица измерения
+        uint8_t decimals;       // Знаков после запятой в целом значении
+        const char* source;     // Когда публикуется
+    };
+
+    static const ChannelInfo CHANNELS[CHANNEL_COUNT];
+
+private:
+    // Состояние подписки канала
+    struct Subscription {
+        uint32_t window_start_ms;   // Начало текущего окна
+        int64_t sum;                // Сумма значений окна
+        int32_t min_value;          // Минимум окна
+        int32_t max_value;          // Максимум окна
+        uint32_t count;             // Значений в окне
+        uint16_t period_ms;         // Период окна (0 - каждое значение)
+        Mode mode;                  // Режим вывода
+    };
+
+    Subscription subscriptions[CHANNEL_COUNT];
+    uint32_t active_mask;           // Бит канала = есть подписка
+    uint32_t lines_sent;            // Выведено строк
+
+    // Учесть значение подписанного канала
+    void addSample(Channel channel, int32_t value, uint32_t time_ms);
+
+    // Вывести итог окна и перейти к окну, содержащему time_ms
+    void closeWindow(Channel channel, uint32_t time_ms);
+
+public:
+    /**
+     * Конструктор класса Telemetry (подписок нет)
+     */
+    Telemetry();
+
+    /**
+     * Проверить, есть ли подписка на канал
+     * @param channel - канал
+     * @return true если значения канала кому-то нужны
+     */
+    inline bool isActive(Channel channel) const {
+        return (active_mask & (1UL << channel)) != 0;
+    }
+
+    /**
+     * Проверить, есть ли хотя бы одна подписка
+     * @return true если есть
+     */
+    inline bool isAnyActive() const {
+        return active_mask != 0;
+    }
+
+    /**
+     * Опубликовать значение канала (без подписки - ничего не делает)
+     * @param channel - канал
+     * @param value - значение в единицах канала с CHANNELS[].decimals знаками
+     * @param time_ms - время значения
+     */
+    inline void publish(Channel channel, int32_t value, uint32_t time_ms) {
+        if (isActive(channel)) {
+            addSample(channel, value, time_ms);
+        }
+    }
+
+    /**
+     * Подписаться на канал (повторная подписка заменяет прежнюю)
+     * @param channel - канал
+     * @param period_ms - период окна (0 - каждое значение)
+     * @param mode - прореживание или агрегирование
+     * @param now_ms - текущее время (начало первого окна)
+     * @return false если агрегирование без периода
+     */
+    bool subscribe(Channel channel, uint16_t period_ms, Mode mode, uint32_t now_ms);
+
+    /**
+     * Отменить подписку на канал
+     * @param channel - канал
+     */
+    void unsubscribe(Channel channel);
+
+    /**
+     * Отменить все подписки
+     */
+    void unsubscribeAll();
+
+    /**
+     * Вывести окна, время которых истекло (вызывать в каждом проходе loop())
+     * @param now_ms - текущее время
+     */
+    inline void update(uint32_t now_ms) {
+        if (active_mask != 0) {
+            flushExpired(now_ms);
+        }
+    }
+
+    /**
+     * Вывести окна, время которых истекло
+     * @param now_ms - текущее время
+     */
+    void flushExpired(uint32_t now_ms);
+
+    /**
+     * Получить ближайший конец окна среди подписок
+     * @param now_ms - текущее время
+     * @param deadline_ms - ссылка для записи времени (не меняется, если окон нет)
+     * @return true если есть подписка с периодом
+     */
+    bool getNextWindowEnd(uint32_t now_ms, uint32_t& deadline_ms) const;
+
+    /**
+     * Найти канал по имени
+     * @param name - имя канала
+     * @param channel - ссылка для записи канала
+     * @return true если найден
+     */
+    static bool findChannel(const char* name, Channel& channel);
+
+    /**
+     * Получить количество выведенных строк
+     * @return количество строк с момента включения
+     */
+    uint32_t getLinesSent() const { return lines_sent; }
+
+    /**
+     * Вывести список каналов и подписок в Serial
+     */
+    void printList() const;
+};
+
+#endif // TELEMETRY_H
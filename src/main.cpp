@@ -3,129 +3,619 @@
 #include "PulseMeter.h"
 #include "CurrentSensor.h"
 #include "MotorDriver.h"
+#include "LoopTiming.h"
+#include "SerialCommands.h"
+#include "FlightRecorder.h"
+#include "CycleCounter.h"
+#include "GripperController.h"
+#include "PulseMeterFast.h"
+#include "MotorDriverFast.h"
+#include "CommandProtocol.h"
+#include "EnergyMeter.h"
+#include "QuadratureEncoder.h"
+#include "PowerManager.h"
+#include "BootTimeline.h"
+#include "RuntimeConfig.h"
+#include "ConfigStore.h"
+#include "MemoryMonitor.h"
+#include "Telemetry.h"
 
 // Создание экземпляров
+#if FAST_PIN_ACCESS_ENABLED
+PulseMeterFast<PULSE_INPUT_PINNAME> pulseMeter;
+MotorDriverFast<MOTOR_IA_PINNAME, MOTOR_IB_PINNAME> gripperMotor;
+#else
 PulseMeter pulseMeter(PULSE_INPUT_PIN);
-CurrentSensor currentSensor(I2C_SDA_PIN, I2C_SCL_PIN);
 MotorDriver gripperMotor(MOTOR_IA_PIN, MOTOR_IB_PIN);
+#endif
+CurrentSensor currentSensor(I2C_SDA_PIN, I2C_SCL_PIN);
+LoopTiming loopTiming(CONTROL_TICK_INTERVAL_MS);
+GripperController gripperController(gripperMotor, currentSensor);
+SerialCommands serialCommands;
+CommandProtocol commandProtocol;
+FlightRecorder flightRecorder;
+EnergyMeter energyMeter;
+JawPosition jawPosition;
+QuadratureEncoder jawEncoder;
+PositionController positionController;
+PowerManager powerManager;
+BootTimeline bootTimeline;
+Stm32FlashBackend configFlash;
+ConfigStore configStore(configFlash, CONFIG_FLASH_PAGE0_ADDRESS, CONFIG_FLASH_PAGE1_ADDRESS);
+Telemetry telemetry;
 
-// Глобальные переменные
+// Команда "timing": статистика времени выполнения ("timing reset" - сброс)
+void commandTiming(uint8_t argc, char* argv[]) {
+    if (argc > 1 && strcmp(argv[1], "reset") == 0) {
+        loopTiming.reset();
+        Serial.println("Timing statistics reset");
+        return;
+    }
+    loopTiming.printReport();
+}
 
-void setup() {
-  // Инициализация компонентов
-    Serial.begin(SERIAL_BAUD_RATE);
-    while (!Serial) delay(10); // Ждем готовности Serial порта
+// Команда "rec": бортовой самописец ("rec dump", "rec trig", "rec arm")
+void commandRecorder(uint8_t argc, char* argv[]) {
+    if (argc > 1 && strcmp(argv[1], "dump") == 0) {
+        flightRecorder.dump();
+    } else if (argc > 1 && strcmp(argv[1], "trig") == 0) {
+        flightRecorder.trigger(FlightRecorder::TRIGGER_COMMAND, millis());
+        Serial.println("Recorder triggered");
+    } else if (argc > 1 && strcmp(argv[1], "arm") == 0) {
+        flightRecorder.rearm();
+        Serial.println("Recorder armed");
+    } else {
+        flightRecorder.printStats();
+    }
+}
+
+// Команда "bench": сравнение тактов чтения пина и записи ШИМ
+// (digitalRead/analogWrite против прямого доступа к регистрам; запись ШИМ драйвера -
+// тот же writePWM(), что при управлении двигателем)
+void commandBench(uint8_t, char*[]) {
+    const uint16_t iterations = 1000;
+    uint8_t duty_a, duty_b;
+    gripperMotor.getDiagnostics(duty_a, duty_b);
+    volatile bool level = false;
     
-    pulseMeter.begin();
-    currentSensor.begin();
-    gripperMotor.begin();
+    // Запись текущего заполнения не меняет состояние двигателя
+    uint32_t start = CycleCounter::now();
+    for (uint16_t i = 0; i < iterations; i++) level = digitalRead(PULSE_INPUT_PIN);
+    uint32_t read_runtime = CycleCounter::now() - start;
     
-    Serial.println("=== ROV Gripper System ===");
-    Serial.println("Готов к работе...");
-    Serial.println();
+    start = CycleCounter::now();
+    for (uint16_t i = 0; i < iterations; i++) level = FastPin<PULSE_INPUT_PINNAME>::read();
+    uint32_t read_fast = CycleCounter::now() - start;
+    
+    start = CycleCounter::now();
+    for (uint16_t i = 0; i < iterations; i++) {
+        analogWrite(MOTOR_IA_PIN, duty_a);
+        analogWrite(MOTOR_IB_PIN, duty_b);
+    }
+    uint32_t write_runtime = CycleCounter::now() - start;
+    
+    start = CycleCounter::now();
+    for (uint16_t i = 0; i < iterations; i++) gripperMotor.refreshPWM();
+    uint32_t write_driver = CycleCounter::now() - start;
+    (void)level;
+    
+    Serial.print("Pin read, cycles/call: digitalRead="); Serial.print(read_runtime / iterations);
+    Serial.print(" IDR="); Serial.println(read_fast / iterations);
+    Serial.print("PWM write A+B, cycles/call: analogWrite="); Serial.print(write_runtime / iterations);
+    Serial.print(FAST_PIN_ACCESS_ENABLED ? " MotorDriverFast=" : " MotorDriver=");
+    Serial.println(write_driver / iterations);
+}
+
+// Вывести настройку фильтра тока и его групповую задержку
+void printFilter(const char* name, CurrentFilter& filter) {
+    float delay_samples = filter.getGroupDelaySamples();
+    Serial.print(name); Serial.print(": "); Serial.print(filter.getTypeName());
+    Serial.print(", group delay "); Serial.print(delay_samples, 2);
+    Serial.print(" samples = "); Serial.print(delay_samples * currentSensor.getMeasurementInterval(), 1);
+    Serial.println(" ms");
+}
+
+// Команда "filter": настройка фильтров тока
+// "filter fast|slow none|ma <N>|iir <a>|biquad <fc Гц>", "filter hyst <мА>"
+void commandFilter(uint8_t argc, char* argv[]) {
+    if (argc >= 3 && strcmp(argv[1], "hyst") == 0) {
+        currentSensor.setHysteresis(atof(argv[2]));
+    } else if (argc >= 3) {
+        bool fast = strcmp(argv[1], "fast") == 0;
+        if (!fast && strcmp(argv[1], "slow") != 0) {
+            Serial.println("filter: fast|slow|hyst");
+            return;
+        }
+        CurrentFilter& filter = fast ? currentSensor.getFastFilter() : currentSensor.getSlowFilter();
+        float value = (argc >= 4) ? atof(argv[3]) : 0.0f;
+        float sample_rate_hz = 1000.0f / currentSensor.getMeasurementInterval();
+        
+        if (strcmp(argv[2], "none") == 0) {
+            filter.configureNone();
+        } else if (strcmp(argv[2], "ma") == 0 && value >= 1) {
+            // Ограничение до приведения: "ma 300" не должно превратиться в 44 точки
+            filter.configureMovingAverage(static_cast<uint8_t>(min(value, static_cast<float>(CurrentFilter::MAX_TAPS))));
+        } else if (strcmp(argv[2], "iir") == 0 && value > 0) {
+            filter.configureIIR(value);
+        } else if (strcmp(argv[2], "biquad") == 0 && value > 0) {
+            filter.configureBiquad(value, sample_rate_hz);
+        } else {
+            Serial.println("filter: none|ma <N>|iir <a>|biquad <fc>");
+            return;
+        }
+    }
+    
+    printFilter("Fast (protection)", currentSensor.getFastFilter());
+    printFilter("Slow (telemetry)", currentSensor.getSlowFilter());
+    Serial.print("Hysteresis: "); Serial.print(currentSensor.getHysteresis(), 2); Serial.println(" mA");
 }
 
 // Глобальные переменные для упрощения
 static unsigned long lastUpdate = 0;
-static int16_t motor_speed = 0;
-static bool current_protection_active = false;
-static int16_t protection_direction = 0; // Направление при срабатывании защиты
-static unsigned long motor_start_time = 0;
-static bool motor_was_running = false;
-static bool motor_startup_delay_active = false; // Флаг активной задержки после старта
+static bool trace_enabled = false; // Вывод трассы входных данных
 
+// Записать в трассу новый импульс управления
+void tracePulse(unsigned long currentTime, uint32_t pulse_width_us) {
+    if (!trace_enabled) return;
+    Serial.print("T P "); Serial.print(currentTime);
+    Serial.print(' '); Serial.println(pulse_width_us);
+}
 
-// Функция проверки защиты от перегрузки
-void checkCurrentProtection() {
-    if (!currentSensor.isInitialized()) return;
-    
-    unsigned long currentTime = millis();
+// Записать в трассу необработанное измерение датчика тока
+void traceSensor(unsigned long currentTime) {
+    if (!trace_enabled) return;
+    float current_mA, voltage_V, power_mW;
+    currentSensor.getAllMeasurements(current_mA, voltage_V, power_mW);
+    Serial.print("T I "); Serial.print(currentTime);
+    Serial.print(' '); Serial.print(currentSensor.getRawCurrent_mA(), 3);
+    Serial.print(' '); Serial.print(voltage_V, 3);
+    Serial.print(' '); Serial.println(power_mW, 2);
+}
+
+// Записать в трассу цифровую команду (код команды и значение)
+void traceCommand(unsigned long currentTime, uint8_t cmd, int32_t value) {
+    if (!trace_enabled) return;
+    Serial.print("T C "); Serial.print(currentTime);
+    Serial.print(' '); Serial.print(cmd);
+    Serial.print(' '); Serial.println(value);
+}
+
+// Команда "trace": вывод трассы входных данных ("trace on", "trace off")
+void commandTrace(uint8_t argc, char* argv[]) {
+    if (argc > 1 && strcmp(argv[1], "on") == 0) {
+        trace_enabled = true;
+        // Заголовок: версия формата, такт управления, интервал измерения тока,
+        // число полей и значения runtimeConfig в порядке RuntimeConfig::FIELDS
+        Serial.print("T H 2 "); Serial.print(CONTROL_TICK_INTERVAL_MS);
+        Serial.print(' '); Serial.print(CURRENT_MEASUREMENT_INTERVAL);
+        Serial.print(' '); Serial.print(RuntimeConfig::FIELD_COUNT);
+        for (uint8_t i = 0; i < RuntimeConfig::FIELD_COUNT; i++) {
+            Serial.print(' '); Serial.print(runtimeConfig.*RuntimeConfig::FIELDS[i].member);
+        }
+        Serial.println();
+    } else if (argc > 1 && strcmp(argv[1], "off") == 0) {
+        trace_enabled = false;
+    }
+    Serial.println(trace_enabled ? "Trace: on" : "Trace: off");
+}
+
+// Флаги состояния контроллера (общие для самописца и ответа на запрос)
+uint8_t controllerStateFlags() {
+    uint8_t state = 0;
+    if (gripperController.isProtectionActive()) state |= RECORDER_STATE_PROTECTION;
+    if (gripperController.isStartupDelayActive()) state |= RECORDER_STATE_STARTUP;
+    if (gripperMotor.isSmoothTransitionActive()) state |= RECORDER_STATE_RAMPING;
+    if (currentSensor.isInitialized()) state |= RECORDER_STATE_SENSOR_OK;
+    if (gripperController.getSource() == GripperController::SOURCE_DIGITAL) state |= RECORDER_STATE_DIGITAL;
+    return state;
+}
+
+// Записать 16-битное значение в буфер ответа (little-endian)
+static uint8_t putUint16(uint8_t* out, uint16_t value) {
+    out[0] = value & 0xFF;
+    out[1] = value >> 8;
+    return 2;
+}
+
+// Записать 32-битное значение в буфер ответа (little-endian)
+static uint8_t putUint32(uint8_t* out, uint32_t value) {
+    putUint16(out, value & 0xFFFF);
+    putUint16(out + 2, value >> 16);
+    return 4;
+}
+
+// Выполнить принятый кадр двоичного протокола и отправить ответ
+void handleBinaryFrame(unsigned long currentTime) {
+    const CommandProtocol::Frame& frame = commandProtocol.getFrame();
+    CommandProtocol::Status status = CommandProtocol::STATUS_OK;
+    uint8_t response[CommandProtocol::MAX_PAYLOAD - 1];
+    uint8_t length = 0;
     
-    // Проверяем, работает ли двигатель
-    uint8_t pin_a_value, pin_b_value;
-    gripperMotor.getDiagnostics(pin_a_value, pin_b_value);
+    // Любой корректный кадр подтверждает связь
+    gripperController.digitalHeartbeat(currentTime);
     
-    if (pin_a_value > 0 || pin_b_value > 0) {
-        // Двигатель работает
-        if (!motor_was_running) {
-            // Двигатель только что запустился
-            motor_start_time = currentTime;
-            motor_was_running = true;
-            motor_startup_delay_active = true;
-            Serial.println("Motor started, waiting " + String(MOTOR_START_DELAY_MS) + "ms for startup...");
+    switch (frame.cmd) {
+        case CommandProtocol::CMD_PING:
+            break;
+            
+        case CommandProtocol::CMD_SET_SPEED: {
+            if (frame.length != 2) {
+                status = CommandProtocol::STATUS_BAD_LENGTH;
+                break;
+            }
+            int16_t speed = static_cast<int16_t>(frame.payload[0] | (frame.payload[1] << 8));
+            if (speed < MOTOR_SPEED_REVERSE || speed > MOTOR_SPEED_FORWARD) {
+                status = CommandProtocol::STATUS_BAD_VALUE;
+                break;
+            }
+            traceCommand(currentTime, frame.cmd, speed);
+            if (!gripperController.setDigitalSpeed(speed, currentTime)) {
+                status = CommandProtocol::STATUS_REJECTED;
+            }
+            break;
         }
         
-        // Проверяем ток только после завершения задержки старта
-        if (motor_startup_delay_active && currentTime - motor_start_time >= MOTOR_START_DELAY_MS) {
-            motor_startup_delay_active = false;
-            Serial.println("Startup delay completed, current protection active");
+        case CommandProtocol::CMD_SET_GRIP_CURRENT: {
+            if (frame.length != 2) {
+                status = CommandProtocol::STATUS_BAD_LENGTH;
+                break;
+            }
+            uint16_t threshold_mA = frame.payload[0] | (frame.payload[1] << 8);
+            if (threshold_mA < GRIP_CURRENT_MIN_MA || threshold_mA > GRIP_CURRENT_MAX_MA) {
+                status = CommandProtocol::STATUS_BAD_VALUE;
+                break;
+            }
+            traceCommand(currentTime, frame.cmd, threshold_mA);
+            runtimeConfig.protection_threshold_mA = threshold_mA;
+            break;
         }
         
-        // Измеряем ток только если задержка старта завершена
-        if (!motor_startup_delay_active) {
-            float current_mA = currentSensor.getCurrent_mA();
+        case CommandProtocol::CMD_SET_POSITION: {
+            if (frame.length != 2) {
+                status = CommandProtocol::STATUS_BAD_LENGTH;
+                break;
+            }
+            uint16_t permille = frame.payload[0] | (frame.payload[1] << 8);
+            if (permille > 1000) {
+                status = CommandProtocol::STATUS_BAD_VALUE;
+                break;
+            }
+            traceCommand(currentTime, frame.cmd, permille);
+            if (!gripperController.setPositionTarget(permille, currentTime)) {
+                status = CommandProtocol::STATUS_REJECTED;
+            }
+            break;
+        }
+        
+        case CommandProtocol::CMD_STOP:
+            traceCommand(currentTime, frame.cmd, 0);
+            gripperController.digitalStop(currentTime);
+            break;
             
-            // Защита при превышении абсолютного значения тока
-            if (current_mA >= CURRENT_PROTECTION_THRESHOLD_MA) {
-                if (!current_protection_active) {
-                    current_protection_active = true;
-                    protection_direction = motor_speed; // Запоминаем направление при срабатывании
-                    Serial.println("ЗАЩИТА! Ток: " + String(current_mA, 1) + "mA, направление: " + 
-                                 (motor_speed > 0 ? "ВПЕРЕД" : "НАЗАД"));
-                }
-                gripperMotor.stop();
+        case CommandProtocol::CMD_RELEASE:
+            traceCommand(currentTime, frame.cmd, 0);
+            gripperController.releaseDigital();
+            break;
+            
+        case CommandProtocol::CMD_QUERY: {
+            // Заданная и примененная скорость, ток (0.1 мА), напряжение (мВ), импульс (мкс), флаги,
+            // положение губок (промилле хода, 0xFFFF - неизвестно)
+            float current_mA, voltage_V, power_mW;
+            currentSensor.getAllMeasurements(current_mA, voltage_V, power_mW);
+            length += putUint16(response + length, gripperController.getCommandedSpeed());
+            length += putUint16(response + length, gripperMotor.getSpeed());
+            length += putUint16(response + length, static_cast<int16_t>(constrain(current_mA * 10.0f, -32768.0f, 32767.0f)));
+            length += putUint16(response + length, static_cast<uint16_t>(constrain(voltage_V * 1000.0f, 0.0f, 65535.0f)));
+            length += putUint16(response + length, static_cast<uint16_t>(min(pulseMeter.getPulseWidth(), static_cast<uint32_t>(0xFFFF))));
+            response[length++] = controllerStateFlags();
+            if (ENCODER_ENABLED) {
+                length += putUint16(response + length, positionController.isHomed() ?
+                                    positionController.getPositionPermille() : 0xFFFF);
+            } else {
+                length += putUint16(response + length, (RIPPLE_COUNTING_ENABLED && jawPosition.isHomed()) ?
+                                    jawPosition.getPositionPermille() : 0xFFFF);
             }
+            break;
         }
-    } else {
-        // Двигатель остановлен
-        motor_was_running = false;
-        motor_startup_delay_active = false;
+        
+        case CommandProtocol::CMD_QUERY_ENERGY: {
+            if (frame.length != 1) {
+                status = CommandProtocol::STATUS_BAD_LENGTH;
+                break;
+            }
+            if (frame.payload[0] == 0) {
+                // Итоги: заряд (мкА*ч), энергия (мкВт*ч), время в защите (мс), макс. интервал (мс)
+                length += putUint32(response + length, static_cast<uint32_t>(energyMeter.getCharge_nC() / 3600000));
+                length += putUint32(response + length, static_cast<uint32_t>(energyMeter.getEnergy_nJ() / 3600000));
+                length += putUint32(response + length, energyMeter.getProtectionTime_ms());
+                length += putUint16(response + length, min(energyMeter.getMaxInterval_ms(), static_cast<uint32_t>(0xFFFF)));
+            } else if (frame.payload[0] <= EnergyMeter::DIRECTION_COUNT) {
+                // Движения: количество, срабатывания защиты, последнее (мс, 0.1 мА, нВт*ч),
+                // суммарная энергия (мкВт*ч), суммарная длительность (мс), время в защите (мс)
+                const EnergyMeter::ActuationStats& stats =
+                    energyMeter.getStats(static_cast<EnergyMeter::Direction>(frame.payload[0] - 1));
+                length += putUint16(response + length, min(stats.count, static_cast<uint32_t>(0xFFFF)));
+                length += putUint16(response + length, min(stats.trips, static_cast<uint32_t>(0xFFFF)));
+                length += putUint32(response + length, stats.last_duration_ms);
+                length += putUint16(response + length, static_cast<int16_t>(constrain(stats.last_peak_uA / 100, -32768L, 32767L)));
+                length += putUint32(response + length, static_cast<uint32_t>(stats.last_energy_nJ / 3600));
+                length += putUint32(response + length, static_cast<uint32_t>(stats.total_energy_nJ / 3600000));
+                length += putUint32(response + length, stats.total_duration_ms);
+                length += putUint32(response + length, stats.protection_ms);
+            } else {
+                status = CommandProtocol::STATUS_BAD_VALUE;
+            }
+            break;
+        }
+        
+        default:
+            status = CommandProtocol::STATUS_UNKNOWN_COMMAND;
+            break;
     }
+    
+    commandProtocol.sendResponse(frame.seq, frame.cmd, status, response, length);
 }
 
-// Функция обработки PWM сигнала
-void processPWMControl() {
-    uint32_t current_pulse_width = pulseMeter.getPulseWidthAndClear();
-    
+// Команда "cal": смещение нуля тока и качество калибровки ("cal restart" - калибровать заново)
+void commandCalibration(uint8_t argc, char* argv[]) {
+    IdleCalibrator& calibrator = currentSensor.getIdleCalibrator();
+    if (argc > 1 && strcmp(argv[1], "restart") == 0) {
+        calibrator.restart();
+        Serial.println("Idle calibration restarted");
+        return;
+    }
     
-    int16_t new_speed = MOTOR_SPEED_STOP;
+    Serial.print(calibrator.getState() == IdleCalibrator::STATE_TRACKING ? "Cal: TRACKING" : "Cal: CALIBRATING");
+    Serial.print(" offset="); Serial.print(calibrator.getOffset_mA(), 3);
+    Serial.print("mA sigma="); Serial.print(sqrtf(calibrator.getVariance()), 3);
+    Serial.print("mA samples="); Serial.print(calibrator.getCalibrationSamples());
+    Serial.print("/"); Serial.print(IDLE_CURRENT_SAMPLES);
+    Serial.print(" drift="); Serial.print(calibrator.getDriftSamples());
+    Serial.print(" rejected="); Serial.println(calibrator.getRejectedSamples());
+}
+
+// Команда "energy": заряд, энергия и статистика движений ("energy reset" - сброс)
+void commandEnergy(uint8_t argc, char* argv[]) {
+    if (argc > 1 && strcmp(argv[1], "reset") == 0) {
+        energyMeter.reset();
+        Serial.println("Energy counters reset");
+        return;
+    }
+    energyMeter.printReport();
+}
+
+// Команда "jaw": оценка положения губок ("jaw home open|closed" - задать положение вручную)
+void commandJaw(uint8_t argc, char* argv[]) {
+    if (argc > 2 && strcmp(argv[1], "home") == 0) {
+        jawPosition.home(strcmp(argv[2], "closed") == 0);
+    }
+    jawPosition.printReport();
+}
+
+// Команда "pos": энкодер и регулятор положения ("pos home open|closed" - задать ноль вручную)
+void commandPosition(uint8_t argc, char* argv[]) {
+    if (!ENCODER_ENABLED) {
+        Serial.println("Encoder disabled (ENCODER_ENABLED)");
+        return;
+    }
+    if (argc > 2 && strcmp(argv[1], "home") == 0) {
+        positionController.home(strcmp(argv[2], "closed") == 0);
+    }
+    positionController.printReport();
+}
+
+// Регулятор положения по энкодеру с собственным периодом, не связанным с кадром RC
+void runPositionLoop() {
+    static uint32_t last_loop_us = 0;
+    uint32_t now_us = micros();
+    uint32_t interval_us = now_us - last_loop_us;
+    if (interval_us < POSITION_LOOP_INTERVAL_US) {
+        return;
+    }
+    last_loop_us = now_us;
+    gripperController.updatePositionControl(jawEncoder.read(), interval_us);
+}
+
+// Команда "power": сон между тактами и глубокий простой ("power reset" - сброс статистики)
+void commandPower(uint8_t argc, char* argv[]) {
+    if (argc > 1 && strcmp(argv[1], "reset") == 0) {
+        powerManager.reset();
+        Serial.println("Power stats reset");
+        return;
+    }
+    powerManager.printReport();
+}
+
+static uint32_t lastPulseWidth = PWM_NEUTRAL_US; // Последний обработанный импульс
+
+// Требует ли новый импульс движения (для выхода из глубокого простоя без ожидания такта)
+bool pulseRequestsMotion() {
+    if (!pulseMeter.isNewPulseAvailable()) {
+        return false;
+    }
+    uint32_t pulse_width = pulseMeter.getPulseWidth();
+    if (pulse_width < PWM_MIN_US || pulse_width > PWM_MAX_US) {
+        return false;
+    }
+    if (POSITION_CONTROL_RC && ENCODER_ENABLED && positionController.isHomed()) {
+        uint32_t change = (pulse_width > lastPulseWidth) ? pulse_width - lastPulseWidth : lastPulseWidth - pulse_width;
+        return change > IDLE_WAKE_PULSE_DELTA_US;
+    }
+    return pulse_width < runtimeConfig.pwm_deadzone_min_us || pulse_width > runtimeConfig.pwm_deadzone_max_us;
+}
+
+// Есть ли работа, ради которой надо проснуться до срока
+bool loopWorkPending() {
+    return Serial.available() > 0 ||
+           (powerManager.getMode() == PowerManager::MODE_DEEP_IDLE && pulseRequestsMotion());
+}
+
+// Заснуть до ближайшего запланированного события цикла
+void sleepUntilNextEvent(unsigned long currentTime) {
+    uint32_t deadline = lastUpdate + powerManager.getTickInterval_ms();
+    // В глубоком простое ток измеряется только на тактах
+    if (powerManager.getMode() == PowerManager::MODE_ACTIVE && currentSensor.isInitialized()) {
+        uint32_t measurement = currentSensor.getNextMeasurementTime();
+        if (static_cast<int32_t>(measurement - deadline) < 0) {
+            deadline = measurement;
+        }
+    }
+    // Конец окна агрегирующей подписки - вывод вовремя, а не на следующем такте
+    uint32_t window_end;
+    if (telemetry.getNextWindowEnd(currentTime, window_end) && static_cast<int32_t>(window_end - deadline) < 0) {
+        deadline = window_end;
+    }
+    // Плавный разгон, регулятор положения и канал "shunt" работают с шагом не больше 1 мс
+    if (gripperMotor.isSmoothTransitionActive() || (ENCODER_ENABLED && gripperController.isPositionTargetActive()) ||
+        telemetry.isActive(Telemetry::CH_SHUNT)) {
+        deadline = currentTime + 1;
+    }
+    powerManager.sleepUntil(deadline, loopWorkPending);
+}
+
+// Высокочастотное чтение шунта: счет пульсаций при работе двигателя и канал телеметрии "shunt"
+void sampleShunt(unsigned long currentTime) {
+    static uint32_t last_sample_us = 0;
+    bool ripple = RIPPLE_COUNTING_ENABLED && gripperMotor.getSpeed() != 0;
+    if (!ripple && !telemetry.isActive(Telemetry::CH_SHUNT)) {
+        return;
+    }
+    uint32_t now_us = micros();
+    if (now_us - last_sample_us < (ripple ? RIPPLE_SAMPLE_INTERVAL_US : TELEMETRY_SHUNT_INTERVAL_US)) {
+        return;
+    }
+    last_sample_us = now_us;
     
-    if (current_pulse_width >= PWM_MIN_US && current_pulse_width <= PWM_MAX_US) {
-        if (current_pulse_width < PWM_DEADZONE_MIN_US) {
-            new_speed = MOTOR_SPEED_REVERSE;
-        } else if (current_pulse_width > PWM_DEADZONE_MAX_US) {
-            new_speed = MOTOR_SPEED_FORWARD;
+    int16_t shunt_raw;
+    if (currentSensor.readShuntRaw(shunt_raw)) {
+        if (ripple) {
+            jawPosition.addSample(shunt_raw, now_us);
         }
-        
-        // Сброс защиты при движении в противоположном направлении
-        if (current_protection_active && new_speed != MOTOR_SPEED_STOP) {
-            if ((protection_direction > 0 && new_speed < 0) || 
-                (protection_direction < 0 && new_speed > 0)) {
-                current_protection_active = false;
+        // 10 мкВ на шунте 0.1 Ом (калибровка 32V_1A) = 0.1 мА
+        telemetry.publish(Telemetry::CH_SHUNT, shunt_raw, currentTime);
+    }
+}
+
+// Команда "link": статистика двоичного протокола
+void commandLink(uint8_t, char*[]) {
+    uint32_t ok, bad_crc, aborted;
+    commandProtocol.getStats(ok, bad_crc, aborted);
+    Serial.print("Link: frames="); Serial.print(ok);
+    Serial.print(" bad_crc="); Serial.print(bad_crc);
+    Serial.print(" aborted="); Serial.print(aborted);
+    Serial.println(gripperController.getSource() == GripperController::SOURCE_DIGITAL ? " source=DIGITAL" : " source=RC");
+}
+
+// Обработка входящих данных последовательного порта
+// Байт синхронизации 0xA5 начинает двоичный кадр, остальное - текстовые команды
+// Возвращает true, если были принятые данные
+bool processSerialInput() {
+    unsigned long currentTime = millis();
+    bool received = false;
+    while (Serial.available() > 0) {
+        received = true;
+        uint8_t data = static_cast<uint8_t>(Serial.read());
+        // Оборванный кадр сбрасывается до выбора получателя: первый символ следующей
+        // текстовой команды не должен уйти двоичному парсеру
+        commandProtocol.checkTimeout(currentTime);
+        if (commandProtocol.isReceiving() || data == CommandProtocol::SYNC) {
+            if (commandProtocol.processByte(data, currentTime)) {
+                handleBinaryFrame(currentTime);
             }
+        } else {
+            serialCommands.processChar(static_cast<char>(data));
         }
     }
-    
-    // Принудительная остановка при защите
-    if (current_protection_active) {
-        new_speed = MOTOR_SPEED_STOP;
+    return received;
+}
+
+// Команда "boot": время этапов загрузки и готовность оборудования
+void commandBoot(uint8_t, char*[]) {
+    bootTimeline.printReport();
+    Serial.print("Current sensor: "); Serial.print(currentSensor.isInitialized() ? "online" : "offline");
+    Serial.print(", probes "); Serial.println(currentSensor.getProbeAttempts());
+}
+
+// Команда "cfg": настройки во flash ("cfg set <имя> <значение>", "cfg save", "cfg defaults", "cfg erase")
+void commandConfig(uint8_t argc, char* argv[]) {
+    if (argc > 3 && strcmp(argv[1], "set") == 0) {
+        const RuntimeConfig::Field* field = RuntimeConfig::findField(argv[2]);
+        if (field == nullptr) {
+            Serial.print("Unknown field: "); Serial.println(argv[2]);
+            return;
+        }
+        RuntimeConfig candidate = runtimeConfig;
+        candidate.*field->member = static_cast<uint16_t>(constrain(atol(argv[3]), 0L, 65535L));
+        const char* error = candidate.validate();
+        if (error != nullptr) {
+            Serial.print("Rejected: "); Serial.println(error);
+            return;
+        }
+        runtimeConfig = candidate;
+        Serial.println("Applied (not saved, \"cfg save\" to keep)");
+        return;
     }
-    
-    // Применяем новую скорость
-    if (new_speed != motor_speed) {
-        motor_speed = new_speed;
-        gripperMotor.setSpeedSmooth(motor_speed);
-        
-        Serial.print("Motor: ");
-        if (motor_speed == MOTOR_SPEED_STOP) {
-            Serial.print("STOP");
-        } else if (motor_speed > MOTOR_SPEED_STOP) {
-            Serial.print("FORWARD");
+    if (argc > 1 && strcmp(argv[1], "defaults") == 0) {
+        runtimeConfig = RuntimeConfig::DEFAULTS;
+        Serial.println("Defaults applied (not saved)");
+        return;
+    }
+    if (argc > 1 && (strcmp(argv[1], "save") == 0 || strcmp(argv[1], "erase") == 0)) {
+        // Запись и стирание flash останавливают выполнение кода на время операции
+        if (gripperMotor.getSpeed() != 0) {
+            Serial.println("Stop the motor first");
+            return;
+        }
+        bool ok = (argv[1][0] == 's') ? configStore.save(runtimeConfig) : configStore.erase();
+        Serial.println(ok ? "OK" : "Flash write failed");
+        configStore.printReport();
+        return;
+    }
+    runtimeConfig.print();
+    configStore.printReport();
+}
+
+// Команда "mem": RAM, максимальная глубина стека и выделения памяти после setup
+void commandMemory(uint8_t, char*[]) {
+    MemoryMonitor::printReport();
+}
+
+// Команда "tm": каналы телеметрии и подписки
+// "tm sub <канал> [период мс] [first|agg]", "tm unsub <канал>|all"
+void commandTelemetry(uint8_t argc, char* argv[]) {
+    if (argc > 2 && strcmp(argv[1], "unsub") == 0) {
+        Telemetry::Channel channel;
+        if (strcmp(argv[2], "all") == 0) {
+            telemetry.unsubscribeAll();
+        } else if (Telemetry::findChannel(argv[2], channel)) {
+            telemetry.unsubscribe(channel);
         } else {
-            Serial.print("REVERSE");
+            Serial.print("Unknown channel: "); Serial.println(argv[2]);
+            return;
+        }
+    } else if (argc > 2 && strcmp(argv[1], "sub") == 0) {
+        Telemetry::Channel channel;
+        if (!Telemetry::findChannel(argv[2], channel)) {
+            Serial.print("Unknown channel: "); Serial.println(argv[2]);
+            return;
+        }
+        uint16_t period_ms = (argc > 3) ? static_cast<uint16_t>(constrain(atol(argv[3]), 0L, 60000L))
+                                        : runtimeConfig.telemetry_period_ms;
+        Telemetry::Mode mode = Telemetry::MODE_FIRST;
+        if (argc > 4) {
+            if (strcmp(argv[4], "agg") == 0) {
+                mode = Telemetry::MODE_AGGREGATE;
+            } else if (strcmp(argv[4], "first") != 0) {
+                Serial.print("Unknown mode: "); Serial.println(argv[4]);
+                return;
+            }
+        }
+        if (!telemetry.subscribe(channel, period_ms, mode, millis())) {
+            Serial.println("agg needs a period");
+            return;
         }
-        Serial.println(" (pulse: " + String(current_pulse_width) + "us)");
     }
+    telemetry.printList();
 }
 
 // Функция вывода диагностики
@@ -138,25 +628,37 @@ void printDiagnostics() {
     bool pin_state, waiting_for_rising, new_pulse_available;
     pulseMeter.getDiagnostics(pin_state, waiting_for_rising, new_pulse_available);
     
-    Serial.print("Pulse: " + String(current_width) + "us");
-    Serial.print(" (pin:" + String(pin_state ? "H" : "L"));
-    Serial.print(", wait:" + String(waiting_for_rising ? "R" : "F"));
-    Serial.print(", new:" + String(new_pulse_available ? "Y" : "N") + ") | ");
+    Serial.print("Pulse: "); Serial.print(current_width);
+    Serial.print("us (pin:"); Serial.print(pin_state ? "H" : "L");
+    Serial.print(", wait:"); Serial.print(waiting_for_rising ? "R" : "F");
+    Serial.print(", new:"); Serial.print(new_pulse_available ? "Y" : "N");
+    Serial.print(") | ");
     
     if (currentSensor.isInitialized()) {
-        Serial.print("I: " + String(current_mA, 2) + "mA | ");
-        Serial.print("V: " + String(voltage_V, 2) + "V | ");
-        Serial.print("P: " + String(power_mW, 1) + "mW");
+        Serial.print("I: "); Serial.print(current_mA, 2);
+        Serial.print("mA | V: "); Serial.print(voltage_V, 2);
+        Serial.print("V | P: "); Serial.print(power_mW, 1);
+        Serial.print("mW | Q: "); Serial.print(energyMeter.getCharge_mAh(), 3);
+        Serial.print("mAh E: "); Serial.print(energyMeter.getEnergy_mWh(), 3);
+        Serial.print("mWh");
     } else {
         Serial.print("Ток: недоступен");
     }
     
-    Serial.print(" | Motor: " + String(gripperMotor.getSpeed()));
+    Serial.print(" | Motor: "); Serial.print(gripperMotor.getSpeed());
+    
+    // Статистика времени: макс. джиттер такта, опоздавшие такты, макс. задержка ISR
+    uint32_t max_jitter_us, late_ticks, max_isr_latency_ns;
+    loopTiming.getSummary(max_jitter_us, late_ticks, max_isr_latency_ns);
+    Serial.print(" | Jit: "); Serial.print(max_jitter_us);
+    Serial.print("us/"); Serial.print(late_ticks);
+    Serial.print(" ISR: "); Serial.print(max_isr_latency_ns);
+    Serial.print("ns");
     
     // Индикация состояния
-    if (current_protection_active) {
+    if (gripperController.isProtectionActive()) {
         Serial.print(" [ЗАЩИТА]");
-    } else if (motor_startup_delay_active) {
+    } else if (gripperController.isStartupDelayActive()) {
         Serial.print(" [СТАРТ]");
     } else {
         Serial.print(" [OK]");
@@ -165,32 +667,241 @@ void printDiagnostics() {
     Serial.println();
 }
 
+// Команда "status": одна строка с импульсом, током, скоростью, временем цикла и состоянием
+void commandStatus(uint8_t, char*[]) {
+    printDiagnostics();
+}
+
+// Приветствие и отчет загрузки - когда хост открывает порт (вывод до этого теряется)
+void printBanner() {
+    Serial.println("=== ROV Gripper System ===");
+    Serial.println("Готов к работе...");
+    bootTimeline.printReport();
+    configStore.printReport();
+    if (!currentSensor.isInitialized()) {
+        Serial.println("Датчик тока не найден, поиск продолжается (защита по току отключена)");
+    }
+    Serial.println();
+}
+
+// Отследить подключение хоста к USB
+void checkHostAttached() {
+    static bool attached = false;
+    bool now_attached = static_cast<bool>(Serial);
+    if (now_attached && !attached) {
+        bootTimeline.mark(BootTimeline::PHASE_HOST_ATTACHED);
+        printBanner();
+    }
+    // Хост закрыл порт - телеметрию больше некому читать
+    if (!now_attached && attached) {
+        telemetry.unsubscribeAll();
+    }
+    attached = now_attached;
+}
+
+// Загрузка без ожидания USB и датчика тока: сначала безопасное состояние двигателя,
+// затем входы; датчик ищется один раз здесь и дальше в основном цикле
+void setup() {
+    bootTimeline.begin();
+    gripperMotor.begin();
+    bootTimeline.mark(BootTimeline::PHASE_MOTOR_SAFE);
+    
+    // Настройки из flash - один раз, до первого такта
+    configStore.load(runtimeConfig);
+    
+    Serial.begin(SERIAL_BAUD_RATE);
+    CycleCounter::begin();
+    loopTiming.begin();
+    pulseMeter.begin();
+    if (RIPPLE_COUNTING_ENABLED) {
+        gripperController.attachJawPosition(&jawPosition);
+    }
+    if (ENCODER_ENABLED) {
+        jawEncoder.begin();
+        gripperController.attachPositionControl(&positionController);
+    }
+    bootTimeline.mark(BootTimeline::PHASE_INPUTS);
+    
+    currentSensor.attachMotor(&gripperMotor);
+    if (currentSensor.begin()) {
+        bootTimeline.mark(BootTimeline::PHASE_SENSOR_ONLINE);
+    }
+    bootTimeline.mark(BootTimeline::PHASE_SENSOR_PROBE);
+    
+    serialCommands.addCommand("status", commandStatus, "импульс, ток, скорость, время цикла и состояние");
+    serialCommands.addCommand("tm", commandTelemetry, "каналы телеметрии [sub <канал> [период мс] [first|agg]|unsub <канал>|all]");
+    serialCommands.addCommand("cfg", commandConfig, "настройки во flash [set <имя> <значение>|save|defaults|erase]");
+    serialCommands.addCommand("boot", commandBoot, "время этапов загрузки и готовность датчика тока");
+    serialCommands.addCommand("mem", commandMemory, "RAM, глубина стека и выделения памяти после setup");
+    serialCommands.addCommand("timing", commandTiming, "статистика времени цикла и ISR [reset]");
+    serialCommands.addCommand("rec", commandRecorder, "бортовой самописец [dump|trig|arm]");
+    serialCommands.addCommand("bench", commandBench, "такты доступа к пинам: ядро Arduino и регистры");
+    serialCommands.addCommand("filter", commandFilter, "фильтры тока и групповая задержка [fast|slow <тип> <параметр>|hyst <мА>]");
+    serialCommands.addCommand("cal", commandCalibration, "смещение нуля тока и качество калибровки [restart]");
+    serialCommands.addCommand("energy", commandEnergy, "заряд, энергия и статистика движений [reset]");
+    serialCommands.addCommand("jaw", commandJaw, "положение губок по пульсациям тока [home open|closed]");
+    serialCommands.addCommand("pos", commandPosition, "энкодер и регулятор положения [home open|closed]");
+    serialCommands.addCommand("power", commandPower, "сон между тактами, глубокий простой и оценка тока МК [reset]");
+    serialCommands.addCommand("link", commandLink, "статистика двоичного протокола");
+    serialCommands.addCommand("trace", commandTrace, "трасса входных данных для воспроизведения [on|off]");
+    
+    powerManager.reset();
+    powerManager.noteActivity(millis());
+    
+    // Первый такт управления - на первом же проходе loop(), а не через период
+    lastUpdate = millis() - CONTROL_TICK_INTERVAL_MS;
+    bootTimeline.mark(BootTimeline::PHASE_SETUP_DONE);
+    
+    // Вся память выделена: дальше выделения учитываются как нарушения, свободная RAM окрашивается для замера стека
+    if (HEAP_FREE_BUILD) {
+        MemoryMonitor::lockHeap();
+    }
+    MemoryMonitor::paintStack();
+}
+
+// Опубликовать измерение INA219 в каналы телеметрии (преобразование - только при подписке)
+void publishSensorTelemetry(unsigned long currentTime) {
+    if (!telemetry.isActive(Telemetry::CH_CURRENT) && !telemetry.isActive(Telemetry::CH_VOLTAGE) &&
+        !telemetry.isActive(Telemetry::CH_POWER)) {
+        return;
+    }
+    float current_mA, voltage_V, power_mW;
+    currentSensor.getAllMeasurements(current_mA, voltage_V, power_mW);
+    telemetry.publish(Telemetry::CH_CURRENT, lroundf(current_mA * 100.0f), currentTime);
+    telemetry.publish(Telemetry::CH_VOLTAGE, lroundf(voltage_V * 1000.0f), currentTime);
+    telemetry.publish(Telemetry::CH_POWER, lroundf(power_mW * 10.0f), currentTime);
+}
+
+// Опубликовать состояние такта управления в каналы телеметрии
+void publishTickTelemetry(unsigned long currentTime) {
+    if (!telemetry.isAnyActive()) {
+        return;
+    }
+    telemetry.publish(Telemetry::CH_PULSE, pulseMeter.getPulseWidth(), currentTime);
+    telemetry.publish(Telemetry::CH_SPEED, gripperMotor.getSpeed(), currentTime);
+    telemetry.publish(Telemetry::CH_COMMANDED, gripperController.getCommandedSpeed(), currentTime);
+    telemetry.publish(Telemetry::CH_STATE, controllerStateFlags(), currentTime);
+    telemetry.publish(Telemetry::CH_JITTER, loopTiming.getLastJitter_us(), currentTime);
+    if (telemetry.isActive(Telemetry::CH_POSITION)) {
+        if (ENCODER_ENABLED && positionController.isHomed()) {
+            telemetry.publish(Telemetry::CH_POSITION, positionController.getPositionPermille(), currentTime);
+        } else if (!ENCODER_ENABLED && RIPPLE_COUNTING_ENABLED && jawPosition.isHomed()) {
+            telemetry.publish(Telemetry::CH_POSITION, jawPosition.getPositionPermille(), currentTime);
+        }
+    }
+}
+
+// Записать сэмпл состояния в бортовой самописец
+void recordFlightSample(unsigned long currentTime) {
+    float current_mA, voltage_V, power_mW;
+    currentSensor.getAllMeasurements(current_mA, voltage_V, power_mW);
+    current_mA = currentSensor.getCurrent_mA(); // Ток, по которому работает защита
+    
+    RecorderSample sample;
+    sample.pulse_us = static_cast<uint16_t>(min(pulseMeter.getPulseWidth(), static_cast<uint32_t>(0xFFFF)));
+    sample.current_dmA = static_cast<int16_t>(constrain(current_mA * 10.0f, -32768.0f, 32767.0f));
+    sample.voltage_mV = static_cast<uint16_t>(constrain(voltage_V * 1000.0f, 0.0f, 65535.0f));
+    sample.commanded_speed = gripperController.getCommandedSpeed();
+    sample.applied_speed = gripperMotor.getSpeed();
+    sample.state = controllerStateFlags();
+    
+    bool was_frozen = flightRecorder.isFrozen();
+    flightRecorder.record(sample, currentTime);
+    
+    // Окно события записано - выгрузить для анализа
+    if (FLIGHT_RECORDER_AUTO_DUMP && !was_frozen && flightRecorder.isFrozen()) {
+        flightRecorder.dump();
+    }
+}
+
 void loop() {
+    loopTiming.beginPass();
     unsigned long currentTime = millis();
     
+    // Обработка команд (любые принятые данные выводят из глубокого простоя)
+    checkHostAttached();
+    if (processSerialInput()) {
+        bootTimeline.mark(BootTimeline::PHASE_FIRST_COMMAND);
+        powerManager.noteActivity(currentTime);
+        powerManager.markAction();
+    }
+    
+    // Датчик тока, не ответивший при загрузке, ищется в фоне
+    if (currentSensor.retryInit(currentTime)) {
+        bootTimeline.mark(BootTimeline::PHASE_SENSOR_ONLINE);
+        Serial.println("Датчик тока найден");
+    }
+    
     // Обновить измерения
-    currentSensor.update();
+    if (currentSensor.update()) {
+        energyMeter.addSample(static_cast<int32_t>(lroundf(currentSensor.getCorrectedCurrent_mA() * 1000.0f)),
+                              static_cast<int32_t>(lroundf(currentSensor.getVoltage_V() * 1000.0f)), currentTime);
+        traceSensor(currentTime);
+        recordFlightSample(currentTime);
+        publishSensorTelemetry(currentTime);
+    }
     gripperMotor.update();
+    sampleShunt(currentTime);
+    if (ENCODER_ENABLED) {
+        runPositionLoop();
+    }
+    
+    // Импульс, требующий движения, выводит из глубокого простоя без ожидания такта
+    bool wakeTick = false;
+    if (powerManager.getMode() == PowerManager::MODE_DEEP_IDLE && pulseRequestsMotion()) {
+        powerManager.noteActivity(currentTime);
+        wakeTick = true;
+    }
     
-    // Основной цикл обновления каждые 20мс
-    if (currentTime - lastUpdate >= 20) {
-        checkCurrentProtection();
+    // Основной цикл обновления каждые CONTROL_TICK_INTERVAL_MS (IDLE_DEEP_TICK_MS в глубоком простое)
+    if (wakeTick || currentTime - lastUpdate >= powerManager.getTickInterval_ms()) {
+        bootTimeline.mark(BootTimeline::PHASE_FIRST_TICK);
+        loopTiming.markControlTick();
+        gripperController.checkDigitalTimeout(currentTime);
+        if (gripperController.checkCurrentProtection(currentTime)) {
+            flightRecorder.trigger(FlightRecorder::TRIGGER_PROTECTION, currentTime);
+        }
+        energyMeter.updateState(gripperMotor.getSpeed(), gripperController.isProtectionActive(), currentTime);
         
         // Обработка PWM сигнала
         if (pulseMeter.isNewPulseAvailable()) {
-            processPWMControl();
+            uint32_t pulse_width = pulseMeter.getPulseWidthAndClear();
+            tracePulse(currentTime, pulse_width);
+            gripperController.processPulse(pulse_width);
+            lastPulseWidth = pulse_width;
+            if (pulse_width >= PWM_MIN_US && pulse_width <= PWM_MAX_US) {
+                bootTimeline.mark(BootTimeline::PHASE_FIRST_COMMAND);
+            }
+        }
+        gripperController.updateJaw(currentTime);
+        if (wakeTick) {
+            powerManager.markAction();
         }
         
-        // Вывод данных каждые 100мс
-        static unsigned long lastPrint = 0;
-        if (currentTime - lastPrint >= DATA_PRINT_INTERVAL_MS) {
-            printDiagnostics();
-            lastPrint = currentTime;
+        // Движение продлевает активный режим, долгий простой замедляет такт
+        // (трасса для воспроизведения пишется только с номинальным тактом)
+        if (gripperMotor.getSpeed() != 0 || gripperController.getCommandedSpeed() != 0 || trace_enabled) {
+            powerManager.noteActivity(currentTime);
+        } else {
+            powerManager.update(currentTime);
         }
+        loopTiming.setNominalPeriod(powerManager.getTickInterval_ms());
+        
+        publishTickTelemetry(currentTime);
         
         lastUpdate = currentTime;
     }
     
-    // Небольшая задержка для стабильности
-    delay(1);
+    loopTiming.endPass();
+    telemetry.publish(Telemetry::CH_LOOP, loopTiming.getLastPassDuration_us(), currentTime);
+    telemetry.update(currentTime);
+    
+    // Сон до следующего события (без него при счете пульсаций и регулировании положения на ходу)
+    if ((!RIPPLE_COUNTING_ENABLED && !ENCODER_ENABLED) || gripperMotor.getSpeed() == 0) {
+        if (IDLE_SLEEP_ENABLED) {
+            sleepUntilNextEvent(currentTime);
+        } else {
+            delay(1);
+        }
+    }
 }
\ No newline at end of file
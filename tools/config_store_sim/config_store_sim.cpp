@@ -0,0 +1,260 @@
+// Проверка хранения настроек во flash при потере питания во время записи
+//
+// Неизмененный ConfigStore работает с моделью двух страниц flash STM32F1:
+// стертое полуслово = 0xFFFF, запись только в стертое полуслово, стирание -
+// целой страницей. Питание пропадает на каждой операции каждого сохранения
+// по очереди; операция, на которой пропало питание, либо успевает завершиться,
+// либо обрывается и оставляет часть битов:
+//   запись полуслова - часть нулей нового значения уже записана
+//   стирание страницы - часть полуслов стерта, часть битов остальных поднята в 1
+// После сбоя - "перезагрузка": новый ConfigStore загружает страницы.
+// Требования:
+//   - загружается ровно предыдущая или новая конфигурация, без значений по умолчанию
+//   - после сбоя следующее сохранение проходит и загружается
+// Дополнительно: стирания на сохранение (износ) и мусор в страницах.
+//
+// Сборка (из корня репозитория):
+//   g++ -O2 -std=gnu++17 -Itools/replay/shim -Isrc -o config_store_sim tools/config_store_sim/config_store_sim.cpp
+//       src/ConfigStore.cpp src/RuntimeConfig.cpp src/CommandProtocol.cpp
+// Использование:
+//   ./config_store_sim             - прогнать проверки (код 1 при ошибке)
+//   ./config_store_sim --seed 7    - другая последовательность оборванных битов
+//   ./config_store_sim --saves 300 - число сохранений с обрывом питания
+
+#include <Arduino.h>
+#include <random>
+#include <vector>
+#include "Config.h"
+#include "RuntimeConfig.h"
+#include "ConfigStore.h"
+
+namespace replay_clock {
+uint32_t now_ms = 0;
+}
+
+ReplaySerial Serial;
+
+// Модель flash: две страницы подряд, обрыв питания на заданной операции
+class SimulatedFlash : public FlashBackend {
+public:
+    static constexpr uint32_t BASE = CONFIG_FLASH_PAGE0_ADDRESS;
+    static constexpr uint32_t SIZE = 2 * CONFIG_FLASH_PAGE_SIZE;
+
+    std::vector<uint16_t> cells = std::vector<uint16_t>(SIZE / 2, 0xFFFF);
+    uint32_t operations = 0;        // Выполнено операций с включения
+    uint32_t cut_at = UINT32_MAX;   // Операция, на которой пропадает питание
+    bool powered = true;
+    bool torn = false;              // Последняя операция оборвана
+    uint32_t page_erases[2] = {0, 0};
+    uint32_t program_errors = 0;    // Запись в нестертое полуслово
+    std::mt19937* rng = nullptr;
+
+    void powerOn() {
+        powered = true;
+        torn = false;
+        operations = 0;
+        cut_at = UINT32_MAX;
+    }
+
+    bool erasePage(uint32_t address) override {
+        if (!begin()) return false;
+        uint32_t page = (address - BASE) / CONFIG_FLASH_PAGE_SIZE;
+        uint32_t first = page * CONFIG_FLASH_PAGE_SIZE / 2;
+        for (uint32_t i = first; i < first + CONFIG_FLASH_PAGE_SIZE / 2; i++) {
+            if (!torn || (*rng)() % 2) {
+                cells[i] = 0xFFFF;
+            } else {
+                cells[i] |= static_cast<uint16_t>((*rng)());
+            }
+        }
+        if (!torn) {
+            page_erases[page]++;
+        }
+        return powered;
+    }
+
+    bool programHalfWord(uint32_t address, uint16_t value) override {
+        if (!begin()) return false;
+        uint16_t& cell = cells[(address - BASE) / 2];
+        if (cell != 0xFFFF) {
+            program_errors++;
+            return false;
+        }
+        // Оборванная запись: часть нулей нового значения
+        cell = torn ? static_cast<uint16_t>(value | static_cast<uint16_t>((*rng)())) : value;
+        return powered;
+    }
+
+    uint16_t readHalfWord(uint32_t address) const override {
+        return cells[(address - BASE) / 2];
+    }
+
+private:
+    // Учесть операцию; false если питания уже нет
+    bool begin() {
+        if (!powered) return false;
+        if (++operations == cut_at) {
+            powered = false;   // Следующие операции не выполняются
+            torn = (*rng)() % 2 != 0;
+        }
+        return true;
+    }
+};
+
+// Уникальная допустимая конфигурация для номера сохранения
+RuntimeConfig makeConfig(uint32_t n) {
+    RuntimeConfig config = RuntimeConfig::DEFAULTS;
+    config.protection_threshold_mA = static_cast<uint16_t>(GRIP_CURRENT_MIN_MA + n % (GRIP_CURRENT_MAX_MA - GRIP_CURRENT_MIN_MA));
+    config.motor_start_delay_ms = static_cast<uint16_t>(n % 10000);
+    config.telemetry_period_ms = static_cast<uint16_t>(CONTROL_TICK_INTERVAL_MS + n / 7 % 1000);
+    return config;
+}
+
+bool sameConfig(const RuntimeConfig& a, const RuntimeConfig& b) {
+    return memcmp(&a, &b, sizeof(RuntimeConfig)) == 0;
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t seed = 1;
+    uint32_t save_count = 200;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = static_cast<uint32_t>(atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--saves") == 0 && i + 1 < argc) {
+            save_count = static_cast<uint32_t>(atoi(argv[++i]));
+        } else {
+            fprintf(stderr, "Usage: %s [--seed N] [--saves N]\n", argv[0]);
+            return 2;
+        }
+    }
+    std::mt19937 rng(seed);
+    bool failed = false;
+
+    // 1. Чистая flash - значения по умолчанию
+    SimulatedFlash flash;
+    flash.rng = &rng;
+    {
+        ConfigStore store(flash, CONFIG_FLASH_PAGE0_ADDRESS, CONFIG_FLASH_PAGE1_ADDRESS);
+        RuntimeConfig config = makeConfig(12345);
+        bool ok = store.load(config) == ConfigStore::LOAD_EMPTY && sameConfig(config, RuntimeConfig::DEFAULTS);
+        printf("empty flash: %s\n", ok ? "defaults" : "FAIL");
+        failed = failed || !ok;
+    }
+
+    // 2. Обрыв питания на каждой операции каждого сохранения
+    uint32_t cuts = 0, loaded_old = 0, loaded_new = 0, bad = 0;
+    RuntimeConfig committed = RuntimeConfig::DEFAULTS;
+    bool have_committed = false;
+    for (uint32_t n = 0; n < save_count; n++) {
+        RuntimeConfig next = makeConfig(n);
+
+        // Число операций сохранения без сбоя - на копии
+        SimulatedFlash probe = flash;
+        {
+            ConfigStore store(probe, CONFIG_FLASH_PAGE0_ADDRESS, CONFIG_FLASH_PAGE1_ADDRESS);
+            RuntimeConfig loaded;
+            store.load(loaded);
+            probe.operations = 0;
+            store.save(next);
+        }
+        uint32_t save_operations = probe.operations;
+
+        for (uint32_t cut = 1; cut <= save_operations; cut++) {
+            SimulatedFlash trial = flash;
+            trial.rng = &rng;
+            RuntimeConfig loaded;
+            {
+                ConfigStore store(trial, CONFIG_FLASH_PAGE0_ADDRESS, CONFIG_FLASH_PAGE1_ADDRESS);
+                store.load(loaded);
+                trial.operations = 0;
+                trial.cut_at = cut;
+                store.save(next);
+            }
+            cuts++;
+
+            // Перезагрузка
+            trial.powerOn();
+            ConfigStore store(trial, CONFIG_FLASH_PAGE0_ADDRESS, CONFIG_FLASH_PAGE1_ADDRESS);
+            ConfigStore::LoadResult result = store.load(loaded);
+            bool is_new = result == ConfigStore::LOAD_OK && sameConfig(loaded, next);
+            bool is_old = have_committed ? (result == ConfigStore::LOAD_OK && sameConfig(loaded, committed))
+                                         : (result == ConfigStore::LOAD_EMPTY && sameConfig(loaded, RuntimeConfig::DEFAULTS));
+            loaded_new += is_new;
+            loaded_old += is_old;
+
+            // Следующее сохранение после сбоя
+            RuntimeConfig after = makeConfig(n + 100000);
+            RuntimeConfig reloaded;
+            bool resumed = store.save(after);
+            ConfigStore reboot(trial, CONFIG_FLASH_PAGE0_ADDRESS, CONFIG_FLASH_PAGE1_ADDRESS);
+            resumed = resumed && reboot.load(reloaded) == ConfigStore::LOAD_OK && sameConfig(reloaded, after);
+
+            if ((!is_new && !is_old) || !resumed) {
+                bad++;
+                if (bad <= 5) {
+                    printf("save %u cut at operation %u/%u: %s%s\n", n, cut, save_operations,
+                           (!is_new && !is_old) ? "loaded neither old nor new" : "",
+                           resumed ? "" : " next save not loaded");
+                }
+            }
+        }
+
+        // Сохранение без сбоя - основа следующего шага
+        {
+            ConfigStore store(flash, CONFIG_FLASH_PAGE0_ADDRESS, CONFIG_FLASH_PAGE1_ADDRESS);
+            RuntimeConfig loaded;
+            store.load(loaded);
+            if (!store.save(next)) {
+                printf("save %u failed without power loss\n", n);
+                failed = true;
+            }
+        }
+        committed = next;
+        have_committed = true;
+    }
+    printf("power loss: %u saves, %u cuts, loaded old %u, new %u, bad %u, program errors %u\n",
+           save_count, cuts, loaded_old, loaded_new, bad, flash.program_errors);
+    failed = failed || bad != 0 || flash.program_errors != 0;
+
+    // 3. Износ: стирания на сохранение при длинной серии
+    SimulatedFlash wear;
+    wear.rng = &rng;
+    {
+        ConfigStore store(wear, CONFIG_FLASH_PAGE0_ADDRESS, CONFIG_FLASH_PAGE1_ADDRESS);
+        RuntimeConfig loaded;
+        store.load(loaded);
+        const uint32_t wear_saves = 10000;
+        for (uint32_t n = 0; n < wear_saves; n++) {
+            store.save(makeConfig(n));
+        }
+        ConfigStore reboot(wear, CONFIG_FLASH_PAGE0_ADDRESS, CONFIG_FLASH_PAGE1_ADDRESS);
+        bool ok = reboot.load(loaded) == ConfigStore::LOAD_OK && sameConfig(loaded, makeConfig(wear_saves - 1)) &&
+                  reboot.getSequence() == wear_saves;
+        uint32_t erases = wear.page_erases[0] + wear.page_erases[1];
+        printf("wear: %u saves, page erases %u + %u (%.1f saves per erase)%s\n", wear_saves,
+               wear.page_erases[0], wear.page_erases[1], static_cast<double>(wear_saves) / erases, ok ? "" : "  FAIL");
+        failed = failed || !ok || erases > wear_saves / (ConfigStore::SLOTS_PER_PAGE - 1);
+    }
+
+    // 4. Мусор в страницах (не стертая после другой прошивки область)
+    SimulatedFlash garbage;
+    garbage.rng = &rng;
+    for (uint16_t& cell : garbage.cells) {
+        cell = static_cast<uint16_t>(rng());
+    }
+    {
+        ConfigStore store(garbage, CONFIG_FLASH_PAGE0_ADDRESS, CONFIG_FLASH_PAGE1_ADDRESS);
+        RuntimeConfig loaded;
+        ConfigStore::LoadResult result = store.load(loaded);
+        bool defaults = result != ConfigStore::LOAD_OK && sameConfig(loaded, RuntimeConfig::DEFAULTS);
+        RuntimeConfig saved = makeConfig(7);
+        bool ok = defaults && store.save(saved);
+        ConfigStore reboot(garbage, CONFIG_FLASH_PAGE0_ADDRESS, CONFIG_FLASH_PAGE1_ADDRESS);
+        ok = ok && reboot.load(loaded) == ConfigStore::LOAD_OK && sameConfig(loaded, saved);
+        printf("garbage pages: %s\n", ok ? "defaults, then saved and loaded" : "FAIL");
+        failed = failed || !ok;
+    }
+
+    printf(failed ? "FAIL\n" : "OK\n");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+"""Декодер выгрузки бортового самописца (команда "rec dump").
+
+Читает строки "REC ..." из файла лога или stdin и печатает CSV:
+time_ms,pulse_us,current_mA,voltage_V,commanded,applied,state
+
+Формат блока описан в src/FlightRecorder.h.
+"""
+import sys
+
+FIELDS = ("pulse_us", "current_dmA", "voltage_mV", "commanded", "applied", "state")
+SIGNED = {"current_dmA", "commanded", "applied"}
+MASK_TIME_DELTA = 0x80
+HEADER_SIZE = 8
+
+
+def read_varint(data, pos):
+    value = 0
+    shift = 0
+    for i in range(3):
+        byte = data[pos]
+        pos += 1
+        if i < 2 and byte & 0x80:
+            value |= (byte & 0x7F) << shift
+            shift += 7
+        else:
+            value |= byte << shift
+            break
+    return value, pos
+
+
+def unzigzag(value):
+    return (value >> 1) ^ -(value & 1)
+
+
+def to_field(name, value):
+    value &= 0xFFFF if name != "state" else 0xFF
+    if name in SIGNED and value >= 0x8000:
+        value -= 0x10000
+    return value
+
+
+def decode_block(data):
+    used = data[2]
+    count = data[3]
+    time_ms = int.from_bytes(data[4:8], "little")
+    last = dict.fromkeys(FIELDS, 0)
+    delta_ms = 0
+    pos = HEADER_SIZE
+    for _ in range(count):
+        if pos >= used:
+            raise ValueError("block truncated")
+        mask = data[pos]
+        pos += 1
+        if mask & MASK_TIME_DELTA:
+            delta_ms, pos = read_varint(data, pos)
+        time_ms += delta_ms
+        for bit, name in enumerate(FIELDS):
+            if mask & (1 << bit):
+                value, pos = read_varint(data, pos)
+                last[name] = to_field(name, last[name] + unzigzag(value))
+        yield time_ms, dict(last)
+
+
+def main():
+    source = open(sys.argv[1]) if len(sys.argv) > 1 else sys.stdin
+    print("time_ms,pulse_us,current_mA,voltage_V,commanded,applied,state")
+    for line in source:
+        line = line.strip()
+        if line.startswith("REC BEGIN") or line == "REC END":
+            print("# " + line, file=sys.stderr)
+            continue
+        if not line.startswith("REC "):
+            continue
+        for time_ms, s in decode_block(bytes.fromhex(line[4:])):
+            print("%d,%d,%.1f,%.3f,%d,%d,0x%02X" % (
+                time_ms, s["pulse_us"], s["current_dmA"] / 10.0, s["voltage_mV"] / 1000.0,
+                s["commanded"], s["applied"], s["state"]))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,124 @@
+// Проверка точности счетчика заряда и энергии
+//
+// EnergyMeter::addSample получает сэмплы напрямую, без CurrentSensor (его интервал
+// измерения отбросил бы частые сэмплы), с псевдослучайными интервалами от 1 до
+// MAX_INTERVAL_MS. Ток и напряжение заданы формулами, поэтому заряд и энергия
+// известны аналитически:
+//   1. постоянный ток и напряжение              - трапеции точны
+//   2. ток растет линейно, напряжение постоянно - трапеции точны
+//   3. ток растет, напряжение падает линейно    - мощность квадратична, ошибка трапеций
+//      на интервале h равна |P''| * h^3 / 12 (P'' = 2 * наклон тока * наклон напряжения)
+// Допуск - сумма ошибки трапеций и округления сэмплов до целых мкА, мВ и мкВт.
+//
+// Сборка (из корня репозитория):
+//   g++ -O2 -std=gnu++17 -Itools/replay/shim -Isrc -o energy_sim tools/energy_sim/energy_sim.cpp src/EnergyMeter.cpp
+// Использование:
+//   ./energy_sim                  - прогнать проверки (код 1 при превышении допуска)
+//   ./energy_sim --seed 7         - другая последовательность интервалов
+
+#include <Arduino.h>
+#include <random>
+#include "Config.h"
+#include "EnergyMeter.h"
+
+namespace replay_clock {
+uint32_t now_ms = 0;
+}
+
+ReplaySerial Serial;
+
+static constexpr uint32_t DURATION_MS = 3600UL * 1000UL;   // Час работы
+static constexpr uint32_t MAX_INTERVAL_MS = 200;
+
+// Ток (мкА) и напряжение (мВ) как линейные функции времени (мс)
+struct Profile {
+    const char* name;
+    double current_uA;         // Ток в момент 0
+    double current_slope;      // мкА/мс
+    double voltage_mV;         // Напряжение в момент 0
+    double voltage_slope;      // мВ/мс
+};
+
+/**
+ * Прогнать профиль и сравнить с аналитическим результатом
+ * @param profile - профиль тока и напряжения
+ * @param seed - зерно последовательности интервалов
+ * @return true если ошибки в пределах допуска
+ */
+static bool runProfile(const Profile& profile, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<uint32_t> interval(1, MAX_INTERVAL_MS);
+    EnergyMeter meter;
+
+    // Допуск: ошибка трапеций по фактическим интервалам и округление каждого сэмпла
+    // (ток и мощность - до целых, напряжение - до целых мВ: +-0.5 мВ * ток)
+    double curvature = 2.0 * profile.current_slope * profile.voltage_slope / 1000.0;   // P'', мкВт/мс^2
+    double trapezoid_bound_nJ = 0.0;
+    double max_current_uA = 0.0;
+    uint32_t time_ms = 0;
+    uint32_t samples = 0;
+    while (true) {
+        double current = profile.current_uA + profile.current_slope * time_ms;
+        double voltage = profile.voltage_mV + profile.voltage_slope * time_ms;
+        meter.addSample(static_cast<int32_t>(lround(current)), static_cast<int32_t>(lround(voltage)), time_ms);
+        max_current_uA = max(max_current_uA, fabs(current));
+        samples++;
+        if (time_ms >= DURATION_MS) {
+            break;
+        }
+        uint32_t h = min(interval(rng), DURATION_MS - time_ms);
+        trapezoid_bound_nJ += fabs(curvature) * h * h * h / 12.0;
+        time_ms += h;
+    }
+
+    // Аналитические интегралы на [0, T]
+    double t = DURATION_MS;
+    double i0 = profile.current_uA, i1 = profile.current_slope;
+    double v0 = profile.voltage_mV, v1 = profile.voltage_slope;
+    double expected_charge_nC = i0 * t + i1 * t * t / 2.0;
+    double expected_energy_nJ = (i0 * v0 * t + (i0 * v1 + i1 * v0) * t * t / 2.0 + i1 * v1 * t * t * t / 3.0) / 1000.0;
+
+    double charge_bound_nC = 0.5 * t + 1.0;
+    double energy_bound_nJ = trapezoid_bound_nJ +
+                             (1.0 + 0.5 * max(fabs(v0), fabs(v0 + v1 * t)) / 1000.0 + 0.5 * max_current_uA / 1000.0) * t + 1.0;
+
+    double charge_error = meter.getCharge_nC() - expected_charge_nC;
+    double energy_error = meter.getEnergy_nJ() - expected_energy_nJ;
+    bool ok = fabs(charge_error) <= charge_bound_nC && fabs(energy_error) <= energy_bound_nJ;
+    printf("%-30s %7u %11.4f %+9.2f %9.2f %11.4f %+9.2f %9.2f  %s\n", profile.name, samples,
+           meter.getCharge_mAh(), charge_error / expected_charge_nC * 1e6, charge_bound_nC / expected_charge_nC * 1e6,
+           meter.getEnergy_mWh(), energy_error / expected_energy_nJ * 1e6, energy_bound_nJ / expected_energy_nJ * 1e6,
+           ok ? "ok" : "FAIL");
+    return ok;
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t seed = 33;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoul(argv[++i], nullptr, 10);
+        } else {
+            fprintf(stderr, "Usage: %s [--seed N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    // За час: ток 20 -> 500 мА, напряжение 12.6 -> 11.1 В (разряд батареи)
+    const double t = DURATION_MS;
+    const Profile profiles[] = {
+        {"constant 250 mA, 12 V",         250000.0, 0.0,                      12000.0, 0.0},
+        {"ramp 20..500 mA, 12 V",         20000.0,  (500000.0 - 20000.0) / t, 12000.0, 0.0},
+        {"ramp 20..500 mA, 12.6..11.1 V", 20000.0,  (500000.0 - 20000.0) / t, 12600.0, (11100.0 - 12600.0) / t},
+    };
+
+    printf("Intervals 1..%u ms, %u s (errors and limits in ppm of the analytic value):\n",
+           MAX_INTERVAL_MS, DURATION_MS / 1000);
+    printf("%-30s %7s %11s %9s %9s %11s %9s %9s\n", "profile", "samples", "charge, mAh", "error", "limit",
+           "energy, mWh", "error", "limit");
+    bool failed = false;
+    for (const Profile& profile : profiles) {
+        failed = !runProfile(profile, seed) || failed;
+    }
+    printf("%s\n", failed ? "FAIL" : "OK");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,130 @@
+// Проверка групповой задержки фильтров тока
+//
+// Каждая поддерживаемая настройка CurrentFilter получает линейно растущий ток.
+// После переходного процесса выход фильтра с единичным усилением на нуле
+// отстает от входа ровно на групповую задержку на нулевой частоте:
+//   задержка = (вход - выход) / наклон
+// Измеренная задержка сравнивается с getGroupDelaySamples() (ее выводит команда
+// "filter" и replay), а для скользящего среднего и IIR - еще и с формулой из
+// CurrentFilter.h. Настройки: без фильтра, скользящее среднее на 1..MAX_TAPS точек
+// (и запрос сверх MAX_TAPS), IIR во всем диапазоне a, биквад от нижней до верхней
+// границы частоты среза при интервале измерения CURRENT_MEASUREMENT_INTERVAL.
+// Отдельно - скачок IIR через всю шкалу входа (-8 -> +8 А) без переполнения.
+//
+// Сборка (из корня репозитория):
+//   g++ -O2 -std=gnu++17 -Itools/replay/shim -Isrc -o filter_sim tools/filter_sim/filter_sim.cpp
+//       src/CurrentFilter.cpp
+// Использование:
+//   ./filter_sim                  - вывести задержки и проверить (код 1 при ошибке)
+
+#include <Arduino.h>
+#include "Config.h"
+#include "CurrentFilter.h"
+
+namespace replay_clock {
+uint32_t now_ms = 0;
+}
+
+ReplaySerial Serial;
+
+// Ход тока: от -7.5 до +7.5 А по 500 мкА на сэмпл (в пределах входа фильтра +-8 А)
+static constexpr int32_t RAMP_START_UA = -7500000;
+static constexpr int32_t RAMP_SLOPE_UA = 500;
+static constexpr uint32_t RAMP_SAMPLES = 30000;
+static constexpr uint32_t AVERAGED_SAMPLES = 1000;    // Последние сэмплы, по которым усредняется отставание
+
+// Допуск: квантование выхода до 1 мкА и округления состояния в фиксированной точке
+static constexpr float TOLERANCE_SAMPLES = 0.05f;
+static constexpr float TOLERANCE_RELATIVE = 0.005f;
+
+/**
+ * Измерить групповую задержку по отставанию от линейно растущего входа
+ * @param filter - настроенный фильтр (сбрасывается)
+ * @return задержка в сэмплах
+ */
+static float measureDelay(CurrentFilter& filter) {
+    filter.reset();
+    double lag_sum = 0.0;
+    for (uint32_t n = 0; n < RAMP_SAMPLES; n++) {
+        int32_t input = RAMP_START_UA + static_cast<int32_t>(n) * RAMP_SLOPE_UA;
+        int32_t output = filter.update(input);
+        if (n >= RAMP_SAMPLES - AVERAGED_SAMPLES) {
+            lag_sum += static_cast<double>(input - output) / RAMP_SLOPE_UA;
+        }
+    }
+    return static_cast<float>(lag_sum / AVERAGED_SAMPLES);
+}
+
+static bool failed = false;
+
+/**
+ * Проверить настройку и вывести строку таблицы
+ * @param name - описание настройки
+ * @param filter - настроенный фильтр
+ * @param expected - задержка по формуле (меньше 0 - не проверяется)
+ */
+static void check(const char* name, CurrentFilter& filter, float expected) {
+    float reported = filter.getGroupDelaySamples();
+    float measured = measureDelay(filter);
+    float tolerance = TOLERANCE_SAMPLES + TOLERANCE_RELATIVE * reported;
+    bool ok = fabsf(measured - reported) <= tolerance;
+    if (expected >= 0.0f) {
+        ok = ok && fabsf(reported - expected) <= tolerance;
+    }
+    printf("  %-18s %-7s %9.3f %9.3f %9.1f   %s\n", name, filter.getTypeName(), reported, measured,
+           reported * CURRENT_MEASUREMENT_INTERVAL, ok ? "ok" : "FAIL");
+    failed = failed || !ok;
+}
+
+int main() {
+    const float sample_rate_hz = 1000.0f / CURRENT_MEASUREMENT_INTERVAL;
+    char name[32];
+    CurrentFilter filter;
+
+    printf("Group delay at %u ms per sample (samples, samples, ms):\n", CURRENT_MEASUREMENT_INTERVAL);
+    printf("  %-18s %-7s %9s %9s %9s\n", "setting", "type", "reported", "measured", "ms");
+
+    filter.configureNone();
+    check("none", filter, 0.0f);
+
+    for (uint8_t taps = 1; taps <= CurrentFilter::MAX_TAPS; taps++) {
+        snprintf(name, sizeof(name), "ma %u", taps);
+        filter.configureMovingAverage(taps);
+        check(name, filter, (taps - 1) / 2.0f);
+    }
+    // Запрос сверх MAX_TAPS ограничивается, а не переполняется
+    snprintf(name, sizeof(name), "ma 255 (max %u)", CurrentFilter::MAX_TAPS);
+    filter.configureMovingAverage(255);
+    check(name, filter, (CurrentFilter::MAX_TAPS - 1) / 2.0f);
+
+    const float alphas[] = {0.001f, 0.01f, 0.05f, 0.1f, 0.2f, 0.5f, 1.0f};
+    for (float alpha : alphas) {
+        snprintf(name, sizeof(name), "iir %.3f", alpha);
+        filter.configureIIR(alpha);
+        // Коэффициент хранится в Q16: формула - для квантованного значения
+        float quantized = roundf(alpha * 65536.0f) / 65536.0f;
+        check(name, filter, (1.0f - quantized) / quantized);
+    }
+
+    // Скачок через всю шкалу входа: разность состояний Q8 выходит за int32
+    filter.configureIIR(0.5f);
+    filter.reset();
+    filter.update(-8000000);
+    int32_t step_output = filter.update(8000000);
+    bool step_ok = abs(step_output) <= 1;
+    printf("  %-18s %-7s %9d %9d %9s   %s\n", "iir 0.5 -8A -> +8A", filter.getTypeName(), 0,
+           static_cast<int>(step_output), "uA", step_ok ? "ok" : "FAIL");
+    failed = failed || !step_ok;
+
+    // От нижней (0.002 fs) до верхней (0.45 fs) границы частоты среза, включая настройку по умолчанию
+    const float cutoffs_hz[] = {sample_rate_hz * 0.002f, 0.1f, 0.5f, static_cast<float>(CURRENT_SLOW_FILTER_CUTOFF_HZ),
+                                2.0f, 5.0f, sample_rate_hz * 0.45f};
+    for (float cutoff_hz : cutoffs_hz) {
+        snprintf(name, sizeof(name), "biquad %.2f Hz", cutoff_hz);
+        filter.configureBiquad(cutoff_hz, sample_rate_hz);
+        check(name, filter, -1.0f);
+    }
+
+    printf("%s\n", failed ? "FAIL" : "OK");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,197 @@
+#!/usr/bin/env python3
+"""Хостовый клиент двоичного протокола захвата (src/CommandProtocol.h).
+
+Примеры:
+  gripper_client.py /dev/ttyACM0 query
+  gripper_client.py /dev/ttyACM0 speed 128 --hold 2
+  gripper_client.py /dev/ttyACM0 grip 15
+  gripper_client.py /dev/ttyACM0 stop
+  gripper_client.py /dev/ttyACM0 release
+  gripper_client.py /dev/ttyACM0 rtt --count 500
+  gripper_client.py /dev/ttyACM0 energy
+  gripper_client.py /dev/ttyACM0 position 500 --hold 3
+
+Пока удерживается цифровое управление (--hold), клиент посылает PING чаще
+таймаута связи COMMAND_HEARTBEAT_TIMEOUT_MS. Текстовый вывод прошивки,
+перемешанный с ответами, пропускается: кадр принимается только с верной CRC.
+
+Требуется pyserial.
+"""
+import argparse
+import statistics
+import struct
+import sys
+import time
+
+import serial
+
+SYNC = 0xA5
+RESPONSE_FLAG = 0x80
+(CMD_PING, CMD_SET_SPEED, CMD_SET_GRIP_CURRENT, CMD_STOP, CMD_QUERY, CMD_RELEASE, CMD_QUERY_ENERGY,
+ CMD_SET_POSITION) = range(1, 9)
+STATUS_NAMES = {0: "OK", 1: "BAD_LENGTH", 2: "BAD_VALUE", 3: "UNKNOWN_COMMAND", 4: "REJECTED"}
+STATE_FLAGS = ((0x01, "PROTECTION"), (0x02, "STARTUP"), (0x04, "RAMPING"),
+               (0x08, "SENSOR_OK"), (0x10, "DIGITAL"))
+HEARTBEAT_PERIOD_S = 0.1
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) & 0xFFFF if crc & 0x8000 else (crc << 1) & 0xFFFF
+    return crc
+
+
+def encode_frame(seq, cmd, payload=b""):
+    body = bytes([len(payload), seq & 0xFF, cmd]) + payload
+    return bytes([SYNC]) + body + struct.pack("<H", crc16(body))
+
+
+class FrameReader:
+    """Побайтовый поиск кадров в потоке с текстовым мусором."""
+
+    def __init__(self):
+        self.buffer = bytearray()
+
+    def feed(self, data):
+        self.buffer.extend(data)
+        frames = []
+        while True:
+            start = self.buffer.find(bytes([SYNC]))
+            if start < 0:
+                self.buffer.clear()
+                return frames
+            del self.buffer[:start]
+            if len(self.buffer) < 2:
+                return frames
+            length = self.buffer[1]
+            total = 4 + length + 2
+            if length > 32:
+                del self.buffer[:1]
+                continue
+            if len(self.buffer) < total:
+                return frames
+            body = bytes(self.buffer[1:4 + length])
+            (crc,) = struct.unpack("<H", self.buffer[4 + length:total])
+            if crc == crc16(body):
+                frames.append((body[1], body[2], body[3:]))
+                del self.buffer[:total]
+            else:
+                del self.buffer[:1]
+
+
+class GripperClient:
+    def __init__(self, port, timeout):
+        self.port = serial.Serial(port, 115200, timeout=0)
+        self.timeout = timeout
+        self.reader = FrameReader()
+        self.seq = 0
+
+    def request(self, cmd, payload=b""):
+        """Отправить команду и дождаться ответа; возвращает (статус, данные, RTT в с)."""
+        self.seq = (self.seq + 1) & 0xFF
+        frame = encode_frame(self.seq, cmd, payload)
+        start = time.perf_counter()
+        self.port.write(frame)
+        deadline = start + self.timeout
+        while time.perf_counter() < deadline:
+            data = self.port.read(256)
+            for seq, rcmd, body in self.reader.feed(data):
+                if seq == self.seq and rcmd == (cmd | RESPONSE_FLAG) and body:
+                    return body[0], body[1:], time.perf_counter() - start
+        raise TimeoutError("no response to command 0x%02X seq %d" % (cmd, self.seq))
+
+    def hold(self, seconds):
+        """Поддерживать цифровое управление пульсами связи."""
+        end = time.monotonic() + seconds
+        while time.monotonic() < end:
+            self.request(CMD_PING)
+            time.sleep(HEARTBEAT_PERIOD_S)
+
+
+def print_query(data):
+    cmd, applied, current_dma, voltage_mv, pulse_us, flags = struct.unpack("<hhhHHB", data[:11])
+    names = [name for bit, name in STATE_FLAGS if flags & bit] or ["-"]
+    position = "-"
+    if len(data) >= 13:
+        (permille,) = struct.unpack("<H", data[11:13])
+        position = "%.1f%%" % (permille / 10.0) if permille != 0xFFFF else "unknown"
+    print("speed=%d applied=%d current=%.1fmA voltage=%.3fV pulse=%dus flags=%s position=%s" % (
+        cmd, applied, current_dma / 10.0, voltage_mv / 1000.0, pulse_us, ",".join(names), position))
+
+
+def print_energy(client):
+    status, data, _ = client.request(CMD_QUERY_ENERGY, bytes([0]))
+    if status != 0:
+        print("energy: %s" % STATUS_NAMES.get(status, status))
+        return status
+    charge_uah, energy_uwh, protection_ms, max_interval_ms = struct.unpack("<IIIH", data[:14])
+    print("total: %.3f mAh %.3f mWh, protection %.1f s, max sample interval %d ms" % (
+        charge_uah / 1000.0, energy_uwh / 1000.0, protection_ms / 1000.0, max_interval_ms))
+    for section, name in ((1, "close"), (2, "open")):
+        status, data, _ = client.request(CMD_QUERY_ENERGY, bytes([section]))
+        if status != 0:
+            return status
+        (count, trips, last_ms, last_peak_dma, last_nwh,
+         total_uwh, total_ms, protection_ms) = struct.unpack("<HHIhIIII", data[:26])
+        average = total_uwh / count if count else 0.0
+        print("%s: count=%d trips=%d last=%d ms/%.1f mA/%.3f mWh avg=%.3f mWh total=%.1f s protection=%.1f s" % (
+            name, count, trips, last_ms, last_peak_dma / 10.0, last_nwh / 1e6, average / 1000.0,
+            total_ms / 1000.0, protection_ms / 1000.0))
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("port")
+    parser.add_argument("command", choices=["ping", "query", "speed", "grip", "stop", "release", "rtt", "energy",
+                                                "position"])
+    parser.add_argument("value", nargs="?", type=int)
+    parser.add_argument("--hold", type=float, default=0.0, help="удерживать управление N секунд")
+    parser.add_argument("--count", type=int, default=200, help="число запросов для rtt")
+    parser.add_argument("--timeout", type=float, default=0.5)
+    args = parser.parse_args()
+
+    client = GripperClient(args.port, args.timeout)
+
+    if args.command == "rtt":
+        samples = []
+        for _ in range(args.count):
+            _, _, rtt = client.request(CMD_PING)
+            samples.append(rtt * 1000.0)
+        samples.sort()
+        print("RTT over %d frames: min=%.2f median=%.2f p99=%.2f max=%.2f ms" % (
+            len(samples), samples[0], statistics.median(samples),
+            samples[min(len(samples) - 1, int(len(samples) * 0.99))], samples[-1]))
+        return 0
+
+    if args.command == "energy":
+        return 0 if print_energy(client) == 0 else 1
+
+    payload = b""
+    cmd = {"ping": CMD_PING, "query": CMD_QUERY, "speed": CMD_SET_SPEED, "grip": CMD_SET_GRIP_CURRENT,
+           "stop": CMD_STOP, "release": CMD_RELEASE, "position": CMD_SET_POSITION}[args.command]
+    if cmd == CMD_SET_SPEED:
+        payload = struct.pack("<h", args.value or 0)
+    elif cmd == CMD_SET_GRIP_CURRENT:
+        if args.value is None:
+            parser.error("grip requires a current in mA")
+        payload = struct.pack("<H", args.value)
+    elif cmd == CMD_SET_POSITION:
+        if args.value is None:
+            parser.error("position requires 0..1000 (permille of travel, 1000 = closed)")
+        payload = struct.pack("<H", args.value)
+
+    status, data, rtt = client.request(cmd, payload)
+    print("%s: %s (%.2f ms)" % (args.command, STATUS_NAMES.get(status, status), rtt * 1000.0))
+    if cmd == CMD_QUERY and status == 0:
+        print_query(data)
+    if args.hold > 0:
+        client.hold(args.hold)
+    return 0 if status == 0 else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,165 @@
+// Проверка калибровки смещения нуля тока при известном смещении и дрейфе
+//
+// Неизмененные CurrentSensor (с IdleCalibrator), MotorDriver и GripperController
+// работают в порядке loop() прошивки с виртуальными часами: измерение тока,
+// шаг плавного разгона, такт управления с импульсом RC. Показание INA219 -
+// известное смещение нуля, растущее с постоянной скоростью (температурный дрейф),
+// плюс ток двигателя, пока он вращается, плюс гауссов шум (фиксированное зерно).
+// Двигатель пускается импульсом раз в минуту, такт пуска сдвигается от цикла
+// к циклу, поэтому первое измерение после пуска попадает между тактами.
+// Требования:
+//   - калибровка при старте завершается до первого пуска с ошибкой не более CALIBRATION_TOLERANCE_MA
+//   - ни один сэмпл с вращающимся двигателем не принят как холостой (нет отброшенных выбросов)
+//   - ошибка отслеживания дрейфа на холостом ходу не более TRACKING_TOLERANCE_MA
+//
+// Сборка (из корня репозитория):
+//   g++ -O2 -std=gnu++17 -Itools/replay/shim -Isrc -o idle_cal_sim tools/idle_cal_sim/idle_cal_sim.cpp
+//       src/CurrentSensor.cpp src/CurrentFilter.cpp src/IdleCalibrator.cpp src/MotorDriver.cpp
+//       src/GripperController.cpp src/JawPosition.cpp src/RippleCounter.cpp src/PositionController.cpp src/RuntimeConfig.cpp
+// Использование:
+//   ./idle_cal_sim                - прогнать проверку (код 1 при ошибке)
+//   ./idle_cal_sim --verbose      - также вывести сообщения прошивки в stderr
+
+#include <Arduino.h>
+#include <random>
+#include "Config.h"
+#include "CurrentSensor.h"
+#include "MotorDriver.h"
+#include "GripperController.h"
+
+namespace replay_clock {
+uint32_t now_ms = 0;
+}
+
+namespace replay_sensor {
+float current_mA = 0.0f;
+float bus_voltage_V = 0.0f;
+float power_mW = 0.0f;
+}
+
+ReplaySerial Serial;
+TwoWire Wire;
+
+// Модель показания датчика
+static constexpr float OFFSET_MA = 1.0f;            // Смещение нуля при включении
+static constexpr float DRIFT_MA_PER_H = 1.5f;       // Дрейф смещения
+static constexpr float NOISE_SIGMA_MA = 0.2f;       // СКО шума показания
+static constexpr float MOTOR_CURRENT_MA = 6.0f;     // Ток вращения (ниже порога защиты, выше допуска выброса)
+static constexpr uint32_t DURATION_MS = 2UL * 3600UL * 1000UL;
+
+// Цикл движения: пуск в CYCLE_START_MS + сдвиг, вращение RUN_MS
+static constexpr uint32_t CYCLE_MS = 60000;
+static constexpr uint32_t CYCLE_START_MS = 5000;
+static constexpr uint32_t RUN_MS = 8000;
+static constexpr uint32_t PULSE_RUN_US = 1900;
+
+// Допуски
+static constexpr float CALIBRATION_TOLERANCE_MA = 0.15f;
+static constexpr float TRACKING_TOLERANCE_MA = 0.15f;
+
+/**
+ * Истинное смещение нуля
+ * @param time_ms - время от включения
+ * @return смещение в мА
+ */
+static float trueOffset(uint32_t time_ms) {
+    return OFFSET_MA + DRIFT_MA_PER_H * time_ms / 3600000.0f;
+}
+
+/**
+ * Требуется ли вращение в момент времени
+ * @param time_ms - время от включения
+ * @return true если импульс RC требует движения
+ */
+static bool motorCommanded(uint32_t time_ms) {
+    uint32_t cycle = time_ms / CYCLE_MS;
+    // Такт пуска сдвигается на такт управления от цикла к циклу
+    uint32_t start = CYCLE_START_MS + (cycle % 5) * CONTROL_TICK_INTERVAL_MS;
+    uint32_t in_cycle = time_ms % CYCLE_MS;
+    return in_cycle >= start && in_cycle < start + RUN_MS;
+}
+
+int main(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--verbose") == 0) {
+            Serial.enabled = true;
+        } else {
+            fprintf(stderr, "Usage: %s [--verbose]\n", argv[0]);
+            return 2;
+        }
+    }
+    std::mt19937 rng(32);
+    std::normal_distribution<float> noise(0.0f, NOISE_SIGMA_MA);
+
+    CurrentSensor sensor(0, 0);
+    MotorDriver motor(0, 1);
+    GripperController controller(motor, sensor);
+    sensor.attachMotor(&motor);
+    replay_sensor::bus_voltage_V = 12.0f;
+    sensor.begin();
+    motor.begin();
+    const IdleCalibrator& calibrator = sensor.getIdleCalibrator();
+
+    bool failed = false;
+    bool calibrated_before_start = false;
+    float calibration_error = 0.0f;
+    float max_tracking_error = 0.0f;
+    uint32_t idle_measurements = 0, running_measurements = 0;
+    uint32_t last_tick = 0;
+
+    printf("%8s %9s %9s %9s\n", "time, s", "true, mA", "estim, mA", "error, mA");
+    for (uint32_t now = 0; now < DURATION_MS; now++) {
+        replay_clock::now_ms = now;
+
+        // Показание на момент измерения: двигатель вращается, если заполнение ненулевое
+        bool running = motor.getSpeed() != MOTOR_SPEED_STOP;
+        replay_sensor::current_mA = trueOffset(now) + (running ? MOTOR_CURRENT_MA : 0.0f) + noise(rng);
+        replay_sensor::power_mW = replay_sensor::current_mA * replay_sensor::bus_voltage_V;
+        if (sensor.update()) {
+            running ? running_measurements++ : idle_measurements++;
+            if (calibrator.getState() == IdleCalibrator::STATE_TRACKING && !running) {
+                float error = fabsf(calibrator.getOffset_mA() - trueOffset(now));
+                if (!calibrated_before_start) {
+                    calibrated_before_start = true;
+                    calibration_error = error;
+                }
+                max_tracking_error = max(max_tracking_error, error);
+            }
+        }
+        motor.update();
+
+        if (now - last_tick >= CONTROL_TICK_INTERVAL_MS) {
+            last_tick = now;
+            controller.checkCurrentProtection(now);
+            controller.processPulse(motorCommanded(now) ? PULSE_RUN_US : PWM_NEUTRAL_US);
+        }
+
+        if (now % (20UL * 60UL * 1000UL) == 0) {
+            printf("%8u %9.3f %9.3f %+9.3f\n", now / 1000, trueOffset(now), calibrator.getOffset_mA(),
+                   calibrator.getOffset_mA() - trueOffset(now));
+        }
+        if (now == CYCLE_START_MS && !calibrated_before_start) {
+            printf("calibration not finished before the first start: FAIL\n");
+            failed = true;
+        }
+    }
+
+    printf("measurements: %u idle, %u running; calibration %u + drift %u samples, %u rejected\n",
+           idle_measurements, running_measurements, calibrator.getCalibrationSamples(),
+           calibrator.getDriftSamples(), calibrator.getRejectedSamples());
+
+    bool ok = calibration_error <= CALIBRATION_TOLERANCE_MA;
+    printf("calibration error: %.3f mA (limit %.2f): %s\n", calibration_error, CALIBRATION_TOLERANCE_MA, ok ? "ok" : "FAIL");
+    failed = failed || !ok;
+
+    ok = calibrator.getRejectedSamples() == 0 && calibrator.getState() == IdleCalibrator::STATE_TRACKING;
+    printf("running samples taken as idle: %s\n", ok ? "none" : "FAIL");
+    failed = failed || !ok;
+
+    ok = max_tracking_error <= TRACKING_TOLERANCE_MA;
+    printf("drift tracking error: max %.3f mA (limit %.2f): %s\n", max_tracking_error, TRACKING_TOLERANCE_MA, ok ? "ok" : "FAIL");
+    failed = failed || !ok;
+
+    printf("%s\n", failed ? "FAIL" : "OK");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,247 @@
+// Проверка регулятора положения губок по энкодеру на модели привода
+//
+// Коллекторный двигатель с редуктором и квадратурным энкодером (электрическая
+// часть, инерция, трение, упоры и предмет между губками) управляется
+// неизмененными GripperController, PositionController, MotorDriver и
+// CurrentSensor с виртуальными часами. 16-битный счетчик таймера моделируется
+// с переполнением и расширяется QuadratureEncoder::extend(), как в прошивке.
+//
+// Сценарий:
+//   0. Цифровая команда до хоминга отклоняется и не перехватывает управление у RC
+//   1. RC: открытие из неизвестного положения до упора - ноль энкодера
+//   2. RC: положение 60%, затем 20% (импульс задает положение каждый кадр 20 мс)
+//   3. Цифровая команда: 90% с предметом на 80% - упор, защита держит губки
+//   4. Цифровая команда: 30% - обратный ход сбрасывает защиту
+// Для каждого шага выводится время установления, перерегулирование и ошибка.
+//
+// Сборка (из корня репозитория):
+//   g++ -O2 -std=gnu++17 -Itools/replay/shim -Isrc -o position_sim tools/position_sim/position_sim.cpp
+//       src/CurrentSensor.cpp src/CurrentFilter.cpp src/IdleCalibrator.cpp src/MotorDriver.cpp
+//       src/GripperController.cpp src/JawPosition.cpp src/RippleCounter.cpp src/PositionController.cpp src/RuntimeConfig.cpp
+// Использование:
+//   ./position_sim                  - прогнать сценарий (код 1 при превышении допусков)
+//   ./position_sim --loop-us 20000  - регулятор с периодом кадра RC для сравнения
+//   ./position_sim --verbose        - также вывести сообщения прошивки в stderr
+
+#include <Arduino.h>
+#include "Config.h"
+#include "CurrentSensor.h"
+#include "MotorDriver.h"
+#include "GripperController.h"
+#include "PositionController.h"
+#include "QuadratureEncoder.h"
+
+namespace replay_clock {
+uint32_t now_ms = 0;
+}
+
+namespace replay_sensor {
+float current_mA = 0.0f;
+float bus_voltage_V = 0.0f;
+float power_mW = 0.0f;
+}
+
+ReplaySerial Serial;
+TwoWire Wire;
+
+// Привод губок: положение в отсчетах энкодера (x4), + к закрытию
+struct DriveModel {
+    double supply_V = 12.0;
+    double resistance_ohm = 600.0;      // Ток упора при полном заполнении 20 мА
+    double ideal_rate_cps = 5000.0;     // Отсчетов/с без нагрузки и трения
+    double friction_mA = 3.0;           // Ток на преодоление трения
+    double time_constant_s = 0.02;      // Механическая постоянная времени
+    double position = ENCODER_COUNTS_PER_TRAVEL / 2.0;
+    double rate = 0.0;
+    double current_mA = 0.0;
+    double object_position = -1.0;      // Предмет между губками (< 0 - нет)
+
+    double ke() const { return supply_V / ideal_rate_cps; }
+
+    void step(double duty, double dt) {
+        double voltage = supply_V * duty;
+        double current_A = (voltage - ke() * rate) / resistance_ohm;
+        double friction_A = friction_mA / 1000.0;
+
+        double limit_close = (object_position >= 0.0) ? object_position : ENCODER_COUNTS_PER_TRAVEL;
+        bool blocked = (position >= limit_close && current_A > 0.0) || (position <= 0.0 && current_A < 0.0);
+
+        if (blocked) {
+            rate = 0.0;
+            current_A = voltage / resistance_ohm;
+        } else if (rate == 0.0 && fabs(current_A) <= friction_A) {
+            // Трение покоя
+        } else {
+            double direction = (rate != 0.0) ? (rate > 0.0 ? 1.0 : -1.0) : (current_A > 0.0 ? 1.0 : -1.0);
+            double gain = resistance_ohm / (ke() * time_constant_s);
+            double next_rate = rate + gain * (current_A - direction * friction_A) * dt;
+            rate = (next_rate * direction < 0.0) ? 0.0 : next_rate;
+            position = constrain(position + rate * dt, 0.0, limit_close);
+        }
+        current_mA = fabs(current_A) * 1000.0;
+    }
+};
+
+struct Step {
+    const char* name;
+    uint32_t pulse_us;        // Импульс RC (0 - цифровая команда)
+    int16_t target_permille;  // Цифровое положение
+    double object_position;   // Предмет (< 0 - нет)
+    uint32_t duration_ms;     // Длительность шага
+    double expected;          // Ожидаемое конечное положение (отсчеты, < 0 - край "открыт" с хомингом)
+};
+
+int main(int argc, char* argv[]) {
+    uint32_t loop_us = POSITION_LOOP_INTERVAL_US;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--verbose") == 0) {
+            Serial.enabled = true;
+        } else if (strcmp(argv[i], "--loop-us") == 0 && i + 1 < argc) {
+            loop_us = static_cast<uint32_t>(atoi(argv[++i]));
+        } else {
+            fprintf(stderr, "Usage: %s [--verbose] [--loop-us N]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (loop_us < 10 || loop_us % 10 != 0) {
+        fprintf(stderr, "--loop-us must be a multiple of 10\n");
+        return 2;
+    }
+
+    CurrentSensor sensor(0, 0);
+    MotorDriver motor(0, 1);
+    GripperController controller(motor, sensor);
+    sensor.attachMotor(&motor);
+    PositionController position;
+    DriveModel drive;
+
+    replay_sensor::bus_voltage_V = static_cast<float>(drive.supply_V);
+    sensor.begin();
+    motor.begin();
+    controller.attachPositionControl(&position);
+
+    // Счетчик таймера начинается у нуля: открытие проходит через 0 -> 0xFFFF
+    const uint16_t raw_offset = 0x0020;
+    uint16_t last_raw = raw_offset;
+    int32_t encoder_count = 0;
+    const int32_t start_count = static_cast<int32_t>(drive.position);
+
+    const double travel = ENCODER_COUNTS_PER_TRAVEL;
+    const double pulse_span = PWM_MAX_US - PWM_MIN_US;
+    const Step steps[] = {
+        {"RC open, not homed", 1000, 0,   -1.0,         8000, -1.0},
+        {"RC 60%",             1800, 0,   -1.0,         3000, travel * (1800 - PWM_MIN_US) / pulse_span},
+        {"RC 20%",             1200, 0,   -1.0,         3000, travel * (1200 - PWM_MIN_US) / pulse_span},
+        {"digital 90%, object",   0, 900, 0.8 * travel, 4000, 0.8 * travel},
+        {"digital 30%",           0, 300, 0.8 * travel, 3000, 0.3 * travel},
+    };
+
+    const uint32_t step_us = 10;
+    uint32_t now_us = 0;
+    uint32_t last_loop_us = 0;
+    uint32_t last_tick_ms = 0;
+    bool failed = false;
+
+    // Пуск: датчик калибрует смещение нуля при неподвижном двигателе
+    for (; now_us < 1000000; now_us += 1000) {
+        replay_clock::now_ms = now_us / 1000;
+        sensor.update();
+        controller.checkCurrentProtection(replay_clock::now_ms);
+    }
+    last_loop_us = now_us;
+
+    // До хоминга цифровое положение отклоняется и управление остается у RC
+    if (controller.setPositionTarget(500, now_us / 1000) ||
+        controller.getSource() != GripperController::SOURCE_RC) {
+        printf("position target before homing: accepted or took control from RC  FAIL\n");
+        failed = true;
+    }
+
+    printf("loop period %u us\n", loop_us);
+    printf("%-22s %8s %8s %8s %9s %9s %s\n", "step", "true", "encoder", "error", "overshoot", "settle ms", "homed");
+    for (const Step& step : steps) {
+        drive.object_position = step.object_position;
+        uint32_t step_start_ms = now_us / 1000;
+        double start_position = drive.position;
+        double overshoot = 0.0;
+        uint32_t settle_ms = 0;
+        bool settled = false;
+
+        if (step.pulse_us == 0) {
+            if (!controller.setPositionTarget(step.target_permille, step_start_ms)) {
+                printf("%-22s position target rejected (not homed)\n", step.name);
+                failed = true;
+            }
+        } else {
+            controller.releaseDigital();
+        }
+
+        while (now_us / 1000 - step_start_ms < step.duration_ms) {
+            drive.step(motor.getSpeed() / 255.0, step_us * 1e-6);
+            now_us += step_us;
+
+            // Регулятор положения с собственным периодом
+            if (now_us - last_loop_us >= loop_us) {
+                int32_t true_count = static_cast<int32_t>(floor(drive.position)) - start_count;
+                uint16_t raw = static_cast<uint16_t>(raw_offset + true_count * GRIPPER_CLOSE_DIRECTION);
+                encoder_count = QuadratureEncoder::extend(encoder_count, last_raw, raw);
+                last_raw = raw;
+                controller.updatePositionControl(encoder_count, now_us - last_loop_us);
+                last_loop_us = now_us;
+            }
+
+            if (now_us % 1000 != 0) continue;
+            uint32_t now_ms = now_us / 1000;
+            replay_clock::now_ms = now_ms;
+            replay_sensor::current_mA = static_cast<float>(drive.current_mA);
+            replay_sensor::power_mW = static_cast<float>(drive.current_mA * drive.supply_V);
+            sensor.update();
+            motor.update();
+
+            // Такт управления и кадр RC - 20 мс
+            if (now_ms - last_tick_ms >= CONTROL_TICK_INTERVAL_MS) {
+                last_tick_ms = now_ms;
+                if (step.pulse_us == 0) {
+                    controller.digitalHeartbeat(now_ms);
+                }
+                controller.checkDigitalTimeout(now_ms);
+                controller.checkCurrentProtection(now_ms);
+                if (step.pulse_us != 0) {
+                    controller.processPulse(step.pulse_us);
+                }
+            }
+
+            // Перерегулирование и время установления для шагов к цели
+            if (step.expected >= 0.0) {
+                double beyond = (step.expected >= start_position) ? drive.position - step.expected
+                                                                   : step.expected - drive.position;
+                overshoot = max(overshoot, beyond);
+                bool inside = fabs(drive.position - step.expected) <= 2 * POSITION_DEADBAND_COUNTS;
+                if (inside && !settled) {
+                    settled = true;
+                    settle_ms = now_ms - step_start_ms;
+                } else if (!inside) {
+                    settled = false;
+                }
+            }
+        }
+
+        double expected = (step.expected >= 0.0) ? step.expected : 0.0;
+        double error = position.getPosition() - expected;
+        double true_error = drive.position - expected;
+        bool ok = position.isHomed() && fabs(position.getPosition() - drive.position) <= 1.0;
+        if (step.expected >= 0.0) {
+            ok = ok && settled && fabs(true_error) <= 2 * POSITION_DEADBAND_COUNTS && overshoot <= 0.02 * travel;
+        }
+        failed = failed || !ok;
+
+        printf("%-22s %8.0f %8ld %8.0f %9.0f %9u %s%s\n", step.name, drive.position,
+               static_cast<long>(position.getPosition()), error, overshoot, settled ? settle_ms : 0,
+               position.isHomed() ? "yes" : "no", ok ? "" : "  FAIL");
+    }
+
+    Serial.enabled = true;
+    position.printReport();
+    printf(failed ? "FAIL\n" : "OK\n");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,356 @@
+// Воспроизведение трассы входных данных захвата на хосте быстрее реального времени
+//
+// Прогоняет записанные импульсы управления и показания INA219 через
+// неизмененные CurrentSensor (фильтрация), GripperController (защита по току),
+// MotorDriver (плавный разгон) и EnergyMeter (заряд и энергия) с виртуальными часами.
+// Точность EnergyMeter проверяет tools/energy_sim (сэмплы в обход интервала измерения).
+//
+// Формат трассы (строки "T ..." в логе Serial после команды "trace on"):
+//   T H 2 <такт управления, мс> <интервал измерения тока, мс> <число полей> <значения runtimeConfig>
+//         (значения в порядке RuntimeConfig::FIELDS; в версии 1 полей нет - значения по умолчанию)
+//   T P <время, мс> <длина импульса, мкс>
+//   T I <время, мс> <ток до фильтра, мА> <напряжение, В> <мощность, мВт>
+//   T C <время, мс> <код команды CommandProtocol> <значение>
+// Остальные строки лога игнорируются.
+//
+// Результат - строки изменения состояния контроллера:
+//   O <время, мс> <заданная скорость> <примененная скорость> <защита 0|1> <старт 0|1>
+//
+// Сборка (из корня репозитория):
+//   g++ -O2 -std=gnu++17 -Itools/replay/shim -Isrc -o replay tools/replay/replay.cpp
+//       src/CurrentSensor.cpp src/CurrentFilter.cpp src/IdleCalibrator.cpp src/MotorDriver.cpp
+//       src/GripperController.cpp src/EnergyMeter.cpp src/JawPosition.cpp src/RippleCounter.cpp
+//       src/PositionController.cpp src/RuntimeConfig.cpp
+// Использование:
+//   ./replay tools/replay/traces/sample.log tools/replay/traces/sample.golden
+//                                             - проверка на эталонной трассе (код 1 при расхождении)
+//   ./replay trace.log > result.txt           - воспроизвести
+//   ./replay trace.log golden.txt             - сравнить с эталоном (код 1 при расхождении)
+//   ./replay --verbose trace.log              - также вывести сообщения прошивки в stderr
+//   ./replay --offset 2 --drift 3 trace.log   - добавить к току смещение нуля 2 мА, растущее
+//                                               на 3 мА/ч (температурный дрейф), и вывести
+//                                               ошибку его отслеживания
+
+#include <Arduino.h>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include "Config.h"
+#include "CurrentSensor.h"
+#include "MotorDriver.h"
+#include "GripperController.h"
+#include "CommandProtocol.h"
+#include "EnergyMeter.h"
+#include "RuntimeConfig.h"
+
+namespace replay_clock {
+uint32_t now_ms = 0;
+}
+
+namespace replay_sensor {
+float current_mA = 0.0f;
+float bus_voltage_V = 0.0f;
+float power_mW = 0.0f;
+}
+
+ReplaySerial Serial;
+TwoWire Wire;
+
+struct TraceEvent {
+    char type;           // 'P' - импульс, 'I' - измерение тока, 'C' - цифровая команда
+    uint32_t time_ms;    // Время события
+    uint32_t pulse_us;   // Длина импульса / код команды
+    int32_t value;       // Значение команды
+    float current_mA;    // Ток до фильтра
+    float voltage_V;     // Напряжение
+    float power_mW;      // Мощность
+};
+
+struct TraceHeader {
+    uint32_t version = 1;
+    uint32_t tick_ms = CONTROL_TICK_INTERVAL_MS;
+    uint32_t measurement_ms = CURRENT_MEASUREMENT_INTERVAL;
+};
+
+// Значения runtimeConfig из заголовка версии 2 (в порядке RuntimeConfig::FIELDS)
+static bool loadConfig(std::istringstream& fields) {
+    unsigned field_count = 0;
+    if (!(fields >> field_count) || field_count != RuntimeConfig::FIELD_COUNT) {
+        return false;
+    }
+    RuntimeConfig config = RuntimeConfig::DEFAULTS;
+    for (uint8_t i = 0; i < RuntimeConfig::FIELD_COUNT; i++) {
+        unsigned value = 0;
+        if (!(fields >> value)) {
+            return false;
+        }
+        config.*RuntimeConfig::FIELDS[i].member = static_cast<uint16_t>(value);
+    }
+    if (config.validate() != nullptr) {
+        return false;
+    }
+    runtimeConfig = config;
+    return true;
+}
+
+static bool loadTrace(const char* path, TraceHeader& header, std::vector<TraceEvent>& events) {
+    std::ifstream input(path);
+    if (!input) {
+        fprintf(stderr, "Cannot open %s\n", path);
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(input, line)) {
+        std::istringstream fields(line);
+        std::string tag, type;
+        if (!(fields >> tag >> type) || tag != "T") continue;
+
+        if (type == "H") {
+            fields >> header.version >> header.tick_ms >> header.measurement_ms;
+            if (header.version != 1 && header.version != 2) {
+                fprintf(stderr, "Unsupported trace version %u\n", header.version);
+                return false;
+            }
+            if (header.version == 2 && !loadConfig(fields)) {
+                fprintf(stderr, "Bad runtime config in trace header\n");
+                return false;
+            }
+        } else if (type == "P") {
+            TraceEvent e{'P', 0, 0, 0, 0, 0, 0};
+            if (fields >> e.time_ms >> e.pulse_us) events.push_back(e);
+        } else if (type == "C") {
+            TraceEvent e{'C', 0, 0, 0, 0, 0, 0};
+            if (fields >> e.time_ms >> e.pulse_us >> e.value) events.push_back(e);
+        } else if (type == "I") {
+            TraceEvent e{'I', 0, 0, 0, 0, 0, 0};
+            if (fields >> e.time_ms >> e.current_mA >> e.voltage_V >> e.power_mW) events.push_back(e);
+        }
+    }
+    return true;
+}
+
+// Цифровая команда применяется так же, как в handleBinaryFrame() прошивки
+static void applyCommand(GripperController& controller, const TraceEvent& e) {
+    controller.digitalHeartbeat(e.time_ms);
+    switch (e.pulse_us) {
+        case CommandProtocol::CMD_SET_SPEED:
+            controller.setDigitalSpeed(static_cast<int16_t>(e.value), e.time_ms);
+            break;
+        case CommandProtocol::CMD_SET_GRIP_CURRENT:
+            runtimeConfig.protection_threshold_mA = static_cast<uint16_t>(e.value);
+            break;
+        case CommandProtocol::CMD_SET_POSITION:
+            controller.setPositionTarget(static_cast<uint16_t>(e.value), e.time_ms);
+            break;
+        case CommandProtocol::CMD_STOP:
+            controller.digitalStop(e.time_ms);
+            break;
+        case CommandProtocol::CMD_RELEASE:
+            controller.releaseDigital();
+            break;
+        default:
+            break;
+    }
+}
+
+static void emitState(std::vector<std::string>& output, uint32_t time_ms,
+                      const GripperController& controller, const MotorDriver& motor) {
+    char line[96];
+    snprintf(line, sizeof(line), "O %u %d %d %d %d", time_ms,
+             controller.getCommandedSpeed(), motor.getSpeed(),
+             controller.isProtectionActive() ? 1 : 0, controller.isStartupDelayActive() ? 1 : 0);
+    output.push_back(line);
+}
+
+int main(int argc, char* argv[]) {
+    int arg = 1;
+    float injected_offset_mA = 0.0f;
+    float injected_drift_mA_per_h = 0.0f;
+    while (arg < argc && strncmp(argv[arg], "--", 2) == 0) {
+        if (strcmp(argv[arg], "--verbose") == 0) {
+            Serial.enabled = true;
+        } else if (strcmp(argv[arg], "--offset") == 0 && arg + 1 < argc) {
+            injected_offset_mA = atof(argv[++arg]);
+        } else if (strcmp(argv[arg], "--drift") == 0 && arg + 1 < argc) {
+            injected_drift_mA_per_h = atof(argv[++arg]);
+        } else {
+            break;
+        }
+        arg++;
+    }
+    if (arg >= argc || strncmp(argv[arg], "--", 2) == 0) {
+        fprintf(stderr, "Usage: %s [--verbose] [--offset mA] [--drift mA/h] trace.log [golden.txt]\n", argv[0]);
+        return 2;
+    }
+    const char* trace_path = argv[arg++];
+    const char* golden_path = (arg < argc) ? argv[arg] : nullptr;
+
+    TraceHeader header;
+    std::vector<TraceEvent> events;
+    if (!loadTrace(trace_path, header, events)) return 2;
+    if (events.empty()) {
+        fprintf(stderr, "Trace has no events\n");
+        return 2;
+    }
+
+    auto wall_start = std::chrono::steady_clock::now();
+
+    CurrentSensor sensor(0, 0);
+    MotorDriver motor(0, 0);
+    GripperController controller(motor, sensor);
+    sensor.attachMotor(&motor);
+
+    // Настройка фильтров определяет задержку срабатывания защиты
+    const CurrentFilter* filters[] = {&sensor.getFastFilter(), &sensor.getSlowFilter()};
+    const char* filter_names[] = {"fast", "slow"};
+    for (uint8_t i = 0; i < 2; i++) {
+        float delay_samples = filters[i]->getGroupDelaySamples();
+        fprintf(stderr, "Filter %s: %s, group delay %.2f samples = %.1f ms\n", filter_names[i],
+                filters[i]->getTypeName(), delay_samples, delay_samples * header.measurement_ms);
+    }
+
+    uint32_t now = events.front().time_ms;
+    uint32_t trace_start = now;
+    float injected_mA = injected_offset_mA;
+
+    // Эталонный оценщик получает ток трассы без добавленного смещения:
+    // разность оценок минус добавленное смещение - ошибка отслеживания дрейфа
+    IdleCalibrator reference_calibrator;
+    float max_tracking_error_mA = 0.0f;
+
+    EnergyMeter energy;
+    replay_clock::now_ms = now;
+    sensor.begin();
+    motor.begin();
+
+    std::vector<std::string> output;
+    int16_t last_cmd = 0, last_applied = 0;
+    bool last_protection = false, last_startup = false;
+    uint32_t last_tick = now;
+    size_t next = 0;
+
+    // Виртуальное время идет скачками: к следующему событию трассы, такту
+    // управления или шагу плавного разгона - как цикл loop() прошивки
+    while (next < events.size()) {
+        replay_clock::now_ms = now;
+
+        bool tick_due = now - last_tick >= header.tick_ms;
+        bool pulse_event = false;
+        uint32_t pulse_us = 0;
+
+        while (next < events.size() && events[next].time_ms <= now) {
+            const TraceEvent& e = events[next++];
+            if (e.type == 'I') {
+                injected_mA = injected_offset_mA + injected_drift_mA_per_h * (e.time_ms - trace_start) / 3600000.0f;
+                replay_sensor::current_mA = e.current_mA + injected_mA;
+                replay_sensor::bus_voltage_V = e.voltage_V;
+                replay_sensor::power_mW = e.power_mW;
+                reference_calibrator.addSample(e.current_mA, motor.getSpeed() == MOTOR_SPEED_STOP, e.time_ms);
+                if (sensor.update()) {
+                    int32_t current_uA = static_cast<int32_t>(lroundf(sensor.getCorrectedCurrent_mA() * 1000.0f));
+                    int32_t voltage_mV = static_cast<int32_t>(lroundf(sensor.getVoltage_V() * 1000.0f));
+                    energy.addSample(current_uA, voltage_mV, now);
+                }
+
+                IdleCalibrator& calibrator = sensor.getIdleCalibrator();
+                if (calibrator.getState() == IdleCalibrator::STATE_TRACKING &&
+                    reference_calibrator.getState() == IdleCalibrator::STATE_TRACKING) {
+                    float error = fabsf(calibrator.getOffset_mA() - reference_calibrator.getOffset_mA() - injected_mA);
+                    if (error > max_tracking_error_mA) max_tracking_error_mA = error;
+                }
+            } else if (e.type == 'C') {
+                applyCommand(controller, e);
+            } else {
+                pulse_event = true;
+                pulse_us = e.pulse_us;
+            }
+        }
+
+        motor.update();
+
+        // Импульс в трассе записан на такте управления прошивки
+        if (tick_due || pulse_event) {
+            controller.checkDigitalTimeout(now);
+            controller.checkCurrentProtection(now);
+            if (pulse_event) {
+                controller.processPulse(pulse_us);
+            }
+            energy.updateState(motor.getSpeed(), controller.isProtectionActive(), now);
+            last_tick = now;
+        }
+
+        if (controller.getCommandedSpeed() != last_cmd || motor.getSpeed() != last_applied ||
+            controller.isProtectionActive() != last_protection ||
+            controller.isStartupDelayActive() != last_startup) {
+            emitState(output, now, controller, motor);
+            last_cmd = controller.getCommandedSpeed();
+            last_applied = motor.getSpeed();
+            last_protection = controller.isProtectionActive();
+            last_startup = controller.isStartupDelayActive();
+        }
+
+        uint32_t next_time = last_tick + header.tick_ms;
+        if (next < events.size() && events[next].time_ms < next_time) {
+            next_time = events[next].time_ms;
+        }
+        if (motor.isSmoothTransitionActive()) {
+            next_time = now + 1;
+        }
+        now = (next_time > now) ? next_time : now + 1;
+    }
+
+    double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+    double trace_s = (events.back().time_ms - events.front().time_ms) / 1000.0;
+    fprintf(stderr, "Replayed %zu events, %.1f s of trace in %.3f s (x%.0f)\n",
+            events.size(), trace_s, wall_s, wall_s > 0 ? trace_s / wall_s : 0.0);
+
+    // Оценка смещения включает холостой ток из самой трассы и добавленное смещение
+    IdleCalibrator& calibrator = sensor.getIdleCalibrator();
+    fprintf(stderr, "Idle offset: %.3f mA (injected %.3f mA at end), sigma %.3f mA, "
+            "%u calibration + %u drift samples, %u rejected\n",
+            calibrator.getOffset_mA(), injected_mA, sqrtf(calibrator.getVariance()),
+            calibrator.getCalibrationSamples(), calibrator.getDriftSamples(), calibrator.getRejectedSamples());
+    fprintf(stderr, "Offset tracking error: max %.3f mA\n", max_tracking_error_mA);
+
+    fprintf(stderr, "Charge: %.4f mAh, energy: %.4f mWh, max sample interval %u ms\n",
+            energy.getCharge_mAh(), energy.getEnergy_mWh(), energy.getMaxInterval_ms());
+    const char* direction_names[] = {"close", "open"};
+    for (uint8_t i = 0; i < EnergyMeter::DIRECTION_COUNT; i++) {
+        const EnergyMeter::ActuationStats& stats = energy.getStats(static_cast<EnergyMeter::Direction>(i));
+        fprintf(stderr, "  %s: %u moves, %u trips, avg %.4f mWh, max peak %.2f mA, protection %.1f s\n",
+                direction_names[i], stats.count, stats.trips,
+                stats.count ? stats.total_energy_nJ / 3.6e9 / stats.count : 0.0,
+                stats.max_peak_uA / 1000.0, stats.protection_ms / 1000.0);
+    }
+
+    if (golden_path == nullptr) {
+        for (const std::string& line : output) puts(line.c_str());
+        return 0;
+    }
+
+    std::ifstream golden(golden_path);
+    if (!golden) {
+        fprintf(stderr, "Cannot open %s\n", golden_path);
+        return 2;
+    }
+    std::string expected;
+    size_t index = 0;
+    while (std::getline(golden, expected)) {
+        if (expected.empty()) continue;
+        if (index >= output.size() || output[index] != expected) {
+            fprintf(stderr, "Mismatch at line %zu:\n  expected: %s\n  actual:   %s\n", index + 1,
+                    expected.c_str(), index < output.size() ? output[index].c_str() : "<end>");
+            return 1;
+        }
+        index++;
+    }
+    if (index != output.size()) {
+        fprintf(stderr, "Mismatch: %zu extra output lines, first: %s\n",
+                output.size() - index, output[index].c_str());
+        return 1;
+    }
+    fprintf(stderr, "OK: %zu lines match\n", index);
+    return 0;
+}
@@ -0,0 +1,23 @@
+// Замена драйвера INA219: возвращает значения текущего события трассы
+#ifndef REPLAY_SHIM_ADAFRUIT_INA219_H
+#define REPLAY_SHIM_ADAFRUIT_INA219_H
+
+#include "Wire.h"
+
+namespace replay_sensor {
+extern float current_mA;
+extern float bus_voltage_V;
+extern float power_mW;
+}
+
+class Adafruit_INA219 {
+public:
+    Adafruit_INA219(uint8_t = 0x40) {}
+    bool begin(TwoWire* = &Wire) { return true; }
+    void setCalibration_32V_1A() {}
+    float getCurrent_mA() { return replay_sensor::current_mA; }
+    float getBusVoltage_V() { return replay_sensor::bus_voltage_V; }
+    float getPower_mW() { return replay_sensor::power_mW; }
+};
+
+#endif // REPLAY_SHIM_ADAFRUIT_INA219_H
@@ -0,0 +1,85 @@
+// Минимальная замена Arduino.h для сборки логики захвата на хосте (tools/replay)
+// Время - виртуальные часы, управляемые программой воспроизведения,
+// аппаратные вызовы ничего не делают, вывод Serial можно отключить.
+#ifndef REPLAY_SHIM_ARDUINO_H
+#define REPLAY_SHIM_ARDUINO_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdio.h>
+#include <string>
+#include <algorithm>
+
+using std::max;
+using std::min;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLDOWN 3
+#define DEC 10
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+namespace replay_clock {
+extern uint32_t now_ms;
+}
+
+inline unsigned long millis() { return replay_clock::now_ms; }
+inline unsigned long micros() { return replay_clock::now_ms * 1000UL; }
+inline void delay(unsigned long) {}
+inline void pinMode(uint32_t, uint32_t) {}
+inline void analogWrite(uint32_t, int) {}
+inline void digitalWrite(uint32_t, uint32_t) {}
+inline int digitalRead(uint32_t) { return LOW; }
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+class String {
+    std::string text;
+public:
+    String(const char* s = "") : text(s) {}
+    String(const std::string& s) : text(s) {}
+    String(int v) : text(std::to_string(v)) {}
+    String(unsigned int v) : text(std::to_string(v)) {}
+    String(long v) : text(std::to_string(v)) {}
+    String(unsigned long v) : text(std::to_string(v)) {}
+    String(double v, int digits = 2) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%.*f", digits, v);
+        text = buf;
+    }
+    String operator+(const String& other) const { return String(text + other.text); }
+    String operator+(const char* other) const { return String(text + other); }
+    friend String operator+(const char* a, const String& b) { return String(std::string(a) + b.text); }
+    const char* c_str() const { return text.c_str(); }
+};
+
+// Вывод Serial: по умолчанию отключен, включается флагом --verbose
+class ReplaySerial {
+public:
+    bool enabled = false;
+    template <typename T> size_t print(const T& v) { return enabled ? out(v) : 0; }
+    template <typename T> size_t print(const T& v, int digits) { return enabled ? out(v, digits) : 0; }
+    template <typename T> size_t println(const T& v) { size_t n = print(v); return n + println(); }
+    template <typename T> size_t println(const T& v, int digits) { size_t n = print(v, digits); return n + println(); }
+    size_t println() { return enabled ? fputs("\n", stderr) : 0; }
+    size_t write(const uint8_t* data, size_t size) { return enabled ? fwrite(data, 1, size, stderr) : 0; }
+private:
+    size_t out(const char* s) { return fputs(s, stderr); }
+    size_t out(char c) { return fputc(c, stderr); }
+    size_t out(const String& s) { return fputs(s.c_str(), stderr); }
+    size_t out(long long v, int = DEC) { return fprintf(stderr, "%lld", v); }
+    size_t out(unsigned long long v, int = DEC) { return fprintf(stderr, "%llu", v); }
+    size_t out(int v, int d = DEC) { return out(static_cast<long long>(v), d); }
+    size_t out(unsigned int v, int d = DEC) { return out(static_cast<unsigned long long>(v), d); }
+    size_t out(long v, int d = DEC) { return out(static_cast<long long>(v), d); }
+    size_t out(unsigned long v, int d = DEC) { return out(static_cast<unsigned long long>(v), d); }
+    size_t out(double v, int digits = 2) { return fprintf(stderr, "%.*f", digits, v); }
+};
+
+extern ReplaySerial Serial;
+
+#endif // REPLAY_SHIM_ARDUINO_H
@@ -0,0 +1,20 @@
+#ifndef REPLAY_SHIM_WIRE_H
+#define REPLAY_SHIM_WIRE_H
+
+#include "Arduino.h"
+
+class TwoWire {
+public:
+    void begin() {}
+    void begin(uint32_t, uint32_t) {}
+    void setClock(uint32_t) {}
+    void beginTransmission(uint8_t) {}
+    size_t write(uint8_t) { return 1; }
+    uint8_t endTransmission(bool = true) { return 0; }
+    uint8_t requestFrom(uint8_t, uint8_t quantity) { return quantity; }
+    int read() { return 0; }
+};
+
+extern TwoWire Wire;
+
+#endif // REPLAY_SHIM_WIRE_H
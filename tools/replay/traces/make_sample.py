@@ -0,0 +1,94 @@
+#!/usr/bin/env python3
+"""Синтетическая трасса sample.log для проверки tools/replay.
+
+Формат - как вывод прошивки после "trace on" (строки "T ...", прочие строки
+лога игнорируются). Сценарий на 24 с с настройками, отличными от умолчаний:
+  0-2 с    нейтраль, холостой ток (калибровка нуля)
+  2-6 с    RC: сжатие, пусковой бросок в задержке защиты, упор - срабатывание защиты
+  6-10 с   RC: нейтраль, раскрытие, нейтраль
+  10-14 с  цифровое управление: порог захвата, скорость, рост тока - срабатывание
+  14-16 с  стоп, положение (без датчика положения - отклонено), возврат к RC,
+           раскрытие снимает защиту
+  16-24 с  RC: частичное сжатие; цифровая скорость без подтверждения связи - таймаут
+
+Запуск (из корня репозитория):
+  python3 tools/replay/traces/make_sample.py > tools/replay/traces/sample.log
+"""
+import random
+
+TICK_MS = 20
+MEASUREMENT_MS = 50
+# deadzone_min deadzone_max threshold start_delay ramp_step_ms ramp_step heartbeat tm_period
+CONFIG = (1450, 1550, 60, 400, 5, 16, 500, 100)
+
+# Коды команд CommandProtocol
+CMD_SET_SPEED = 0x02
+CMD_SET_GRIP_CURRENT = 0x03
+CMD_STOP = 0x04
+CMD_RELEASE = 0x06
+CMD_SET_POSITION = 0x08
+END_MS = 24000
+
+
+def pulse_at(t):
+    if 2000 <= t < 6000:
+        return 1900
+    if 7000 <= t < 9000:
+        return 1100
+    if 15500 <= t < 16500:
+        return 1300
+    if 17000 <= t < 19000:
+        return 1700
+    return 1500
+
+
+def current_at(t):
+    """Ток до фильтра (мА) без шума."""
+    idle = 0.6
+    if 2000 <= t < 6000:
+        if t < 2150:
+            return 90.0          # Пусковой бросок в задержке защиты
+        if t < 4500:
+            return 24.0
+        return 24.0 + (t - 4500) * 0.08  # Упор: ток растет
+    if 7000 <= t < 9000:
+        return 22.0 if t >= 7100 else 70.0
+    if 10200 <= t < 14000:
+        return 30.0 if t < 12500 else 30.0 + (t - 12500) * 0.03
+    if 15500 <= t < 16500 or 17000 <= t < 19000:
+        return 26.0
+    if 20000 <= t < 20600:
+        return 28.0
+    return idle
+
+
+def commands():
+    yield 10000, CMD_SET_GRIP_CURRENT, 45
+    for t in range(10100, 14000, 200):
+        yield t, CMD_SET_SPEED, 180
+    yield 14200, CMD_STOP, 0
+    yield 14600, CMD_SET_POSITION, 500
+    yield 15000, CMD_RELEASE, 0
+    yield 20000, CMD_SET_SPEED, -150
+
+
+def main():
+    rng = random.Random(28)
+    lines = ["T H 2 %d %d %d %s" % (TICK_MS, MEASUREMENT_MS, len(CONFIG), " ".join(map(str, CONFIG))),
+             "Trace: on"]
+    events = []
+    for t in range(TICK_MS, END_MS, TICK_MS):
+        events.append((t, 0, "T P %d %d" % (t, pulse_at(t) + rng.randint(-3, 3))))
+    for t in range(MEASUREMENT_MS, END_MS, MEASUREMENT_MS):
+        current = current_at(t) + rng.gauss(0.0, 0.15)
+        voltage = 12.0 - current * 0.002 + rng.gauss(0.0, 0.004)
+        events.append((t, 1, "T I %d %.3f %.3f %.2f" % (t, current, voltage, current * voltage)))
+    for t, cmd, value in commands():
+        events.append((t, 2, "T C %d %d %d" % (t, cmd, value)))
+    events.sort(key=lambda e: (e[0], e[1]))
+    lines += [line for _, _, line in events]
+    print("\n".join(lines))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,265 @@
+// Моделирование бездатчиковой оценки положения губок на хосте
+//
+// Коллекторный двигатель (электрическая часть, инерция, трение, упоры и предмет
+// между губками) управляется неизмененными GripperController, MotorDriver,
+// CurrentSensor, JawPosition и RippleCounter с виртуальными часами.
+// Ток шунта содержит коммутационные пульсации с известной фазой, шум и
+// квантование регистра INA219: при вращении АЦП шунта 10 бит, шаг 4 отсчета
+// по 10 мкВ (40 мкВ на 0.1 Ом = 0.4 мА); сэмплы идут
+// с интервалом RIPPLE_SAMPLE_INTERVAL_US, случайным дрожанием и периодическими
+// пропусками (занятый цикл). Истинное число пульсаций известно.
+//
+// Сценарий:
+//   1. Открытие из неизвестного положения до упора - хоминг
+//   2. Закрытие до предмета - упор вдали от края, без переустановки
+//   3. Открытие до края - мягкий упор, переустановка
+//   4. Заданное положение 50% без предмета
+//   5. Заданное положение 90% при неразличимых пульсациях - только модель
+//   6. Закрытие до края - мягкий упор, переустановка
+// Для каждого этапа выводится ошибка положения и скорость в момент упора.
+//
+// Сборка (из корня репозитория):
+//   g++ -O2 -std=gnu++17 -Itools/replay/shim -Isrc -o ripple_sim tools/ripple_sim/ripple_sim.cpp
+//       src/CurrentSensor.cpp src/CurrentFilter.cpp src/IdleCalibrator.cpp src/MotorDriver.cpp
+//       src/GripperController.cpp src/JawPosition.cpp src/RippleCounter.cpp src/PositionController.cpp src/RuntimeConfig.cpp
+// Использование:
+//   ./ripple_sim                 - прогнать сценарий (код 1 при превышении допусков)
+//   ./ripple_sim --verbose       - также вывести сообщения прошивки в stderr
+//   ./ripple_sim --seed 7        - другая последовательность шума и дрожания
+
+#include <Arduino.h>
+#include <random>
+#include "Config.h"
+#include "CurrentSensor.h"
+#include "MotorDriver.h"
+#include "GripperController.h"
+#include "JawPosition.h"
+
+namespace replay_clock {
+uint32_t now_ms = 0;
+}
+
+namespace replay_sensor {
+float current_mA = 0.0f;
+float bus_voltage_V = 0.0f;
+float power_mW = 0.0f;
+}
+
+ReplaySerial Serial;
+TwoWire Wire;
+
+// Двигатель с редуктором: положение губок в пульсациях (одна пульсация - одна коммутация)
+struct MotorModel {
+    double supply_V = 12.0;
+    double resistance_ohm = 600.0;      // Ток упора при полном заполнении 20 мА
+    double ideal_rate_hz = 1000.0;      // Пульсаций/с без нагрузки и трения (прошивка начинает с 800)
+    double friction_mA = 3.0;           // Ток на преодоление трения
+    double time_constant_s = 0.02;      // Механическая постоянная времени
+    double ripple_depth = 0.3;          // Глубина пульсаций относительно тока
+    double noise_raw = 1.0;             // СКО шума в отсчетах шунта
+    static constexpr long SHUNT_STEP_RAW = 4;   // Шаг АЦП шунта 10 бит (CONFIG_FAST_ADC), отсчеты по 10 мкВ
+
+    double position = JAW_TRAVEL_RIPPLES / 2.0;  // Истинное положение (пульсации)
+    double rate = 0.0;                  // Скорость (пульсаций/с, + к закрытию)
+    double current_mA = 0.0;            // Ток двигателя
+    double object_position = -1.0;      // Предмет между губками (< 0 - нет)
+
+    // Истинные пульсации
+    uint64_t ripples = 0;
+
+    double ke() const { return supply_V / ideal_rate_hz; }
+
+    void step(double duty, double dt) {
+        double voltage = supply_V * duty;
+        double current_A = (voltage - ke() * rate) / resistance_ohm;
+        double friction_A = friction_mA / 1000.0;
+
+        double limit_close = (object_position >= 0.0) ? object_position : JAW_TRAVEL_RIPPLES;
+        bool blocked = (position >= limit_close && current_A > 0.0) || (position <= 0.0 && current_A < 0.0);
+
+        double previous = position;
+        if (blocked) {
+            rate = 0.0;
+            current_A = voltage / resistance_ohm;
+        } else if (rate == 0.0 && fabs(current_A) <= friction_A) {
+            // Трение покоя
+        } else {
+            double direction = (rate != 0.0) ? (rate > 0.0 ? 1.0 : -1.0) : (current_A > 0.0 ? 1.0 : -1.0);
+            double gain = resistance_ohm / (ke() * time_constant_s);
+            double next_rate = rate + gain * (current_A - direction * friction_A) * dt;
+            rate = (next_rate * direction < 0.0) ? 0.0 : next_rate;
+            position += rate * dt;
+            position = constrain(position, 0.0, limit_close);
+        }
+        current_mA = fabs(current_A) * 1000.0;
+
+        long crossed = static_cast<long>(floor(position)) - static_cast<long>(floor(previous));
+        ripples += static_cast<uint64_t>(crossed >= 0 ? crossed : -crossed);
+    }
+
+    // Отсчет регистра шунта: ток с пульсацией по фазе положения, шум, квантование
+    // до шага АЦП 10 бит (сэмплы берутся только при вращении, когда включен быстрый АЦП)
+    int16_t shuntRaw(std::mt19937& rng) const {
+        std::normal_distribution<double> noise(0.0, noise_raw);
+        double ripple = ripple_depth * current_mA * cos(2.0 * M_PI * position);
+        double raw = (current_mA + ripple) * 10.0 + noise(rng);
+        return static_cast<int16_t>(lround(raw / SHUNT_STEP_RAW) * SHUNT_STEP_RAW);
+    }
+};
+
+struct Stage {
+    const char* name;
+    int16_t speed;            // Цифровая скорость (0 - заданное положение)
+    int16_t target_permille;  // Заданное положение
+    double object_position;   // Предмет (< 0 - нет)
+    double ripple_depth;      // Глубина пульсаций
+    uint32_t duration_ms;     // Длительность этапа
+    double max_error;         // Допустимая ошибка положения в конце этапа (пульсации)
+};
+
+int main(int argc, char* argv[]) {
+    uint32_t seed = 1;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--verbose") == 0) {
+            Serial.enabled = true;
+        } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = static_cast<uint32_t>(atoi(argv[++i]));
+        } else {
+            fprintf(stderr, "Usage: %s [--verbose] [--seed N]\n", argv[0]);
+            return 2;
+        }
+    }
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<uint32_t> jitter(0, 60);
+
+    CurrentSensor sensor(0, 0);
+    MotorDriver motor(0, 1);
+    GripperController controller(motor, sensor);
+    sensor.attachMotor(&motor);
+    JawPosition jaw;
+    MotorModel model;
+
+    replay_sensor::bus_voltage_V = static_cast<float>(model.supply_V);
+    sensor.begin();
+    motor.begin();
+    controller.attachJawPosition(&jaw);
+
+    const int16_t open_speed = -GRIPPER_CLOSE_DIRECTION * MOTOR_SPEED_FORWARD;
+    const int16_t close_speed = GRIPPER_CLOSE_DIRECTION * MOTOR_SPEED_FORWARD;
+    const double travel = JAW_TRAVEL_RIPPLES;
+    const Stage stages[] = {
+        {"open, not homed",     open_speed,  0, -1.0,          0.3,  12000, 0.0},
+        {"close to object",     close_speed, 0, 0.7 * travel,  0.3,  12000, 0.02 * travel},
+        {"open to end",         open_speed,  0, 0.7 * travel,  0.3,  12000, 0.0},
+        {"target 50%",          0,         500, -1.0,          0.3,   8000, 0.02 * travel},
+        {"target 90%, no ripple", 0,       900, -1.0,          0.02,  8000, 0.10 * travel},
+        {"close to end",        close_speed, 0, -1.0,          0.3,  12000, 0.0},
+    };
+
+    const uint32_t step_us = 10;
+    uint32_t now_us = 0;
+    uint32_t next_sample_us = 0;
+    uint32_t last_tick_ms = 0;
+    uint64_t sampled_ripples_start = 0;
+    bool failed = false;
+
+    // Пуск: датчик калибрует смещение нуля при неподвижном двигателе
+    for (; now_us < 1000000; now_us += 1000) {
+        replay_clock::now_ms = now_us / 1000;
+        sensor.update();
+        controller.checkCurrentProtection(replay_clock::now_ms);
+    }
+
+    printf("%-22s %8s %8s %8s %8s %8s %7s %8s %s\n", "stage", "true", "estim", "error", "ripples", "counted",
+           "impact", "hit err", "homed");
+    for (const Stage& stage : stages) {
+        model.object_position = stage.object_position;
+        model.ripple_depth = stage.ripple_depth;
+
+        uint32_t stage_start_ms = now_us / 1000;
+        uint32_t total_before, rejected, gaps, samples;
+        jaw.getRippleCounter().getStats(total_before, rejected, gaps, samples);
+        sampled_ripples_start = model.ripples;
+        bool homed_before = jaw.isHomed();
+        int16_t impact_speed = 0;
+        double impact_error = 0.0;
+        bool was_blocked = false;
+
+        if (stage.speed != 0) {
+            controller.setDigitalSpeed(stage.speed, stage_start_ms);
+        } else if (!controller.setPositionTarget(stage.target_permille, stage_start_ms)) {
+            printf("%-22s position target rejected (not homed)\n", stage.name);
+            failed = true;
+        }
+
+        while (now_us / 1000 - stage_start_ms < stage.duration_ms) {
+            int16_t applied = motor.getSpeed();
+            model.step(applied / 255.0, step_us * 1e-6);
+
+            // Скорость в момент удара о край или предмет
+            double limit_close = (model.object_position >= 0.0) ? model.object_position : travel;
+            bool blocked = applied != 0 && ((model.position >= limit_close && applied * GRIPPER_CLOSE_DIRECTION > 0) ||
+                                            (model.position <= 0.0 && applied * GRIPPER_CLOSE_DIRECTION < 0));
+            if (blocked && !was_blocked) {
+                impact_speed = applied;
+                impact_error = jaw.getPosition() - model.position;
+            }
+            was_blocked = blocked;
+
+            // Высокочастотные сэмплы шунта, как sampleRipple() прошивки
+            if (applied != 0 && static_cast<int32_t>(now_us - next_sample_us) >= 0) {
+                jaw.addSample(model.shuntRaw(rng), now_us);
+                next_sample_us = now_us + RIPPLE_SAMPLE_INTERVAL_US + jitter(rng);
+                // Раз в 100 мс цикл занят 5 мс (вывод диагностики)
+                if (now_us % 100000 < RIPPLE_SAMPLE_INTERVAL_US) {
+                    next_sample_us += 5000;
+                }
+            }
+
+            now_us += step_us;
+            if (now_us % 1000 != 0) continue;
+
+            uint32_t now_ms = now_us / 1000;
+            replay_clock::now_ms = now_ms;
+            replay_sensor::current_mA = static_cast<float>(model.current_mA);
+            replay_sensor::power_mW = static_cast<float>(model.current_mA * model.supply_V);
+            sensor.update();
+            motor.update();
+
+            if (now_ms - last_tick_ms >= CONTROL_TICK_INTERVAL_MS) {
+                last_tick_ms = now_ms;
+                controller.digitalHeartbeat(now_ms);
+                controller.checkDigitalTimeout(now_ms);
+                controller.checkCurrentProtection(now_ms);
+                controller.updateJaw(now_ms);
+            }
+        }
+
+        uint32_t total_after;
+        jaw.getRippleCounter().getStats(total_after, rejected, gaps, samples);
+        double error = jaw.getPosition() - model.position;
+        uint64_t true_ripples = model.ripples - sampled_ripples_start;
+
+        // Этапы с упором у края проверяются по переустановке, остальные - по ошибке;
+        // после хоминга ошибка в момент упора не больше 2% хода
+        bool ok = jaw.isHomed() && (!homed_before || fabs(impact_error) <= 0.02 * travel);
+        if (stage.max_error > 0.0) {
+            ok = ok && fabs(error) <= stage.max_error;
+        } else {
+            ok = ok && fabs(error) <= 1.0;
+        }
+        failed = failed || !ok;
+
+        printf("%-22s %8.0f %8ld %8.0f %8llu %8u %7d %8.0f %s%s\n", stage.name, model.position,
+               static_cast<long>(jaw.getPosition()), error, static_cast<unsigned long long>(true_ripples),
+               total_after - total_before, impact_speed, impact_error, jaw.isHomed() ? "yes" : "no", ok ? "" : "  FAIL");
+
+        // Остановка между этапами
+        controller.digitalStop(now_us / 1000);
+    }
+
+    Serial.enabled = true;
+    jaw.printReport();
+    printf(failed ? "FAIL\n" : "OK\n");
+    return failed ? 1 : 0;
+}
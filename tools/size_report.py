@@ -0,0 +1,234 @@
+#!/usr/bin/env python3
+"""Отчет о размере прошивки по модулям и проверка бюджетов flash/RAM.
+
+Подключен в platformio.ini (extra_scripts = post:tools/size_report.py) и
+выполняется после компоновки: разбирает firmware.map, печатает .text/.data/.bss
+каждого модуля (объекты src/ - по файлу, библиотеки - по архиву) и
+останавливает сборку, если превышен бюджет:
+  flash: .text + .data                       <= custom_budget_flash
+  RAM:   .data + .bss + STACK_BUDGET_BYTES   <= custom_budget_ram
+При HEAP_FREE_BUILD (src/Config.h) объекты src/ не должны ссылаться на
+malloc/calloc/realloc, operator new и Arduino String.
+
+Отдельный запуск (по готовому map-файлу):
+  python3 tools/size_report.py firmware.map [--flash N] [--ram N] [--objects DIR] [--nm arm-none-eabi-nm]
+"""
+import argparse
+import os
+import re
+import subprocess
+import sys
+
+# Выходные секции, которые не попадают в прошивку
+SKIPPED_OUTPUT = (".debug", ".comment", ".ARM.attributes", ".stab", "/DISCARD/", ".note", ".gnu")
+# Резерв кучи и стека из скрипта компоновщика - стек учитывается через STACK_BUDGET_BYTES
+RESERVED_OUTPUT = ("._user_heap_stack",)
+DATA_OUTPUT = (".data", ".tdata")
+BSS_OUTPUT = (".bss", ".tbss")
+
+# Символы, запрещенные в src/ при HEAP_FREE_BUILD
+HEAP_SYMBOLS = {"malloc", "calloc", "realloc", "_malloc_r", "_calloc_r", "_realloc_r",
+                "_Znwj", "_Znaj", "_Znwm", "_Znam"}
+STRING_SYMBOL = re.compile(r"^_ZN?K?6String")
+
+OUTPUT_LINE = re.compile(r"^(\.\S+|COMMON)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)")
+INPUT_LINE = re.compile(r"^ (\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$")
+NAME_ONLY = re.compile(r"^ ?(\S+)$")
+CONTINUATION = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)(?:\s+(\S.*))?$")
+
+
+def module_name(path):
+    """Объект src/ - имя файла, член архива - имя архива."""
+    path = path.strip()
+    archive = re.match(r"^(.*?)\((.*)\)$", path)
+    if archive:
+        return os.path.basename(archive.group(1))
+    name = os.path.basename(path)
+    for suffix in (".cpp.o", ".c.o", ".S.o", ".o"):
+        if name.endswith(suffix):
+            return name[:-len(suffix)]
+    return name
+
+
+def section_kind(output):
+    if output.startswith(SKIPPED_OUTPUT) or output.startswith(RESERVED_OUTPUT):
+        return None
+    if output.startswith(DATA_OUTPUT):
+        return "data"
+    if output.startswith(BSS_OUTPUT):
+        return "bss"
+    return "text"
+
+
+def parse_map(text):
+    """Разобрать map-файл GNU ld.
+
+    Возвращает (модули {имя: {text, data, bss}}, итоги {text, data, bss}, float printf подключен).
+    """
+    lines = text.splitlines()
+    start = next((i for i, line in enumerate(lines) if line.startswith("Linker script and memory map")), None)
+    if start is None:
+        raise ValueError("no 'Linker script and memory map' section")
+
+    modules = {}
+    totals = {"text": 0, "data": 0, "bss": 0}
+    output_kind = None
+    pending_output = None
+    pending_input = None
+
+    def add_output(name, address, size):
+        nonlocal output_kind
+        output_kind = section_kind(name)
+        if output_kind is not None and (address != 0 or output_kind != "text"):
+            totals[output_kind] += size
+        elif output_kind == "text":
+            output_kind = None    # Секция без адреса - не загружается
+
+    def add_input(path, size):
+        if output_kind is None or size == 0:
+            return
+        sizes = modules.setdefault(module_name(path), {"text": 0, "data": 0, "bss": 0})
+        sizes[output_kind] += size
+
+    for line in lines[start + 1:]:
+        if pending_output is not None:
+            match = CONTINUATION.match(line)
+            if match:
+                add_output(pending_output, int(match.group(1), 16), int(match.group(2), 16))
+                pending_output = None
+                continue
+            pending_output = None
+        if pending_input is not None:
+            match = CONTINUATION.match(line)
+            pending_input = None
+            if match:
+                if match.group(3):
+                    add_input(match.group(3), int(match.group(2), 16))
+                continue
+
+        if line and not line[0].isspace():
+            match = OUTPUT_LINE.match(line)
+            if match:
+                add_output(match.group(1), int(match.group(2), 16), int(match.group(3), 16))
+            elif NAME_ONLY.match(line) and line.startswith("."):
+                pending_output = line.strip()
+            continue
+
+        match = INPUT_LINE.match(line)
+        if match and not match.group(1).startswith("*"):
+            add_input(match.group(4), int(match.group(3), 16))
+            continue
+        match = NAME_ONLY.match(line)
+        if match and line.startswith(" ") and not line.startswith("  ") and not match.group(1).startswith("*"):
+            pending_input = match.group(1)
+
+    printf_float = re.search(r"\b_printf_float\b", text) is not None
+    return modules, totals, printf_float
+
+
+def config_define(config_path, name):
+    """Значение #define из src/Config.h (None, если нет)."""
+    try:
+        with open(config_path, encoding="utf-8") as config:
+            for line in config:
+                match = re.match(r"^\s*#define\s+%s\s+(\S+)" % name, line)
+                if match:
+                    return match.group(1)
+    except OSError:
+        pass
+    return None
+
+
+def heap_references(objects_dir, nm):
+    """Запрещенные ссылки объектов src/: [(объект, символ)]."""
+    found = []
+    for root, _, files in os.walk(objects_dir):
+        for name in sorted(files):
+            if not name.endswith(".o"):
+                continue
+            path = os.path.join(root, name)
+            result = subprocess.run([nm, "-u", path], capture_output=True, text=True, check=False)
+            for line in result.stdout.splitlines():
+                symbol = line.split()[-1] if line.split() else ""
+                if symbol in HEAP_SYMBOLS or STRING_SYMBOL.match(symbol):
+                    found.append((module_name(path), symbol))
+    return found
+
+
+def report(map_path, budget_flash, budget_ram, stack_budget, heap_free, objects_dir, nm):
+    """Напечатать отчет; вернуть количество нарушений."""
+    with open(map_path, encoding="utf-8", errors="replace") as map_file:
+        modules, totals, printf_float = parse_map(map_file.read())
+
+    print("Size by module (bytes):")
+    print("  %-28s %8s %8s %8s" % ("module", ".text", ".data", ".bss"))
+    for name, sizes in sorted(modules.items(), key=lambda item: -(item[1]["text"] + item[1]["data"] + item[1]["bss"])):
+        print("  %-28s %8d %8d %8d" % (name[:28], sizes["text"], sizes["data"], sizes["bss"]))
+
+    flash = totals["text"] + totals["data"]
+    ram = totals["data"] + totals["bss"] + stack_budget
+    failures = 0
+    print("Total: .text %d, .data %d, .bss %d" % (totals["text"], totals["data"], totals["bss"]))
+    print("float printf: %s" % ("linked" if printf_float else "not linked"))
+
+    if budget_flash:
+        ok = flash <= budget_flash
+        failures += not ok
+        print("Flash: %d / %d B: %s" % (flash, budget_flash, "OK" if ok else "EXCEEDED"))
+    if budget_ram:
+        ok = ram <= budget_ram
+        failures += not ok
+        print("RAM: %d (static) + %d (stack) / %d B: %s" % (ram - stack_budget, stack_budget, budget_ram,
+                                                             "OK" if ok else "EXCEEDED"))
+
+    if heap_free and objects_dir:
+        references = heap_references(objects_dir, nm)
+        for module, symbol in references:
+            print("Heap-free build: %s references %s" % (module, symbol))
+        failures += len(references)
+        if not references:
+            print("Heap-free build: no malloc/new/String references in src/")
+    return failures
+
+
+def option_int(value):
+    return int(str(value), 0) if value not in (None, "") else 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Размер прошивки по модулям и проверка бюджетов")
+    parser.add_argument("map", help="map-файл компоновщика")
+    parser.add_argument("--flash", type=lambda v: int(v, 0), default=0, help="бюджет flash, байт")
+    parser.add_argument("--ram", type=lambda v: int(v, 0), default=0, help="бюджет RAM, байт")
+    parser.add_argument("--config", default=os.path.join("src", "Config.h"), help="путь к Config.h")
+    parser.add_argument("--objects", help="каталог объектов src/ для проверки кучи")
+    parser.add_argument("--nm", default="arm-none-eabi-nm", help="программа nm")
+    args = parser.parse_args()
+
+    stack_budget = option_int(config_define(args.config, "STACK_BUDGET_BYTES"))
+    heap_free = config_define(args.config, "HEAP_FREE_BUILD") == "true"
+    failures = report(args.map, args.flash, args.ram, stack_budget, heap_free, args.objects, args.nm)
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
+else:
+    # Сборка PlatformIO (SCons): проверка после компоновки firmware.elf
+    Import("env")  # noqa: F821 - определено SCons
+
+    def size_report_action(source, target, env):
+        project_dir = env.subst("$PROJECT_DIR")
+        build_dir = env.subst("$BUILD_DIR")
+        config_path = os.path.join(project_dir, "src", "Config.h")
+        cc = env.subst("$CC")
+        nm = os.path.join(os.path.dirname(cc), os.path.basename(cc).replace("gcc", "nm"))
+        failures = report(os.path.join(build_dir, "firmware.map"),
+                          option_int(env.GetProjectOption("custom_budget_flash", "")),
+                          option_int(env.GetProjectOption("custom_budget_ram", "")),
+                          option_int(config_define(config_path, "STACK_BUDGET_BYTES")),
+                          config_define(config_path, "HEAP_FREE_BUILD") == "true",
+                          os.path.join(build_dir, "src"), nm)
+        return 1 if failures else 0
+
+    env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", size_report_action)  # noqa: F821
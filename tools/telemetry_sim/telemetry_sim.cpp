@@ -0,0 +1,292 @@
+// Проверка подписок телеметрии: агрегирование, прореживание и точность частоты
+//
+// Неизмененный Telemetry получает значения с моделью источников: шунт 1 кГц
+// с пропусками и случайным сдвигом, INA219 раз в 50 мс, такт управления 20 мс.
+// Вывод "TM ..." перехватывается и сравнивается с расчетом по тем же значениям:
+//   - окна min/mean/max: начало окна, количество, минимум, среднее, максимум
+//   - прореживание: одна строка на окно, без повторов при медленном источнике
+//   - частота: строк за время прогона против длительность / период
+//   - без подписки и после отписки - ни одной строки
+//   - конец окна по getNextWindowEnd() - вывод без задержки до такта
+//   - фиксированная точка: знак и ведущие нули дробной части
+//
+// Сборка (из корня репозитория):
+//   g++ -O2 -std=gnu++17 -Itools/replay/shim -Isrc -o telemetry_sim tools/telemetry_sim/telemetry_sim.cpp
+//       src/Telemetry.cpp
+// Использование:
+//   ./telemetry_sim               - прогнать проверки (код 1 при ошибке)
+//   ./telemetry_sim --seed 7      - другая последовательность значений и пропусков
+//   ./telemetry_sim --seconds 600 - длительность прогона
+
+#include <Arduino.h>
+#include <random>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "Config.h"
+#include "Telemetry.h"
+
+namespace replay_clock {
+uint32_t now_ms = 0;
+}
+
+ReplaySerial Serial;
+
+// Строка вывода телеметрии и время, когда она появилась
+struct Line {
+    uint32_t printed_ms;
+    std::string channel;
+    std::vector<std::string> fields;   // Поля после имени канала
+};
+
+// Перехват Serial (stderr в shim) во временный файл
+class Capture {
+    FILE* file = tmpfile();
+    long offset = 0;
+public:
+    Capture() {
+        fflush(stderr);
+        dup2(fileno(file), STDERR_FILENO);
+        Serial.enabled = true;
+    }
+
+    // Новые строки "TM" с момента прошлого вызова
+    std::vector<Line> drain(uint32_t now_ms) {
+        std::vector<Line> lines;
+        fflush(stderr);
+        fseek(file, offset, SEEK_SET);
+        char buffer[256];
+        while (fgets(buffer, sizeof(buffer), file) != nullptr) {
+            Line line{now_ms, "", {}};
+            char* token = strtok(buffer, " \n");
+            if (token == nullptr || strcmp(token, "TM") != 0) continue;
+            token = strtok(nullptr, " \n");
+            line.channel = token ? token : "";
+            while ((token = strtok(nullptr, " \n")) != nullptr) {
+                line.fields.push_back(token);
+            }
+            lines.push_back(line);
+        }
+        offset = ftell(file);
+        return lines;
+    }
+};
+
+// Значение в фиксированной точке, как его выводит Telemetry
+std::string fixed(int32_t value, uint8_t decimals) {
+    if (decimals == 0) return std::to_string(value);
+    static const int32_t POW[] = {1, 10, 100, 1000, 10000};
+    uint32_t magnitude = value < 0 ? 0U - static_cast<uint32_t>(value) : static_cast<uint32_t>(value);
+    std::string fraction = std::to_string(magnitude % POW[decimals]);
+    fraction.insert(0, decimals - fraction.size(), '0');
+    return (value < 0 ? "-" : "") + std::to_string(magnitude / POW[decimals]) + "." + fraction;
+}
+
+// Ожидаемое окно агрегирования
+struct Window {
+    uint32_t start_ms;
+    uint32_t count = 0;
+    int32_t min_value = 0, max_value = 0;
+    int64_t sum = 0;
+
+    void add(int32_t value) {
+        if (count == 0 || value < min_value) min_value = value;
+        if (count == 0 || value > max_value) max_value = value;
+        sum += value;
+        count++;
+    }
+
+    int32_t mean() const {
+        int64_t half = count / 2;
+        return static_cast<int32_t>((sum >= 0 ? sum + half : sum - half) / static_cast<int64_t>(count));
+    }
+};
+
+bool failed = false;
+
+void check(bool ok, const char* name, const std::string& detail) {
+    printf("%-28s %s%s\n", name, ok ? "OK" : "FAIL", detail.c_str());
+    failed = failed || !ok;
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t seed = 1;
+    uint32_t seconds = 120;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = static_cast<uint32_t>(atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = static_cast<uint32_t>(atoi(argv[++i]));
+        } else {
+            fprintf(stderr, "Usage: %s [--seed N] [--seconds N]\n", argv[0]);
+            return 2;
+        }
+    }
+    std::mt19937 rng(seed);
+    Capture capture;
+    const uint32_t duration_ms = seconds * 1000;
+
+    // 1. Без подписки: публикация ничего не выводит
+    {
+        Telemetry telemetry;
+        for (uint32_t t = 0; t < 10000; t++) {
+            telemetry.publish(Telemetry::CH_CURRENT, static_cast<int32_t>(rng()), t);
+            telemetry.update(t);
+        }
+        size_t lines = capture.drain(10000).size();
+        check(lines == 0 && telemetry.getLinesSent() == 0, "unsubscribed", ", lines " + std::to_string(lines));
+    }
+
+    // 2. Окна min/mean/max: шунт ~1 кГц с пропусками 5% и сдвигом, период 10 мс, подписка не на сетке 1 мс
+    {
+        Telemetry telemetry;
+        const uint16_t period = 10;
+        const uint32_t start = 1003;
+        telemetry.subscribe(Telemetry::CH_SHUNT, period, Telemetry::MODE_AGGREGATE, start);
+        std::vector<Window> expected;
+        std::vector<Line> lines;
+        for (uint32_t t = start; t < start + duration_ms; t++) {
+            if (rng() % 20 != 0) {
+                int32_t value = static_cast<int32_t>(rng() % 20001) - 10000;
+                uint32_t window = start + (t - start) / period * period;
+                if (expected.empty() || expected.back().start_ms != window) {
+                    expected.push_back(Window{window});
+                }
+                expected.back().add(value);
+                telemetry.publish(Telemetry::CH_SHUNT, value, t);
+            }
+            telemetry.update(t);
+            for (const Line& line : capture.drain(t)) lines.push_back(line);
+        }
+        // Последнее окно не закрыто
+        expected.pop_back();
+        uint32_t mismatches = 0;
+        for (size_t i = 0; i < min(lines.size(), expected.size()); i++) {
+            const Window& w = expected[i];
+            const std::vector<std::string>& f = lines[i].fields;
+            bool same = lines[i].channel == "shunt" && f.size() == 5 && f[0] == std::to_string(w.start_ms) &&
+                        f[1] == std::to_string(w.count) && f[2] == fixed(w.min_value, 1) &&
+                        f[3] == fixed(w.mean(), 1) && f[4] == fixed(w.max_value, 1);
+            mismatches += !same;
+        }
+        check(lines.size() == expected.size() && mismatches == 0, "aggregate min/mean/max",
+              ", windows " + std::to_string(lines.size()) + "/" + std::to_string(expected.size()) +
+              ", mismatches " + std::to_string(mismatches));
+    }
+
+    // 3. Прореживание 7 мс из 1 кГц: частота и интервалы
+    {
+        Telemetry telemetry;
+        const uint16_t period = 7;
+        telemetry.subscribe(Telemetry::CH_LOOP, period, Telemetry::MODE_FIRST, 0);
+        std::vector<Line> lines;
+        for (uint32_t t = 0; t < duration_ms; t++) {
+            telemetry.publish(Telemetry::CH_LOOP, static_cast<int32_t>(t), t);
+            telemetry.update(t);
+            for (const Line& line : capture.drain(t)) lines.push_back(line);
+        }
+        uint32_t bad_intervals = 0;
+        for (size_t i = 1; i < lines.size(); i++) {
+            uint32_t interval = std::stoul(lines[i].fields[0]) - std::stoul(lines[i - 1].fields[0]);
+            bad_intervals += interval != period;
+        }
+        size_t expected = (duration_ms + period - 1) / period;
+        double rate_error_ppm = (static_cast<double>(lines.size()) - expected) / expected * 1e6;
+        char detail[96];
+        snprintf(detail, sizeof(detail), ", %zu lines, expected %zu (%.0f ppm), bad intervals %u", lines.size(),
+                 expected, rate_error_ppm, bad_intervals);
+        check(lines.size() == expected && bad_intervals == 0, "decimate 1 kHz -> 7 ms", detail);
+    }
+
+    // 4. Медленный источник: INA219 раз в 50 мс, прореживание 20 мс - каждое значение один раз,
+    //    агрегирование 100 мс - по 2 значения в окне
+    {
+        Telemetry telemetry;
+        telemetry.subscribe(Telemetry::CH_CURRENT, 20, Telemetry::MODE_FIRST, 0);
+        telemetry.subscribe(Telemetry::CH_VOLTAGE, 100, Telemetry::MODE_AGGREGATE, 0);
+        uint32_t samples = 0, current_lines = 0, voltage_lines = 0, bad_counts = 0;
+        for (uint32_t t = 0; t < duration_ms; t++) {
+            if (t % CURRENT_MEASUREMENT_INTERVAL == 0) {
+                telemetry.publish(Telemetry::CH_CURRENT, static_cast<int32_t>(t), t);
+                telemetry.publish(Telemetry::CH_VOLTAGE, 12000, t);
+                samples++;
+            }
+            telemetry.update(t);
+            for (const Line& line : capture.drain(t)) {
+                if (line.channel == "current") current_lines++;
+                if (line.channel == "voltage") {
+                    voltage_lines++;
+                    bad_counts += line.fields[1] != "2" || line.fields[3] != "12.000";
+                }
+            }
+        }
+        check(current_lines == samples, "slow source, decimate",
+              ", lines " + std::to_string(current_lines) + ", samples " + std::to_string(samples));
+        check(voltage_lines == duration_ms / 100 - 1 && bad_counts == 0, "slow source, aggregate",
+              ", windows " + std::to_string(voltage_lines) + ", bad " + std::to_string(bad_counts));
+    }
+
+    // 5. Период 0 - каждое значение; отписка останавливает вывод
+    {
+        Telemetry telemetry;
+        telemetry.subscribe(Telemetry::CH_SPEED, 0, Telemetry::MODE_FIRST, 0);
+        bool agg_rejected = !telemetry.subscribe(Telemetry::CH_STATE, 0, Telemetry::MODE_AGGREGATE, 0);
+        for (uint32_t t = 0; t < 1000; t++) telemetry.publish(Telemetry::CH_SPEED, 1, t);
+        size_t every = capture.drain(1000).size();
+        telemetry.unsubscribe(Telemetry::CH_SPEED);
+        for (uint32_t t = 1000; t < 2000; t++) {
+            telemetry.publish(Telemetry::CH_SPEED, 1, t);
+            telemetry.update(t);
+        }
+        size_t after = capture.drain(2000).size();
+        check(every == 1000 && after == 0 && agg_rejected && !telemetry.isAnyActive(), "every value, unsubscribe",
+              ", lines " + std::to_string(every) + " then " + std::to_string(after));
+    }
+
+    // 6. Цикл со сном: проснуться к следующему значению или к концу окна (getNextWindowEnd)
+    {
+        Telemetry telemetry;
+        const uint16_t period = 30;
+        telemetry.subscribe(Telemetry::CH_POWER, period, Telemetry::MODE_AGGREGATE, 0);
+        uint32_t now = 0, windows = 0, max_delay = 0;
+        while (now < duration_ms) {
+            if (now % CURRENT_MEASUREMENT_INTERVAL == 0) {
+                telemetry.publish(Telemetry::CH_POWER, 5, now);
+            }
+            telemetry.update(now);
+            for (const Line& line : capture.drain(now)) {
+                uint32_t window_end = std::stoul(line.fields[0]) + period;
+                max_delay = max(max_delay, line.printed_ms - window_end);
+                windows++;
+            }
+            uint32_t deadline = (now / CURRENT_MEASUREMENT_INTERVAL + 1) * CURRENT_MEASUREMENT_INTERVAL;
+            uint32_t window_end;
+            if (telemetry.getNextWindowEnd(now, window_end) && window_end < deadline) {
+                deadline = window_end;
+            }
+            now = deadline;
+        }
+        check(max_delay == 0 && windows > 0, "window end wake-up",
+              ", windows " + std::to_string(windows) + ", max delay " + std::to_string(max_delay) + " ms");
+    }
+
+    // 7. Фиксированная точка: отрицательные значения и ведущие нули
+    {
+        Telemetry telemetry;
+        telemetry.subscribe(Telemetry::CH_VOLTAGE, 0, Telemetry::MODE_FIRST, 0);
+        const int32_t values[] = {5, -5, -1234, 12050, 0, -100000};
+        bool ok = true;
+        std::string detail;
+        for (int32_t value : values) {
+            telemetry.publish(Telemetry::CH_VOLTAGE, value, 0);
+            std::vector<Line> lines = capture.drain(0);
+            bool same = lines.size() == 1 && lines[0].fields[1] == fixed(value, 3);
+            if (!same) detail += " " + std::to_string(value);
+            ok = ok && same;
+        }
+        check(ok, "fixed point", detail);
+    }
+
+    printf(failed ? "FAIL\n" : "OK\n");
+    return failed ? 1 : 0;
+}